@@ -27,6 +27,10 @@ option(MIKO_BUILD_TESTS "Build test suite" OFF)
 option(MIKO_BUILD_DOCS "Build documentation" OFF)
 option(MIKO_ENABLE_LOGGING "Enable logging system" ON)
 option(MIKO_ENABLE_DEBUG_FEATURES "Enable debug features" OFF)
+option(MIKO_BUILD_TOOLS "Build developer tools (invoke host / load driver)" OFF)
+
+# Build only the CEF-free invoke core (and tools); no SDL2, CEF or display needed
+option(MIKO_CORE_ONLY "Build only the invoke core" OFF)
 
 # Framework options
 option(MIKO_STATIC_FRAMEWORK "Build framework as static library" ON)
@@ -48,7 +52,7 @@ endif()
 # =============================================================================
 
 # Set C++ standard
-set(CMAKE_CXX_STANDARD 17)
+set(CMAKE_CXX_STANDARD 20)
 set(CMAKE_CXX_STANDARD_REQUIRED ON)
 set(CMAKE_CXX_EXTENSIONS OFF)
 
@@ -171,6 +175,8 @@ function(print_configuration_summary)
     message(STATUS "Examples: ${MIKO_BUILD_EXAMPLES}")
     message(STATUS "Tests: ${MIKO_BUILD_TESTS}")
     message(STATUS "Documentation: ${MIKO_BUILD_DOCS}")
+    message(STATUS "Tools: ${MIKO_BUILD_TOOLS}")
+    message(STATUS "Core Only: ${MIKO_CORE_ONLY}")
     message(STATUS "Logging: ${MIKO_ENABLE_LOGGING}")
     message(STATUS "Debug Features: ${MIKO_ENABLE_DEBUG_FEATURES}")
     message(STATUS "Static Framework: ${MIKO_STATIC_FRAMEWORK}")
@@ -28,6 +28,38 @@ function(setup_sdl2)
     message(STATUS "SDL2 setup complete")
 endfunction()
 
+# =============================================================================
+# jsoncpp Configuration
+# =============================================================================
+function(setup_jsoncpp)
+    message(STATUS "Setting up jsoncpp...")
+    
+    # Prefer an installed jsoncpp; build it from source otherwise
+    find_package(jsoncpp CONFIG QUIET)
+    if(TARGET JsonCpp::JsonCpp)
+        message(STATUS "Using installed jsoncpp ${jsoncpp_VERSION}")
+        return()
+    endif()
+    
+    FetchContent_Declare(
+        jsoncpp
+        GIT_REPOSITORY https://github.com/open-source-parsers/jsoncpp.git
+        GIT_TAG 1.9.5
+        GIT_SHALLOW TRUE
+    )
+    
+    set(JSONCPP_WITH_TESTS OFF CACHE BOOL "Build jsoncpp tests")
+    set(JSONCPP_WITH_POST_BUILD_UNITTEST OFF CACHE BOOL "Run jsoncpp unit tests after build")
+    set(JSONCPP_WITH_PKGCONFIG_SUPPORT OFF CACHE BOOL "Generate jsoncpp pkg-config file")
+    set(JSONCPP_WITH_CMAKE_PACKAGE OFF CACHE BOOL "Generate jsoncpp CMake package")
+    set(BUILD_OBJECT_LIBS OFF CACHE BOOL "Build jsoncpp object library")
+    
+    FetchContent_MakeAvailable(jsoncpp)
+    add_library(JsonCpp::JsonCpp ALIAS jsoncpp_static)
+    
+    message(STATUS "jsoncpp setup complete")
+endfunction()
+
 # =============================================================================
 # CEF (Chromium Embedded Framework) Configuration
 # =============================================================================
@@ -165,9 +197,18 @@ endfunction()
 # =============================================================================
 # Main Setup Function
 # =============================================================================
+# Dependencies of the invoke core only (MIKO_CORE_ONLY)
+function(setup_core_dependencies)
+    setup_jsoncpp()
+    find_package(Threads REQUIRED)
+endfunction()
+
 function(setup_all_dependencies)
     message(STATUS "Setting up all dependencies...")
     
+    # Setup the invoke core's dependencies
+    setup_core_dependencies()
+    
     # Setup SDL2
     setup_sdl2()
     
@@ -8,7 +8,7 @@
 # Set common library target properties
 macro(SET_LIBRARY_TARGET_PROPERTIES target)
     set_target_properties(${target} PROPERTIES
-        CXX_STANDARD 17
+        CXX_STANDARD 20
         CXX_STANDARD_REQUIRED ON
         CXX_EXTENSIONS OFF
     )
@@ -24,7 +24,7 @@ endmacro()
 # Set common executable target properties
 macro(SET_EXECUTABLE_TARGET_PROPERTIES target)
     set_target_properties(${target} PROPERTIES
-        CXX_STANDARD 17
+        CXX_STANDARD 20
         CXX_STANDARD_REQUIRED ON
         CXX_EXTENSIONS OFF
     )
@@ -253,6 +253,50 @@ endfunction()
 # Framework Setup Utilities
 # =============================================================================
 
+# Setup the invoke core: request types, dispatcher, executor, file system
+# handlers and the non-CEF transports. Has no CEF dependency, so handlers can
+# be load-tested headlessly.
+function(setup_mikoview_invoke_core)
+    set(INVOKE_CORE_SOURCES
+        mikoview/logger.cpp
+        mikoview/jsapi/arena.cpp
+        mikoview/jsapi/request.cpp
+        mikoview/jsapi/recorder.cpp
+        mikoview/jsapi/dispatcher.cpp
+        mikoview/jsapi/async.cpp
+        mikoview/jsapi/binding.cpp
+        mikoview/jsapi/typed.cpp
+        mikoview/jsapi/jsonwriter.cpp
+        mikoview/jsapi/executor.cpp
+        mikoview/jsapi/timerwheel.cpp
+        mikoview/jsapi/stream.cpp
+        mikoview/jsapi/events.cpp
+        mikoview/jsapi/cancellation.cpp
+        mikoview/jsapi/metrics.cpp
+        mikoview/jsapi/fileio.cpp
+        mikoview/jsapi/filesystem.cpp
+        mikoview/jsapi/loopback.cpp
+    )
+    
+    if(NOT WIN32)
+        list(APPEND INVOKE_CORE_SOURCES mikoview/jsapi/unixsocket.cpp)
+    endif()
+    
+    add_library(mikoview_invoke_core STATIC ${INVOKE_CORE_SOURCES})
+    
+    SET_LIBRARY_TARGET_PROPERTIES(mikoview_invoke_core)
+    set_platform_compiler_flags(mikoview_invoke_core)
+    
+    target_include_directories(mikoview_invoke_core PUBLIC
+        ${CMAKE_CURRENT_SOURCE_DIR}
+    )
+    
+    target_link_libraries(mikoview_invoke_core PUBLIC
+        JsonCpp::JsonCpp
+        Threads::Threads
+    )
+endfunction()
+
 # Setup MikoView framework target
 function(setup_mikoview_framework)
     # Generate configuration files first
@@ -266,9 +310,11 @@ function(setup_mikoview_framework)
         mikoview.cpp
         mikoview/mikoapp.cpp
         mikoview/mikoclient.cpp
-        mikoview/logger.cpp
+        mikoview/mikopump.cpp
+        mikoview/mikotask.cpp
         mikoview/jsapi/invoke.cpp
-        mikoview/jsapi/filesystem.cpp
+        mikoview/jsapi/ipc.cpp
+        mikoview/jsapi/script.cpp
         ${CMAKE_CURRENT_BINARY_DIR}/generated/mikoview/app_config.cpp
         ${PLATFORM_SOURCES}
     )
@@ -293,6 +339,7 @@ function(setup_mikoview_framework)
     
     # Link framework libraries
     target_link_libraries(mikoview_framework PUBLIC
+        mikoview_invoke_core
         SDL2::SDL2
         libcef_lib
         libcef_dll_wrapper
@@ -25,15 +25,20 @@
 #include "include/cef_app.h"
 #include "include/cef_browser.h"
 #include "include/wrapper/cef_helpers.h"
+#include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <functional>
 #include <chrono>
+#include <limits>
 
 // Local includes
 #include "app_config.hpp"
 #include <mikoview/logger.hpp>
 #include <mikoview/mikoclient.hpp>
 #include <mikoview/mikoapp.hpp>
+#include <mikoview/mikopump.hpp>
+#include <mikoview/mikotask.hpp>
 #include <mikoview/gui/platform_gui.hpp>
 
 // Global variables
@@ -42,6 +47,7 @@ SDL_Window* g_sdl_window = nullptr;
 PlatformGUI::WindowHandle g_native_handle;
 bool g_running = true;
 bool g_window_shown = false;
+LoopStats g_loop_stats;
 
 // Function to show the window when content is ready
 void ShowWindowWhenReady() {
@@ -53,40 +59,52 @@ void ShowWindowWhenReady() {
     }
 }
 
-// Handle SDL events
-void HandleSDLEvents() {
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_QUIT:
-                g_running = false;
-                if (g_client) {
-                    g_client->CloseAllBrowsers(false);
-                }
-                break;
-                
-            case SDL_WINDOWEVENT:
-                if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
-                    if (g_client && g_client->HasBrowsers()) {
-                        CefRefPtr<CefBrowser> browser = g_client->GetFirstBrowser();
-                        if (browser) {
+// Handle a single SDL event
+void HandleSDLEvent(const SDL_Event& event) {
+    g_loop_stats.OnEvent(event);
+
+    if (MessagePump::GetInstance()->IsWakeEvent(event)) {
+        MessagePump::GetInstance()->OnWakeEvent();
+        return;
+    }
+
+    switch (event.type) {
+        case SDL_QUIT:
+            g_running = false;
+            if (g_client) {
+                g_client->CloseAllBrowsers(false);
+            }
+            break;
+            
+        case SDL_WINDOWEVENT:
+            if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
+                if (g_client && g_client->HasBrowsers()) {
+                    CefRefPtr<CefBrowser> browser = g_client->GetFirstBrowser();
+                    if (browser) {
 #ifdef _WIN32
-                            HWND cef_hwnd = browser->GetHost()->GetWindowHandle();
-                            if (cef_hwnd) {
-                                int width = event.window.data1;
-                                int height = event.window.data2;
-                                SetWindowPos(cef_hwnd, nullptr, 0, 0, width, height,
-                                           SWP_NOZORDER | SWP_NOACTIVATE);
-                            }
+                        HWND cef_hwnd = browser->GetHost()->GetWindowHandle();
+                        if (cef_hwnd) {
+                            int width = event.window.data1;
+                            int height = event.window.data2;
+                            SetWindowPos(cef_hwnd, nullptr, 0, 0, width, height,
+                                       SWP_NOZORDER | SWP_NOACTIVATE);
+                        }
 #elif defined(__linux__)
-                            // On Linux, CEF handles window resizing automatically with X11
-                            // The browser will resize with the parent window
+                        // On Linux, CEF handles window resizing automatically with X11
+                        // The browser will resize with the parent window
 #endif
-                        }
                     }
                 }
-                break;
-        }
+            }
+            break;
+    }
+}
+
+// Drain pending SDL events
+void HandleSDLEvents() {
+    SDL_Event event;
+    while (SDL_PollEvent(&event)) {
+        HandleSDLEvent(event);
     }
 }
 
@@ -109,12 +127,25 @@ int main(int argc, char* argv[]) {
     CefMainArgs main_args(argc, argv);
 #endif
 
+    // The renderer sub-process needs SimpleApp for its CefRenderProcessHandler
+    CefRefPtr<SimpleApp> app(new SimpleApp);
+
     // CEF sub-process check
-    int exit_code = CefExecuteProcess(main_args, nullptr, sandbox_info);
+    int exit_code = CefExecuteProcess(main_args, app.get(), sandbox_info);
     if (exit_code >= 0) {
         return exit_code;
     }
 
+    // Wakeup event for the external message pump (must exist before CefInitialize)
+    MessagePump* pump = MessagePump::GetInstance();
+    if (!pump->Initialize()) {
+        SDL_Quit();
+        return 1;
+    }
+
+    // Set MIKO_MEASURE_LOOP=1 to log wakeups/sec and loop latency
+    g_loop_stats.SetEnabled(std::getenv("MIKO_MEASURE_LOOP") != nullptr);
+
     // Initialize platform-specific dark mode support
     PlatformGUI::InitializeDarkMode();
 
@@ -158,6 +189,7 @@ int main(int argc, char* argv[]) {
     CefSettings settings;
     settings.no_sandbox = true;
     settings.multi_threaded_message_loop = false;
+    settings.external_message_pump = true;  // SimpleApp::OnScheduleMessagePumpWork drives CEF
     settings.background_color = 0xFFFFFFFF; // White background for faster rendering
 
     if (AppConfig::IsDebugMode()) {
@@ -167,7 +199,6 @@ int main(int argc, char* argv[]) {
         settings.log_severity = LOGSEVERITY_WARNING;
     }
 
-    CefRefPtr<SimpleApp> app(new SimpleApp);
     CefInitialize(main_args, settings, app.get(), sandbox_info);
 
     // Create CEF browser
@@ -218,10 +249,30 @@ int main(int argc, char* argv[]) {
     auto start_time = std::chrono::steady_clock::now();
     const auto timeout_duration = std::chrono::seconds(10);
 
-    // Main loop
+    // Main loop: block until SDL has an event, CEF asked for work, or the show timeout expires
     while (g_running) {
-        HandleSDLEvents();
-        CefDoMessageLoopWork();
+        int max_wait_ms = (std::numeric_limits<int>::max)();
+        if (!g_window_shown) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                start_time + timeout_duration - std::chrono::steady_clock::now()).count();
+            max_wait_ms = static_cast<int>((std::max<long long>)(remaining, 0));
+        }
+
+        SDL_Event event;
+        bool has_event = SDL_WaitEventTimeout(&event, pump->GetWaitTimeout(max_wait_ms)) != 0;
+        g_loop_stats.BeginIteration();
+
+        if (has_event) {
+            HandleSDLEvent(event);
+            HandleSDLEvents();
+        }
+
+        if (pump->DoWorkIfDue()) {
+            g_loop_stats.OnPumpWork(pump->GetLastWorkLatenessMs());
+        }
+
+        // Work handed over by SimpleClient callbacks (title, ready, close)
+        UITaskQueue::GetInstance()->RunPendingTasks(&g_loop_stats);
         
         // Timeout fallback
         if (!g_window_shown) {
@@ -231,11 +282,15 @@ int main(int argc, char* argv[]) {
                 ShowWindowWhenReady();
             }
         }
-        
-        SDL_Delay(1); // Small delay to prevent 100% CPU usage
+
+        g_loop_stats.EndIteration();
     }
 
-    // Cleanup
+    // Cleanup: SDL_QUIT only started the close; CefShutdown needs it finished
+    g_client->CloseAllBrowsers(true);
+    if (!g_client->WaitForAllBrowsersClosed(5000)) {
+        Logger::LogMessage("Browsers still open at shutdown");
+    }
     CefShutdown();
     SDL_DestroyWindow(g_sdl_window);
     SDL_Quit();
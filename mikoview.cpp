@@ -23,14 +23,28 @@
 #include "cef_app.h"
 #include "cef_browser.h"
 #include "wrapper/cef_helpers.h"
+#include "mikoview/mikopump.hpp"
+#include "mikoview/mikotask.hpp"
+#include "mikoview/jsapi/executor.hpp"
+#include "mikoview/jsapi/invoke.hpp"
+#include "mikoview/jsapi/metrics.hpp"
+#include "mikoview/jsapi/script.hpp"
 
 // Standard includes
+#include <algorithm>
 #include <filesystem>
+#include <limits>
 #include <chrono>
 #include <iostream>
 
 namespace MikoView {
     
+    // Browser host for the JS namespace; set while the application runs
+    static CefRefPtr<SimpleClient> g_script_client;
+    
+    // How long Shutdown waits for browsers to close before CefShutdown
+    constexpr int kBrowserCloseTimeoutMs = 5000;
+    
     // Internal implementation class
     class Application::Impl {
     public:
@@ -46,41 +60,54 @@ namespace MikoView {
         std::function<void()> ready_callback;
         std::function<void()> close_callback;
         
+        LoopStats loop_stats;
+        
         void HandleSDLEvents(Application* app_instance) {
             SDL_Event event;
             while (SDL_PollEvent(&event)) {
-                switch (event.type) {
-                    case SDL_QUIT:
-                        running = false;
-                        if (client) {
-                            client->CloseAllBrowsers(false);
-                        }
-                        if (app_instance && close_callback) {
-                            close_callback();
-                        }
-                        break;
-                        
-                    case SDL_WINDOWEVENT:
-                        if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
-                            if (client && client->HasBrowsers()) {
-                                CefRefPtr<CefBrowser> browser = client->GetFirstBrowser();
-                                if (browser) {
+                HandleSDLEvent(app_instance, event);
+            }
+        }
+        
+        void HandleSDLEvent(Application* app_instance, const SDL_Event& event) {
+            loop_stats.OnEvent(event);
+            
+            if (MessagePump::GetInstance()->IsWakeEvent(event)) {
+                MessagePump::GetInstance()->OnWakeEvent();
+                return;
+            }
+            
+            switch (event.type) {
+                case SDL_QUIT:
+                    running = false;
+                    if (client) {
+                        client->CloseAllBrowsers(false);
+                    }
+                    if (app_instance && close_callback) {
+                        close_callback();
+                    }
+                    break;
+                    
+                case SDL_WINDOWEVENT:
+                    if (event.window.event == SDL_WINDOWEVENT_RESIZED) {
+                        if (client && client->HasBrowsers()) {
+                            CefRefPtr<CefBrowser> browser = client->GetFirstBrowser();
+                            if (browser) {
 #ifdef _WIN32
-                                    HWND cef_hwnd = browser->GetHost()->GetWindowHandle();
-                                    if (cef_hwnd) {
-                                        int width = event.window.data1;
-                                        int height = event.window.data2;
-                                        SetWindowPos(cef_hwnd, nullptr, 0, 0, width, height,
-                                                   SWP_NOZORDER | SWP_NOACTIVATE);
-                                    }
+                                HWND cef_hwnd = browser->GetHost()->GetWindowHandle();
+                                if (cef_hwnd) {
+                                    int width = event.window.data1;
+                                    int height = event.window.data2;
+                                    SetWindowPos(cef_hwnd, nullptr, 0, 0, width, height,
+                                               SWP_NOZORDER | SWP_NOACTIVATE);
+                                }
 #elif defined(__linux__)
-                                    // On Linux, CEF handles window resizing automatically with X11
+                                // On Linux, CEF handles window resizing automatically with X11
 #endif
-                                }
                             }
                         }
-                        break;
-                }
+                    }
+                    break;
             }
         }
         
@@ -124,6 +151,46 @@ namespace MikoView {
             return false;
         }
         
+#ifdef __APPLE__
+        if (config_.multi_threaded_message_loop) {
+            Utils::LogWarning("multi_threaded_message_loop is not supported on macOS");
+            config_.multi_threaded_message_loop = false;
+        }
+#endif
+        if (config_.multi_threaded_message_loop) {
+            // CEF pumps its own UI thread; nothing to schedule from SDL
+            config_.external_message_pump = false;
+        }
+        
+        // Wakeup event for the message pump and UI task queue (must exist before CefInitialize)
+        if (!MessagePump::GetInstance()->Initialize()) {
+            Utils::LogWarning("Falling back to single-threaded polling message loop");
+            config_.multi_threaded_message_loop = false;
+            config_.external_message_pump = false;
+        }
+        MessagePump::GetInstance()->SetMaxIdleMs(config_.message_pump_max_idle_ms);
+        impl_->loop_stats.SetEnabled(config_.measure_main_loop);
+        
+        // Worker pools start lazily on the first non-UI invoke
+        MikoView::JSAPI::ExecutorConfig executor_config;
+        executor_config.cpu_threads = config_.executor_cpu_threads;
+        executor_config.io_threads = config_.executor_io_threads;
+        executor_config.io_queue_limit = static_cast<size_t>((std::max)(1, config_.executor_io_queue_limit));
+        MikoView::JSAPI::Executor::GetInstance()->Configure(executor_config);
+        MikoView::JSAPI::InvokeHandler::GetInstance()->SetMaxInFlightPerFrame(
+            static_cast<size_t>((std::max)(0, config_.invoke_max_inflight_per_frame)));
+        if (!config_.metrics_dump_path.empty()) {
+            MikoView::JSAPI::Metrics::GetInstance()->StartPeriodicDump(
+                config_.metrics_dump_path, config_.metrics_dump_interval_ms);
+        }
+        if (!config_.invoke_record_path.empty()) {
+            std::string error;
+            const uint64_t max_bytes = static_cast<uint64_t>((std::max)(0, config_.invoke_record_max_mb)) << 20;
+            if (!MikoView::JSAPI::InvokeHandler::GetInstance()->StartRecording(config_.invoke_record_path, max_bytes, &error)) {
+                Utils::LogError("Invoke recording not started: " + error);
+            }
+        }
+        
         // Initialize platform-specific dark mode support
         GUI::InitializeDarkMode();
         
@@ -180,7 +247,8 @@ namespace MikoView {
         
         CefSettings settings;
         settings.no_sandbox = true;
-        settings.multi_threaded_message_loop = false;
+        settings.multi_threaded_message_loop = config_.multi_threaded_message_loop;
+        settings.external_message_pump = config_.external_message_pump;
         settings.background_color = 0xFFFFFFFF;
         
         if (config_.debug_mode) {
@@ -215,8 +283,9 @@ namespace MikoView {
         browser_settings.local_storage = STATE_ENABLED;
         
         impl_->client = new SimpleClient();
+        g_script_client = impl_->client;
         
-        // Set callback to show window when content is ready
+        // Set callback to show window when content is ready (runs on the SDL thread)
         impl_->client->SetReadyCallback([this]() {
             impl_->ShowWindowWhenReady();
         });
@@ -234,6 +303,8 @@ namespace MikoView {
         Utils::LogInfo("Mode: " + std::string(config_.debug_mode ? "DEBUG" : "RELEASE"));
         Utils::LogInfo("Platform: " + GetPlatformName());
         Utils::LogInfo("URL: " + config_.startup_url);
+        Utils::LogInfo("Message loop: " + std::string(config_.multi_threaded_message_loop ? "multi-threaded" :
+                                                      config_.external_message_pump ? "external pump" : "polling"));
         if (config_.start_hidden) {
             Utils::LogInfo("🔄 Window hidden until content loads...");
         }
@@ -252,11 +323,42 @@ namespace MikoView {
         }
         
         const auto timeout_duration = std::chrono::seconds(config_.show_timeout_seconds);
+        MessagePump* pump = MessagePump::GetInstance();
         
         // Main loop
         while (impl_->running && state_ == State::Running) {
-            impl_->HandleSDLEvents(this);
-            CefDoMessageLoopWork();
+            if (config_.external_message_pump || config_.multi_threaded_message_loop) {
+                // Sleep until SDL has an event, CEF or a UI task needs us, or the show timeout expires
+                int max_wait_ms = (std::numeric_limits<int>::max)();
+                if (config_.start_hidden && !impl_->window_shown) {
+                    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        impl_->start_time + timeout_duration - std::chrono::steady_clock::now()).count();
+                    max_wait_ms = static_cast<int>((std::max<long long>)(remaining, 0));
+                }
+                
+                // In multi-threaded mode CEF runs on its own thread and only
+                // reaches us through UITaskQueue
+                int wait_ms = config_.external_message_pump ? pump->GetWaitTimeout(max_wait_ms) : max_wait_ms;
+                
+                SDL_Event event;
+                bool has_event = SDL_WaitEventTimeout(&event, wait_ms) != 0;
+                impl_->loop_stats.BeginIteration();
+                
+                if (has_event) {
+                    impl_->HandleSDLEvent(this, event);
+                    impl_->HandleSDLEvents(this);
+                }
+                
+                if (config_.external_message_pump && pump->DoWorkIfDue()) {
+                    impl_->loop_stats.OnPumpWork(pump->GetLastWorkLatenessMs());
+                }
+            } else {
+                impl_->loop_stats.BeginIteration();
+                impl_->HandleSDLEvents(this);
+                CefDoMessageLoopWork();
+            }
+            
+            UITaskQueue::GetInstance()->RunPendingTasks(&impl_->loop_stats);
             
             // Timeout fallback for showing window
             if (config_.start_hidden && !impl_->window_shown) {
@@ -267,7 +369,11 @@ namespace MikoView {
                 }
             }
             
-            SDL_Delay(1); // Small delay to prevent 100% CPU usage
+            impl_->loop_stats.EndIteration();
+            
+            if (!config_.external_message_pump && !config_.multi_threaded_message_loop) {
+                SDL_Delay(1); // Small delay to prevent 100% CPU usage
+            }
         }
         
         return 0;
@@ -280,9 +386,21 @@ namespace MikoView {
         
         state_ = State::Shutting_Down;
         
+        // CloseAllBrowsers only posts to CEF's UI thread in multi-threaded
+        // mode; every browser must be gone before CefShutdown
         if (impl_->client) {
             impl_->client->CloseAllBrowsers(true);
+            if (!impl_->client->WaitForAllBrowsersClosed(kBrowserCloseTimeoutMs)) {
+                Utils::LogWarning("Browsers still open at shutdown");
+            }
         }
+        g_script_client = nullptr;
+        
+        // Last metrics snapshot, then finish in-flight handlers before CEF
+        // stops accepting tasks
+        MikoView::JSAPI::Metrics::GetInstance()->StopPeriodicDump();
+        MikoView::JSAPI::Executor::GetInstance()->Shutdown();
+        MikoView::JSAPI::InvokeHandler::GetInstance()->StopRecording();
         
         CefShutdown();
         
@@ -478,12 +596,34 @@ namespace MikoView {
             // Implementation depends on the specific JSApi design
         }
         
-        void ExecuteScript(const std::string& script) {
-            // Implementation would execute JavaScript in the main frame
+        void ExecuteScript(const std::string& script, JSAPI::InvokeCallback callback) {
+            ExecuteScriptInFrame(script, "", std::move(callback));
         }
         
-        void ExecuteScriptInFrame(const std::string& script, const std::string& frame_name) {
-            // Implementation would execute JavaScript in a specific frame
+        void ExecuteScriptInFrame(const std::string& script, const std::string& frame_id,
+                                  JSAPI::InvokeCallback callback) {
+            // Browsers are looked up on the UI thread
+            JSAPI::Executor::PostToUI([script, frame_id, callback]() {
+                CefRefPtr<CefBrowser> browser = g_script_client && g_script_client->HasBrowsers()
+                    ? g_script_client->GetFirstBrowser() : nullptr;
+                if (!browser) {
+                    if (callback) {
+                        callback("No browser", false);
+                    }
+                    return;
+                }
+                if (frame_id.empty()) {
+                    JSAPI::ScriptService::GetInstance()->Execute(browser, std::string(), script, callback);
+                    return;
+                }
+                
+                // Frame identifier, or failing that the frame's name
+                CefRefPtr<CefFrame> frame = browser->GetFrameByIdentifier(frame_id);
+                if (!frame) {
+                    frame = browser->GetFrameByName(frame_id);
+                }
+                JSAPI::ScriptService::GetInstance()->Execute(frame, script, callback);
+            });
         }
     }
 }
\ No newline at end of file
@@ -30,6 +30,22 @@ namespace MikoView {
         std::string startup_url = "http://localhost:3000";
         bool start_hidden = true;  // Electron-style behavior
         int show_timeout_seconds = 10;
+        
+        // Message loop
+        bool multi_threaded_message_loop = false;  // Run CEF's UI thread separately; SDL stays on main (Windows/Linux)
+        bool external_message_pump = true;  // Block in SDL_WaitEventTimeout until SDL or CEF has work
+        int message_pump_max_idle_ms = 1000 / 30;  // Longest CEF may go without a pump while idle
+        bool measure_main_loop = false;  // Log wakeups/sec and loop latency once per second
+        
+        // Invoke handler executor
+        int executor_cpu_threads = 0;  // Work-stealing pool for CPU handlers; 0 = hardware threads - 1
+        int executor_io_threads = 4;  // Blocking I/O pool for IO handlers (fs.*)
+        int executor_io_queue_limit = 256;  // Queued IO requests per priority lane before invoke replies 503
+        int invoke_max_inflight_per_frame = 64;  // Worker-pool invokes one frame may have outstanding; 0 = unlimited
+        std::string metrics_dump_path;  // Periodic JSON dump of per-method invoke metrics; empty = off
+        int metrics_dump_interval_ms = 60000;
+        std::string invoke_record_path;  // Binary log of every invoke request, for `invokehost replay`; empty = off
+        int invoke_record_max_mb = 256;  // Recording stops at this size; 0 = unlimited
     };
     
     // Application state
@@ -137,8 +153,12 @@ namespace MikoView {
         // Register JavaScript functions
         void RegisterInvokeHandler();
         
-        // Execute JavaScript in the browser
-        void ExecuteScript(const std::string& script);
-        void ExecuteScriptInFrame(const std::string& script, const std::string& frame_name = "");
+        // Execute JavaScript in the browser. Callable from any thread; scripts
+        // queued in the same UI turn reach the renderer as one batch (see
+        // JSAPI::ScriptService). The callback gets the script's return value
+        // as JSON, or the error it threw.
+        void ExecuteScript(const std::string& script, JSAPI::InvokeCallback callback = nullptr);
+        void ExecuteScriptInFrame(const std::string& script, const std::string& frame_id = "",
+                                  JSAPI::InvokeCallback callback = nullptr);
     }
 }
\ No newline at end of file
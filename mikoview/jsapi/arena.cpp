@@ -0,0 +1,128 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+constexpr size_t kClassCount = BlockPool::kMaxPooledSize / BlockPool::kGranularity;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Set once the thread's lists are gone; blocks freed during thread exit
+// after that go straight back to the heap
+thread_local bool listsDestroyed = false;
+
+struct FreeLists {
+    std::array<FreeBlock*, kClassCount> heads = {};
+    std::array<size_t, kClassCount> counts = {};
+    BlockPoolStats stats;
+
+    ~FreeLists() {
+        listsDestroyed = true;
+        for (FreeBlock* head : heads) {
+            while (head) {
+                FreeBlock* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+};
+
+FreeLists& GetFreeLists() {
+    thread_local FreeLists lists;
+    return lists;
+}
+
+size_t ClassIndex(size_t size) {
+    return (size + BlockPool::kGranularity - 1) / BlockPool::kGranularity - 1;
+}
+
+} // namespace
+
+void* BlockPool::Allocate(size_t size) {
+    if (listsDestroyed) {
+        return ::operator new(size <= kMaxPooledSize ? (ClassIndex(size) + 1) * kGranularity : size);
+    }
+
+    FreeLists& lists = GetFreeLists();
+    lists.stats.allocations++;
+    if (size > kMaxPooledSize) {
+        lists.stats.oversized++;
+        return ::operator new(size);
+    }
+
+    const size_t index = ClassIndex(size);
+    if (FreeBlock* block = lists.heads[index]) {
+        lists.heads[index] = block->next;
+        lists.counts[index]--;
+        lists.stats.reused++;
+        return block;
+    }
+
+    // Rounded up, so the block can serve any size in its class later
+    return ::operator new((index + 1) * kGranularity);
+}
+
+void BlockPool::Deallocate(void* block, size_t size) noexcept {
+    if (size > kMaxPooledSize || listsDestroyed) {
+        ::operator delete(block);
+        return;
+    }
+
+    FreeLists& lists = GetFreeLists();
+    const size_t index = ClassIndex(size);
+    if (lists.counts[index] >= kMaxFreePerClass) {
+        ::operator delete(block);
+        return;
+    }
+
+    auto* free = static_cast<FreeBlock*>(block);
+    free->next = lists.heads[index];
+    lists.heads[index] = free;
+    lists.counts[index]++;
+}
+
+BlockPoolStats BlockPool::GetStats() {
+    return GetFreeLists().stats;
+}
+
+Arena::~Arena() {
+    while (blocks_) {
+        Block* next = blocks_->next;
+        BlockPool::Deallocate(blocks_, blocks_->size);
+        blocks_ = next;
+    }
+}
+
+void* Arena::AllocateSlow(size_t size, size_t align) {
+    // Large requests get a block of their own size
+    const size_t blockSize = std::max(kBlockSize, sizeof(Block) + align + size);
+    auto* block = static_cast<Block*>(BlockPool::Allocate(blockSize));
+    block->next = blocks_;
+    block->size = blockSize;
+    blocks_ = block;
+
+    char* start = Align(reinterpret_cast<char*>(block + 1), align);
+    pos_ = start + size;
+    end_ = reinterpret_cast<char*>(block) + blockSize;
+    return start;
+}
+
+std::string_view Arena::Copy(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* copy = static_cast<char*>(Allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Per-thread counters of the calling thread
+struct BlockPoolStats {
+    uint64_t allocations = 0;  // blocks handed out
+    uint64_t reused = 0;       // ... of those, taken from a free list
+    uint64_t oversized = 0;    // too large to pool; went to operator new
+};
+
+// Small blocks from per-thread free lists in 64-byte size classes, so a
+// steady stream of calls reuses the same few blocks instead of going to
+// malloc for each one. Coroutine frames, arenas and PoolAllocator draw from
+// it. A block freed on another thread joins that thread's list; each list
+// keeps at most kMaxFreePerClass blocks.
+class BlockPool {
+public:
+    static void* Allocate(size_t size);
+    static void Deallocate(void* block, size_t size) noexcept;
+
+    static BlockPoolStats GetStats();
+
+    static constexpr size_t kGranularity = 64;
+    static constexpr size_t kMaxPooledSize = 2048;
+    static constexpr size_t kMaxFreePerClass = 256;
+};
+
+// Standard allocator over BlockPool, for node containers and allocate_shared
+template<typename T>
+struct PoolAllocator {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "BlockPool blocks have operator new alignment");
+
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) { return static_cast<T*>(BlockPool::Allocate(count * sizeof(T))); }
+    void deallocate(T* block, size_t count) noexcept { BlockPool::Deallocate(block, count * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+};
+
+// Bump allocator for short-lived state that is freed all at once when the
+// arena goes away, such as one call's parse and serialize scratch. It can
+// start in a caller-provided buffer; later blocks come from BlockPool.
+// Nothing is destroyed, so only trivially destructible objects (or ones
+// whose destructor may be skipped) belong here. One thread at a time.
+class Arena {
+public:
+    Arena() = default;
+    // buffer must outlive the arena
+    Arena(char* buffer, size_t size) : pos_(buffer), end_(buffer + size) {}
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        char* start = Align(pos_, align);
+        if (static_cast<size_t>(end_ - start) < size) {
+            return AllocateSlow(size, align);
+        }
+        pos_ = start + size;
+        return start;
+    }
+
+    template<typename T>
+    T* AllocateArray(size_t count) {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Copy of text that lives as long as the arena
+    std::string_view Copy(std::string_view text);
+
+    // Gives back the end of the latest allocation when only `used` of its
+    // `size` bytes were needed; a no-op for any other block
+    void Shrink(void* block, size_t size, size_t used) {
+        if (static_cast<char*>(block) + size == pos_) {
+            pos_ = static_cast<char*>(block) + used;
+        }
+    }
+
+    // Blocks after the first hold at least this much
+    static constexpr size_t kBlockSize = 1024;
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    static char* Align(char* pos, size_t align) {
+        return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(pos) + align - 1) & ~(uintptr_t(align) - 1));
+    }
+
+    void* AllocateSlow(size_t size, size_t align);
+
+    Block* blocks_ = nullptr;
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+};
+
+// Standard allocator over an Arena for scratch containers. Deallocation is a
+// no-op; the memory comes back with the arena.
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.GetArena()) {}
+
+    T* allocate(size_t count) { return arena_->AllocateArray<T>(count); }
+    void deallocate(T*, size_t) noexcept {}
+
+    Arena* GetArena() const noexcept { return arena_; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.GetArena(); }
+
+private:
+    Arena* arena_;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
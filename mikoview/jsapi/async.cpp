@@ -0,0 +1,26 @@
+#include "async.hpp"
+#include <fstream>
+
+namespace MikoView {
+namespace JSAPI {
+namespace Async {
+
+Task<std::string> ReadFile(std::string path, InvokePriority priority) {
+    co_return co_await RunOn(HandlerAffinity::IO, [path = std::move(path)]() {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw InvokeError("Failed to open file: " + path, 404);
+        }
+
+        std::string data(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+            throw InvokeError("Failed to read file: " + path, 500);
+        }
+        return data;
+    }, priority);
+}
+
+} // namespace Async
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "arena.hpp"
+#include "executor.hpp"
+#include "request.hpp"
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace MikoView {
+namespace JSAPI {
+namespace Async {
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    // Frames are recycled through BlockPool rather than malloc'd per call
+    static void* operator new(size_t size) { return BlockPool::Allocate(size); }
+    static void operator delete(void* block, size_t size) noexcept { BlockPool::Deallocate(block, size); }
+
+    // Lazy: nothing runs until the task is awaited
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // Hands control straight to the awaiting coroutine
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template<typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+
+    template<typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T Take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template<>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void Take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace detail
+
+// Lazily started coroutine. co_await starts it and resumes the awaiting
+// coroutine, on whatever thread it finishes, with its result or exception.
+// Move-only; destroying an unfinished Task destroys its frame.
+template<typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::Promise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() { Reset(); }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    explicit operator bool() const { return static_cast<bool>(handle_); }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().Take(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    void Reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Eager, self-destroying coroutine that drives a Task for Spawn()
+struct Detached {
+    struct promise_type {
+        static void* operator new(size_t size) { return BlockPool::Allocate(size); }
+        static void operator delete(void* block, size_t size) noexcept { BlockPool::Deallocate(block, size); }
+
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template<typename T>
+Detached RunDetached(Task<T> task, std::function<void(T)> done,
+                     std::function<void(std::exception_ptr)> failed) {
+    std::optional<T> result;
+    try {
+        result.emplace(co_await std::move(task));
+    } catch (...) {
+        failed(std::current_exception());
+        co_return;
+    }
+    done(std::move(*result));
+}
+
+inline Detached RunDetached(Task<void> task, std::function<void()> done,
+                            std::function<void(std::exception_ptr)> failed) {
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        failed(std::current_exception());
+        co_return;
+    }
+    done();
+}
+
+} // namespace detail
+
+// Runs task to completion with nobody awaiting it. It starts on the calling
+// thread; done (or failed, with what it threw) runs wherever it finishes.
+template<typename T>
+void Spawn(Task<T> task, std::function<void(T)> done,
+           std::function<void(std::exception_ptr)> failed) {
+    detail::RunDetached(std::move(task), std::move(done), std::move(failed));
+}
+
+inline void Spawn(Task<void> task, std::function<void()> done,
+                  std::function<void(std::exception_ptr)> failed) {
+    detail::RunDetached(std::move(task), std::move(done), std::move(failed));
+}
+
+// Awaitables for handlers. Async handlers run on the UI thread, and each of
+// these resumes them there.
+
+// Continues on the UI thread after the tasks already queued there
+struct ResumeOnUI {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        Executor::PostToUI([handle]() { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+
+// Continues on the UI thread once delayMs have passed
+class Delay {
+public:
+    explicit Delay(int64_t delayMs) : delayMs_(delayMs) {}
+
+    bool await_ready() const noexcept { return delayMs_ <= 0; }
+    void await_suspend(std::coroutine_handle<> handle) {
+        Executor::PostDelayedToUI([handle]() { handle.resume(); }, delayMs_);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    int64_t delayMs_;
+};
+
+// Runs fn on a worker pool and continues on the UI thread with what it
+// returned, or rethrows what it threw. Throws InvokeError 503 if the pool's
+// lane for priority is full.
+//
+//   std::string text = co_await Async::RunOn(HandlerAffinity::CPU, [&]() { return Render(doc); });
+template<typename F>
+class RunOn {
+public:
+    using Result = std::invoke_result_t<F&>;
+
+    RunOn(HandlerAffinity affinity, F fn, InvokePriority priority = InvokePriority::Normal)
+        : affinity_(affinity), priority_(priority), fn_(std::move(fn)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        // The awaiter lives in the suspended frame until the resume below
+        busy_ = !Executor::GetInstance()->Post(affinity_, [this, handle]() {
+            try {
+                if constexpr (std::is_void_v<Result>) {
+                    fn_();
+                } else {
+                    result_.emplace(fn_());
+                }
+            } catch (...) {
+                error_ = std::current_exception();
+            }
+            Executor::PostToUI([handle]() { handle.resume(); });
+        }, priority_);
+        return !busy_;
+    }
+
+    Result await_resume() {
+        if (busy_) {
+            throw InvokeError("Server busy: worker pool lane full", 503);
+        }
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        if constexpr (!std::is_void_v<Result>) {
+            return std::move(*result_);
+        }
+    }
+
+private:
+    using Storage = std::conditional_t<std::is_void_v<Result>, bool, Result>;
+
+    HandlerAffinity affinity_;
+    InvokePriority priority_;
+    F fn_;
+    std::optional<Storage> result_;
+    std::exception_ptr error_;
+    bool busy_ = false;
+};
+
+// Adapts a callback API. start is called with a callback that resumes the
+// coroutine with its argument; it must be called exactly once, on the UI
+// thread, and may be called before start returns.
+//
+//   auto answer = co_await Async::FromCallback<int>([](auto resume) { AskUser(resume); });
+template<typename T>
+class FromCallback {
+public:
+    using Start = std::function<void(std::function<void(T)> resume)>;
+
+    explicit FromCallback(Start start) : start_(std::move(start)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        start_([this, handle](T value) {
+            result_.emplace(std::move(value));
+            if (suspended_) {
+                handle.resume();
+            }
+        });
+
+        // Answered synchronously: carry on without suspending
+        suspended_ = !result_;
+        return suspended_;
+    }
+
+    T await_resume() { return std::move(*result_); }
+
+private:
+    Start start_;
+    std::optional<T> result_;
+    bool suspended_ = false;
+};
+
+// Reads a whole file on the IO pool. Throws InvokeError 404 if it cannot be
+// opened, 500 if reading fails.
+Task<std::string> ReadFile(std::string path, InvokePriority priority = InvokePriority::Normal);
+
+} // namespace Async
+
+// Handler that answers asynchronously (see InvokeDispatcher::RegisterAsyncHandler)
+using AsyncHandler = std::function<Async::Task<InvokeResponse>(const InvokeRequest& request)>;
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
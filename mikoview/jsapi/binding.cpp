@@ -0,0 +1,341 @@
+#include "binding.hpp"
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+bool IsWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void AppendUTF8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+} // namespace
+
+JsonCursor::JsonCursor(const char* begin, const char* end)
+    : pos_(begin), end_(end), depth_(0), first_(0), failed_(false) {
+}
+
+void JsonCursor::SkipWhitespace() {
+    while (pos_ < end_ && IsWhitespace(*pos_)) {
+        ++pos_;
+    }
+}
+
+bool JsonCursor::Expect(char c) {
+    SkipWhitespace();
+    if (pos_ < end_ && *pos_ == c) {
+        ++pos_;
+        return true;
+    }
+    return Fail();
+}
+
+bool JsonCursor::Fail() {
+    failed_ = true;
+    return false;
+}
+
+bool JsonCursor::Enter() {
+    if (depth_ >= 63) {
+        return Fail();
+    }
+    ++depth_;
+    first_ |= uint64_t(1) << depth_;
+    return true;
+}
+
+bool JsonCursor::Separator(char close) {
+    if (failed_) {
+        return false;
+    }
+
+    SkipWhitespace();
+    if (pos_ < end_ && *pos_ == close) {
+        ++pos_;
+        --depth_;
+        return false;
+    }
+
+    const uint64_t bit = uint64_t(1) << depth_;
+    if (first_ & bit) {
+        first_ &= ~bit;
+        return true;
+    }
+    return Expect(',');
+}
+
+bool JsonCursor::BeginObject() {
+    if (failed_ || !Expect('{')) {
+        return false;
+    }
+    return Enter();
+}
+
+bool JsonCursor::NextKey(std::string& key) {
+    if (!Separator('}')) {
+        return false;
+    }
+
+    SkipWhitespace();
+    if (pos_ >= end_ || *pos_ != '"') {
+        return Fail();
+    }
+    return ReadString(key) && Expect(':');
+}
+
+bool JsonCursor::BeginArray() {
+    SkipWhitespace();
+    if (failed_ || pos_ >= end_ || *pos_ != '[') {
+        return false;
+    }
+    ++pos_;
+    return Enter();
+}
+
+bool JsonCursor::NextElement() {
+    return Separator(']');
+}
+
+bool JsonCursor::ReadString(std::string& value) {
+    SkipWhitespace();
+    if (failed_ || pos_ >= end_ || *pos_ != '"') {
+        return false;
+    }
+    ++pos_;
+
+    value.clear();
+    while (pos_ < end_) {
+        // Copy the run up to the next quote or escape in one go
+        const char* run = pos_;
+        while (pos_ < end_ && *pos_ != '"' && *pos_ != '\\') {
+            ++pos_;
+        }
+        value.append(run, pos_ - run);
+
+        if (pos_ >= end_) {
+            break;
+        }
+        if (*pos_ == '"') {
+            ++pos_;
+            return true;
+        }
+
+        // Escape sequence
+        if (++pos_ >= end_) {
+            break;
+        }
+        char c = *pos_++;
+        switch (c) {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u': {
+                auto readHex = [this](uint32_t& cp) {
+                    if (end_ - pos_ < 4) {
+                        return false;
+                    }
+                    cp = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int digit = HexValue(pos_[i]);
+                        if (digit < 0) {
+                            return false;
+                        }
+                        cp = (cp << 4) | static_cast<uint32_t>(digit);
+                    }
+                    pos_ += 4;
+                    return true;
+                };
+
+                uint32_t cp = 0;
+                if (!readHex(cp)) {
+                    return Fail();
+                }
+                // Surrogate pair
+                if (cp >= 0xD800 && cp <= 0xDBFF && end_ - pos_ >= 6 && pos_[0] == '\\' && pos_[1] == 'u') {
+                    pos_ += 2;
+                    uint32_t low = 0;
+                    if (!readHex(low)) {
+                        return Fail();
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUTF8(value, cp);
+                break;
+            }
+            default:
+                return Fail();
+        }
+    }
+    return Fail();
+}
+
+bool JsonCursor::ReadBool(bool& value) {
+    SkipWhitespace();
+    if (failed_) {
+        return false;
+    }
+    if (end_ - pos_ >= 4 && std::memcmp(pos_, "true", 4) == 0) {
+        pos_ += 4;
+        value = true;
+        return true;
+    }
+    if (end_ - pos_ >= 5 && std::memcmp(pos_, "false", 5) == 0) {
+        pos_ += 5;
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+bool JsonCursor::ReadInt64(int64_t& value) {
+    SkipWhitespace();
+    if (failed_ || pos_ >= end_) {
+        return false;
+    }
+
+    auto result = std::from_chars(pos_, end_, value);
+    if (result.ec != std::errc() ||
+        (result.ptr < end_ && (*result.ptr == '.' || *result.ptr == 'e' || *result.ptr == 'E'))) {
+        return false;
+    }
+    pos_ = result.ptr;
+    return true;
+}
+
+bool JsonCursor::ReadDouble(double& value) {
+    SkipWhitespace();
+    if (failed_ || pos_ >= end_) {
+        return false;
+    }
+
+    // strtod needs a terminated buffer; JSON numbers are short
+    const char* start = pos_;
+    const char* p = pos_;
+    while (p < end_ && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')) {
+        ++p;
+    }
+    if (p == start || p - start >= 64) {
+        return false;
+    }
+
+    char buffer[64];
+    std::memcpy(buffer, start, p - start);
+    buffer[p - start] = '\0';
+
+    char* parsed = nullptr;
+    value = std::strtod(buffer, &parsed);
+    if (parsed != buffer + (p - start)) {
+        return false;
+    }
+    pos_ = p;
+    return true;
+}
+
+bool JsonCursor::ConsumeNull() {
+    SkipWhitespace();
+    if (!failed_ && end_ - pos_ >= 4 && std::memcmp(pos_, "null", 4) == 0) {
+        pos_ += 4;
+        return true;
+    }
+    return false;
+}
+
+bool JsonCursor::Skip() {
+    SkipWhitespace();
+    if (failed_ || pos_ >= end_) {
+        return Fail();
+    }
+
+    char c = *pos_;
+    if (c == '"') {
+        // Walk the string without decoding it
+        ++pos_;
+        while (pos_ < end_ && *pos_ != '"') {
+            if (static_cast<unsigned char>(*pos_) < 0x20) {
+                return Fail();
+            }
+            if (*pos_ == '\\' && ++pos_ >= end_) {
+                break;
+            }
+            ++pos_;
+        }
+        if (pos_ >= end_) {
+            return Fail();
+        }
+        ++pos_;
+        return true;
+    }
+
+    if (c == '{') {
+        std::string key;
+        BeginObject();
+        while (NextKey(key)) {
+            if (!Skip()) {
+                return false;
+            }
+        }
+        return !failed_;
+    }
+
+    if (c == '[') {
+        BeginArray();
+        while (NextElement()) {
+            if (!Skip()) {
+                return false;
+            }
+        }
+        return !failed_;
+    }
+
+    bool flag = false;
+    double number = 0;
+    if (ConsumeNull() || ReadBool(flag) || ReadDouble(number)) {
+        return true;
+    }
+    return Fail();
+}
+
+bool JsonCursor::IsValid(const char* begin, const char* end) {
+    JsonCursor cursor(begin, end);
+    if (!cursor.Skip()) {
+        return false;
+    }
+    cursor.SkipWhitespace();
+    return cursor.pos_ == cursor.end_;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
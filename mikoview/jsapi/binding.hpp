@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Forward-only reader over a JSON document. Values are decoded straight into
+// their destination; nothing is materialized for keys nobody asked for.
+class JsonCursor {
+public:
+    JsonCursor(const char* begin, const char* end);
+
+    // Object traversal: BeginObject(), then NextKey() until it returns false
+    bool BeginObject();
+    bool NextKey(std::string& key);
+
+    // Read the value that follows a key (or an array element)
+    bool ReadString(std::string& value);
+    bool ReadBool(bool& value);
+    bool ReadInt64(int64_t& value);
+    bool ReadDouble(double& value);
+    bool ConsumeNull();
+    bool Skip();  // validates what it skips
+
+    // Array traversal: BeginArray(), then NextElement() until it returns false
+    bool BeginArray();
+    bool NextElement();
+
+    bool Failed() const { return failed_; }
+
+    // True if [begin, end) is exactly one well-formed JSON value
+    static bool IsValid(const char* begin, const char* end);
+
+private:
+    void SkipWhitespace();
+    bool Expect(char c);
+    bool Fail();
+    bool Enter();
+    bool Separator(char close);
+
+    const char* pos_;
+    const char* end_;
+    int depth_;
+    uint64_t first_;  // bit per nesting level: no element read yet
+    bool failed_;
+};
+
+// Field descriptor for Binding<T>::Fields()
+template<typename S, typename T>
+struct Field {
+    std::string_view name;
+    T S::* member;
+    bool required;
+};
+
+template<typename S, typename T>
+constexpr Field<S, T> Required(std::string_view name, T S::* member) {
+    return Field<S, T>{name, member, true};
+}
+
+template<typename S, typename T>
+constexpr Field<S, T> Optional(std::string_view name, T S::* member) {
+    return Field<S, T>{name, member, false};
+}
+
+// Specialize for each argument struct:
+//
+//   template<> struct Binding<WriteFileArgs> {
+//       static constexpr auto Fields() {
+//           return std::make_tuple(Required("path", &WriteFileArgs::path),
+//                                  Optional("encoding", &WriteFileArgs::encoding));
+//       }
+//   };
+template<typename T>
+struct Binding;
+
+namespace detail {
+
+inline bool ReadValue(JsonCursor& cursor, std::string& value) { return cursor.ReadString(value); }
+inline bool ReadValue(JsonCursor& cursor, bool& value) { return cursor.ReadBool(value); }
+inline bool ReadValue(JsonCursor& cursor, int64_t& value) { return cursor.ReadInt64(value); }
+inline bool ReadValue(JsonCursor& cursor, double& value) { return cursor.ReadDouble(value); }
+
+inline bool ReadValue(JsonCursor& cursor, int& value) {
+    int64_t wide = 0;
+    if (!cursor.ReadInt64(wide) || wide < INT32_MIN || wide > INT32_MAX) {
+        return false;
+    }
+    value = static_cast<int>(wide);
+    return true;
+}
+
+template<typename T>
+bool ReadValue(JsonCursor& cursor, std::vector<T>& values) {
+    values.clear();
+    if (!cursor.BeginArray()) {
+        return false;
+    }
+    while (cursor.NextElement()) {
+        values.emplace_back();
+        if (!ReadValue(cursor, values.back())) {
+            return false;
+        }
+    }
+    return !cursor.Failed();
+}
+
+// Reads the value into the field named key; returns its index or -1
+template<typename T, typename Fields, size_t... I>
+int ReadField(JsonCursor& cursor, const std::string& key, T& out, const Fields& fields,
+              bool& ok, std::index_sequence<I...>) {
+    int index = -1;
+    ((index < 0 && std::get<I>(fields).name == key
+        ? (index = static_cast<int>(I), ok = ReadValue(cursor, out.*(std::get<I>(fields).member)))
+        : false), ...);
+    return index;
+}
+
+template<typename Fields, size_t... I>
+std::string_view FirstMissing(const Fields& fields, uint64_t seen, std::index_sequence<I...>) {
+    std::string_view missing;
+    ((missing.empty() && std::get<I>(fields).required && !(seen & (uint64_t(1) << I))
+        ? (missing = std::get<I>(fields).name, true)
+        : false), ...);
+    return missing;
+}
+
+} // namespace detail
+
+// Decodes a JSON object into T in a single pass. Unknown keys are skipped and
+// null counts as absent. On failure error receives a message suitable for a
+// 400 response.
+template<typename T>
+bool Bind(const char* begin, const char* end, T& out, std::string* error = nullptr) {
+    constexpr auto fields = Binding<T>::Fields();
+    constexpr size_t count = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+    static_assert(count <= 64, "Binding supports at most 64 fields");
+    using Indices = std::make_index_sequence<count>;
+
+    JsonCursor cursor(begin, end);
+    if (!cursor.BeginObject()) {
+        if (error) *error = "Malformed request data";
+        return false;
+    }
+
+    uint64_t seen = 0;
+    std::string key;
+    while (cursor.NextKey(key)) {
+        if (cursor.ConsumeNull()) {
+            continue;
+        }
+
+        bool ok = true;
+        int index = detail::ReadField(cursor, key, out, fields, ok, Indices());
+        if (index < 0) {
+            ok = cursor.Skip();
+        } else if (ok) {
+            seen |= uint64_t(1) << index;
+        } else if (!cursor.Failed()) {
+            if (error) *error = "Invalid parameter: " + key;
+            return false;
+        }
+
+        if (!ok) {
+            break;
+        }
+    }
+
+    if (cursor.Failed()) {
+        if (error) *error = "Malformed request data";
+        return false;
+    }
+
+    std::string_view missing = detail::FirstMissing(fields, seen, Indices());
+    if (!missing.empty()) {
+        if (error) *error = "Missing required parameter: " + std::string(missing);
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+bool Bind(const std::string& json, T& out, std::string* error = nullptr) {
+    return Bind(json.data(), json.data() + json.size(), out, error);
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
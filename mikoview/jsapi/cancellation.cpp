@@ -0,0 +1,50 @@
+#include "cancellation.hpp"
+#include "arena.hpp"
+#include <chrono>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Every call makes one; pooled like the call's other per-request blocks
+CancellationToken::CancellationToken()
+    : state_(std::allocate_shared<State>(PoolAllocator<State>())) {
+}
+
+void CancellationToken::Cancel(CancelReason reason) {
+    int expected = static_cast<int>(CancelReason::None);
+    state_->reason.compare_exchange_strong(expected, static_cast<int>(reason), std::memory_order_acq_rel);
+}
+
+void CancellationToken::SetDeadline(int64_t deadlineMs) {
+    state_->deadlineMs.store(deadlineMs, std::memory_order_relaxed);
+}
+
+int64_t CancellationToken::GetDeadline() const {
+    return state_->deadlineMs.load(std::memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const {
+    return GetReason() != CancelReason::None;
+}
+
+CancelReason CancellationToken::GetReason() const {
+    CancelReason reason = static_cast<CancelReason>(state_->reason.load(std::memory_order_acquire));
+    if (reason != CancelReason::None) {
+        return reason;
+    }
+    
+    // Checked lazily so handlers see their deadline without waiting for a tick
+    const int64_t deadline = GetDeadline();
+    if (deadline > 0 && NowMs() >= deadline) {
+        return CancelReason::DeadlineExceeded;
+    }
+    return CancelReason::None;
+}
+
+int64_t CancellationToken::NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
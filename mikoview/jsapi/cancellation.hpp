@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Why a token was cancelled
+enum class CancelReason {
+    None = 0,
+    Cancelled = 1,        // the renderer aborted the call, or its browser closed
+    DeadlineExceeded = 2  // the method's deadline passed
+};
+
+// Cooperative cancellation for a running handler. Copies share state, so the
+// browser UI thread can cancel a token a worker is polling. Long-running
+// handlers should check IsCancelled() between units of work and return early;
+// whatever they answer after cancellation is discarded.
+class CancellationToken {
+public:
+    CancellationToken();
+    
+    // First reason wins; later calls are ignored
+    void Cancel(CancelReason reason = CancelReason::Cancelled);
+    
+    // Absolute steady-clock deadline in milliseconds (see NowMs); 0 = none
+    void SetDeadline(int64_t deadlineMs);
+    int64_t GetDeadline() const;
+    
+    // Also true once the deadline has passed, even before anyone calls Cancel
+    bool IsCancelled() const;
+    CancelReason GetReason() const;
+    
+    static int64_t NowMs();
+    
+private:
+    struct State {
+        std::atomic<int> reason{static_cast<int>(CancelReason::None)};
+        std::atomic<int64_t> deadlineMs{0};
+    };
+    
+    std::shared_ptr<State> state_;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
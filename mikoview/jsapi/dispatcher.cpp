@@ -0,0 +1,953 @@
+#include "dispatcher.hpp"
+#include "fileio.hpp"
+#include "metrics.hpp"
+#include "../logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+
+namespace MikoView {
+namespace JSAPI {
+
+std::atomic<int> InvokeDispatcher::nextSessionId_{-1};
+
+namespace {
+
+// Per-client counts TrackInFlight keeps before it drops the idle ones
+constexpr size_t kMaxIdleClients = 64;
+
+const char* SkipSpace(const char* pos, const char* end) {
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// pos is at the opening quote; returns the position past the closing one
+const char* SkipString(const char* pos) {
+    for (++pos; *pos != '"'; ++pos) {
+        if (*pos == '\\') {
+            ++pos;
+        }
+    }
+    return pos + 1;
+}
+
+using ScratchString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+// Appends the JSON value at pos without whitespace and with object members
+// sorted by key, so equal arguments sent in any key order come out the same.
+// Strings and numbers are copied as written. The input must be valid JSON.
+// Object members are staged in scratch memory from arena.
+template<typename Out>
+const char* AppendCanonical(const char* pos, const char* end, Out& out, Arena& arena) {
+    pos = SkipSpace(pos, end);
+    if (*pos == '"') {
+        const char* next = SkipString(pos);
+        out.append(pos, next);
+        return next;
+    }
+    
+    if (*pos == '[') {
+        out += '[';
+        pos = SkipSpace(pos + 1, end);
+        while (*pos != ']') {
+            pos = SkipSpace(AppendCanonical(pos, end, out, arena), end);
+            if (*pos == ',') {
+                out += ',';
+                ++pos;
+            }
+        }
+        out += ']';
+        return pos + 1;
+    }
+    
+    if (*pos == '{') {
+        // Each member's value is written to values; members index into it
+        struct Member {
+            std::string_view key;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<Member, ArenaAllocator<Member>> members{ArenaAllocator<Member>(arena)};
+        ScratchString values{ArenaAllocator<char>(arena)};
+        
+        pos = SkipSpace(pos + 1, end);
+        while (*pos != '}') {
+            const char* keyEnd = SkipString(pos);
+            std::string_view key(pos, keyEnd - pos);
+            const size_t begin = values.size();
+            pos = SkipSpace(keyEnd, end) + 1;  // past ':'
+            pos = SkipSpace(AppendCanonical(pos, end, values, arena), end);
+            members.push_back(Member{key, begin, values.size()});
+            if (*pos == ',') {
+                pos = SkipSpace(pos + 1, end);
+            }
+        }
+        std::sort(members.begin(), members.end(), [](const Member& a, const Member& b) {
+            return a.key < b.key;
+        });
+        
+        out += '{';
+        for (size_t i = 0; i < members.size(); ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            out.append(members[i].key.data(), members[i].key.size());
+            out += ':';
+            out.append(values.data() + members[i].begin, members[i].end - members[i].begin);
+        }
+        out += '}';
+        return pos + 1;
+    }
+    
+    // Number, true, false or null
+    const char* start = pos;
+    while (pos < end && *pos != ',' && *pos != ']' && *pos != '}' &&
+           *pos != ' ' && *pos != '\t' && *pos != '\n' && *pos != '\r') {
+        ++pos;
+    }
+    out.append(start, pos);
+    return pos;
+}
+
+} // namespace
+
+// Where a batch's answers collect until its last request finishes
+struct InvokeDispatcher::BatchState {
+    std::vector<InvokeRequest> requests;
+    std::vector<InvokeResponse> responses;
+    std::vector<bool> tracked;  // ran on a worker pool, so may be cancelled
+    std::vector<std::shared_ptr<const RegisteredHandler>> handlers;
+    std::vector<std::string> cacheKeys;
+    uint64_t cacheGeneration = 0;
+    std::atomic<size_t> remaining;
+};
+
+void InvokeChannel::SendBatchResponse(const std::vector<const InvokeResponse*>& responses) {
+    for (const InvokeResponse* response : responses) {
+        SendResponse(*response);
+    }
+}
+
+void InvokeChannel::SendEvents(const std::vector<EventDelivery>&) {
+}
+
+InvokeDispatcher* InvokeDispatcher::GetInstance() {
+    static InvokeDispatcher* instance = []() {
+        auto* dispatcher = new InvokeDispatcher();
+        dispatcher->RegisterHandler(kMetricsMethod, HandleMetrics);
+        return dispatcher;
+    }();
+    return instance;
+}
+
+int InvokeDispatcher::NewSessionId() {
+    return nextSessionId_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void InvokeDispatcher::RegisterHandler(const std::string& method, NativeHandler handler,
+                                       HandlerOptions options) {
+    auto registered = std::make_shared<const RegisteredHandler>(RegisteredHandler{std::move(handler), options, nullptr});
+    methods_.Update(method, [&registered](MethodHandlers& handlers) {
+        handlers.call = std::move(registered);
+    });
+    Logger::Info("Registered invoke handler: " + method);
+}
+
+void InvokeDispatcher::RegisterAsyncHandler(const std::string& method, AsyncHandler handler,
+                                            HandlerOptions options) {
+    auto registered = std::make_shared<const RegisteredHandler>(RegisteredHandler{nullptr, options, std::move(handler)});
+    methods_.Update(method, [&registered](MethodHandlers& handlers) {
+        handlers.call = std::move(registered);
+    });
+    Logger::Info("Registered async invoke handler: " + method);
+}
+
+void InvokeDispatcher::UnregisterHandler(const std::string& method) {
+    methods_.Update(method, [](MethodHandlers& handlers) {
+        handlers.call.reset();
+    }, false);
+    Logger::Info("Unregistered invoke handler: " + method);
+}
+
+void InvokeDispatcher::RegisterStreamHandler(const std::string& method, StreamHandler handler,
+                                             HandlerOptions options) {
+    if (options.affinity == HandlerAffinity::UI) {
+        options.affinity = HandlerAffinity::IO;
+    }
+    auto registered = std::make_shared<const RegisteredStreamHandler>(RegisteredStreamHandler{std::move(handler), options});
+    methods_.Update(method, [&registered](MethodHandlers& handlers) {
+        handlers.stream = std::move(registered);
+    });
+    Logger::Info("Registered stream handler: " + method);
+}
+
+void InvokeDispatcher::UnregisterStreamHandler(const std::string& method) {
+    methods_.Update(method, [](MethodHandlers& handlers) {
+        handlers.stream.reset();
+    }, false);
+    Logger::Info("Unregistered stream handler: " + method);
+}
+
+MethodId InvokeDispatcher::FindMethod(const std::string& method) {
+    methods_.Reclaim();
+    return methods_.Read().Find(method);
+}
+
+const InvokeDispatcher::MethodHandlers* InvokeDispatcher::Resolve(InvokeRequest& request) {
+    // Every lookup starts here, on the UI thread, so no snapshot is in use
+    methods_.Reclaim();
+    const auto& table = methods_.Read();
+    
+    MethodId id = request.GetMethodId();
+    if (id == kNoMethodId) {
+        id = table.Find(request.GetMethod());
+    }
+    
+    const MethodHandlers* handlers = table.Get(id);
+    if (handlers) {
+        request.SetMethodId(id, &table.GetName(id));
+    }
+    return handlers;
+}
+
+std::string InvokeDispatcher::NotFound(const InvokeRequest& request) {
+    if (request.GetMethod().empty()) {
+        std::string name = "#";
+        name += std::to_string(request.GetMethodId());
+        return name;
+    }
+    return request.GetMethod();
+}
+
+void InvokeDispatcher::Dispatch(std::shared_ptr<InvokeChannel> channel, InvokeRequest request) {
+    const int requestId = request.GetRequestId();
+    request.SetSessionId(channel->GetSessionId());
+    
+    const MethodHandlers* handlers = Resolve(request);
+    recorder_.RecordCall(channel->GetSessionId(), channel->GetClientKey(), request);
+    if (!handlers || !handlers->call) {
+        InvokeResponse response(requestId);
+        response.SetError("Method not found: " + NotFound(request), 404);
+        channel->SendResponse(response);
+        return;
+    }
+    
+    // Held by reference from here on, so it survives UnregisterHandler
+    std::shared_ptr<const RegisteredHandler> handler = handlers->call;
+    const HandlerAffinity affinity = handler->options.affinity;
+    
+    std::string cacheKey;
+    if (handler->options.idempotent) {
+        cacheKey = CacheKey(request);
+        if (!cacheKey.empty() && AnswerFromCache(*channel, cacheKey, request)) {
+            return;
+        }
+    }
+    
+    if (affinity == HandlerAffinity::UI && !handler->async) {
+        InvokeResponse response(requestId);
+        RunHandler(handler->handler, request, response);
+        if (!cacheKey.empty()) {
+            callStats_.cacheMisses++;
+            StoreResult(cacheKey, request.GetMethodId(), handler->options.cacheTtlMs, response);
+        }
+        InvalidateAfter(*handler, response);
+        channel->SendResponse(response);
+        return;
+    }
+    
+    // An identical call is already running: wait for its answer
+    std::shared_ptr<SharedCall> sharedCall;
+    if (!cacheKey.empty()) {
+        auto running = sharedCalls_.find(cacheKey);
+        if (running != sharedCalls_.end()) {
+            InvokeResponse refusal(requestId);
+            if (!TrackInFlight(channel, request, handler->options.timeoutMs, refusal, running->second)) {
+                channel->SendResponse(refusal);
+                return;
+            }
+            running->second->callers.emplace_back(channel, requestId);
+            callStats_.coalesced++;
+            Metrics::GetInstance()->RecordReused(request.GetMethod(), false);
+            return;
+        }
+        
+        sharedCall = std::make_shared<SharedCall>();
+        sharedCall->key = std::move(cacheKey);
+        sharedCall->method = request.GetMethodId();
+        sharedCall->token = request.GetCancellation();
+        sharedCall->callers.emplace_back(channel, requestId);
+        sharedCall->generation = cacheGeneration_;
+    }
+    
+    // Refuse rather than queue without bound; the caller can back off
+    InvokeResponse refusal(requestId);
+    if (!TrackInFlight(channel, request, handler->options.timeoutMs, refusal, sharedCall)) {
+        channel->SendResponse(refusal);
+        return;
+    }
+    if (sharedCall) {
+        sharedCalls_[sharedCall->key] = sharedCall;
+        callStats_.cacheMisses++;
+    }
+    
+    if (handler->async) {
+        auto shared = std::make_shared<InvokeRequest>(std::move(request));
+        RunAsync(handler, std::move(shared), [this, handler, channel, sharedCall](const InvokeResponse& response) {
+            Complete(*channel, *handler, sharedCall, response);
+        });
+        return;
+    }
+    
+    // Run off the UI thread
+    const InvokePriority priority = request.GetPriority();
+    auto* call = new PendingCall{std::move(request), InvokeResponse(requestId), handler, channel, sharedCall};
+    bool posted = Executor::GetInstance()->Post(affinity, [call]() {
+        RunHandler(call->handler->handler, call->request, call->response);
+        
+        Executor::PostToUI([call]() {
+            std::unique_ptr<PendingCall> done(call);
+            GetInstance()->Complete(*done->channel, *done->handler, done->shared, done->response);
+        });
+    }, priority);
+    
+    if (!posted) {
+        std::unique_ptr<PendingCall> refused(call);
+        if (sharedCall) {
+            DetachShared(sharedCall);
+        }
+        FinishInFlight(*channel, requestId);
+        callStats_.busy++;
+        InvokeResponse response(requestId);
+        response.SetError("Server busy: " + refused->request.GetMethod(), 503);
+        channel->SendResponse(response);
+    }
+}
+
+void InvokeDispatcher::DispatchBatch(std::shared_ptr<InvokeChannel> channel,
+                                     std::vector<InvokeRequest> requests) {
+    auto batch = std::make_shared<BatchState>();
+    batch->requests = std::move(requests);
+    batch->tracked.assign(batch->requests.size(), false);
+    batch->handlers.resize(batch->requests.size());
+    batch->cacheKeys.resize(batch->requests.size());
+    batch->cacheGeneration = cacheGeneration_;
+    batch->responses.reserve(batch->requests.size());
+    for (auto& request : batch->requests) {
+        request.SetSessionId(channel->GetSessionId());
+        batch->responses.emplace_back(request.GetRequestId());
+    }
+    
+    // One extra count held by this function, so a fast worker cannot send
+    // the batch before every request has been dispatched
+    batch->remaining = batch->requests.size() + 1;
+    
+    auto finish = [this, batch, channel](bool onUIThread) {
+        if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if (onUIThread) {
+            FinishBatch(*channel, *batch);
+        } else {
+            Executor::PostToUI([this, batch, channel]() {
+                FinishBatch(*channel, *batch);
+            });
+        }
+    };
+    
+    for (size_t i = 0; i < batch->requests.size(); ++i) {
+        InvokeRequest& request = batch->requests[i];
+        InvokeResponse& response = batch->responses[i];
+        
+        const MethodHandlers* handlers = Resolve(request);
+        if (!handlers || !handlers->call) {
+            response.SetError("Method not found: " + NotFound(request), 404);
+            finish(true);
+            continue;
+        }
+        
+        std::shared_ptr<const RegisteredHandler> handler = handlers->call;
+        const HandlerAffinity affinity = handler->options.affinity;
+        batch->handlers[i] = handler;
+        
+        // Batched calls use the cache but never join a running call
+        if (handler->options.idempotent) {
+            std::string key = CacheKey(request);
+            auto cached = key.empty() ? cache_.end() : cache_.find(key);
+            if (cached != cache_.end() && cached->second.expiresMs > CancellationToken::NowMs()) {
+                response = *cached->second.response;
+                response.SetRequestId(request.GetRequestId());
+                callStats_.cacheHits++;
+                Metrics::GetInstance()->RecordReused(request.GetMethod(), true);
+                batch->handlers[i].reset();
+                finish(true);
+                continue;
+            }
+            if (!key.empty()) {
+                callStats_.cacheMisses++;
+            }
+            batch->cacheKeys[i] = std::move(key);
+        }
+        
+        if (affinity == HandlerAffinity::UI && !handler->async) {
+            RunHandler(handler->handler, request, response);
+            finish(true);
+            continue;
+        }
+        
+        if (!TrackInFlight(channel, request, handler->options.timeoutMs, response)) {
+            finish(true);
+            continue;
+        }
+        batch->tracked[i] = true;
+        
+        if (handler->async) {
+            // Shares the batch's lifetime
+            std::shared_ptr<const InvokeRequest> shared(batch, &request);
+            RunAsync(handler, shared, [batch, i, finish](const InvokeResponse& result) {
+                batch->responses[i] = result;
+                finish(true);
+            });
+            continue;
+        }
+        
+        // Each task writes only its own response slot
+        bool posted = Executor::GetInstance()->Post(affinity, [handler, batch, i, finish]() {
+            RunHandler(handler->handler, batch->requests[i], batch->responses[i]);
+            finish(false);
+        }, request.GetPriority());
+        if (!posted) {
+            FinishInFlight(*channel, request.GetRequestId());
+            batch->tracked[i] = false;
+            callStats_.busy++;
+            response.SetError("Server busy: " + request.GetMethod(), 503);
+            finish(true);
+        }
+    }
+    
+    // Every method is resolved to its name by now
+    recorder_.RecordBatch(channel->GetSessionId(), channel->GetClientKey(), batch->requests);
+    finish(true);
+}
+
+void InvokeDispatcher::FinishBatch(InvokeChannel& channel, BatchState& batch) {
+    const std::vector<InvokeResponse>& responses = batch.responses;
+    
+    // Cache first: a write later in the batch invalidates what an earlier
+    // read returned, in either order
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (!batch.cacheKeys[i].empty() && batch.cacheGeneration == cacheGeneration_) {
+            StoreResult(batch.cacheKeys[i], batch.requests[i].GetMethodId(),
+                        batch.handlers[i]->options.cacheTtlMs, responses[i]);
+        }
+    }
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (batch.handlers[i]) {
+            InvalidateAfter(*batch.handlers[i], responses[i]);
+        }
+    }
+    
+    // Settle the in-flight table even if nobody is listening any more
+    std::vector<const InvokeResponse*> live;
+    live.reserve(responses.size());
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (!batch.tracked[i] || FinishInFlight(channel, responses[i].GetRequestId())) {
+            live.push_back(&responses[i]);
+        }
+    }
+    
+    if (!live.empty()) {
+        channel.SendBatchResponse(live);
+    }
+}
+
+void InvokeDispatcher::OpenStream(std::shared_ptr<InvokeChannel> channel, InvokeRequest request,
+                                  size_t chunkSize, int credits) {
+    request.SetSessionId(channel->GetSessionId());
+    auto writer = std::make_shared<StreamWriter>(channel, request.GetRequestId(), chunkSize, credits);
+    
+    const MethodHandlers* handlers = Resolve(request);
+    recorder_.RecordStream(channel->GetSessionId(), channel->GetClientKey(), request, chunkSize, credits);
+    if (!handlers || !handlers->stream) {
+        writer->Fail("Stream method not found: " + NotFound(request), 404);
+        return;
+    }
+    std::shared_ptr<const RegisteredStreamHandler> registered = handlers->stream;
+    
+    // Registered until the final message has been sent. A stream id still
+    // open for this client is refused; replacing it would orphan its writer.
+    StreamKey key(channel->GetSessionId(), channel->GetClientKey(), request.GetRequestId());
+    if (!streams_.emplace(key, writer).second) {
+        writer->Fail("Duplicate stream id: " + std::to_string(request.GetRequestId()), 409);
+        return;
+    }
+    writer->SetOnFinished([this, key = std::move(key)]() {
+        streams_.erase(key);
+    });
+    
+    auto shared = std::make_shared<InvokeRequest>(std::move(request));
+    writer->SetCancellation(shared->GetCancellation());
+    bool posted = Executor::GetInstance()->Post(registered->options.affinity, [registered, shared, writer]() {
+        CallSample sample;
+        const uint64_t start = Metrics::NowUs();
+        sample.queueUs = start - shared->GetReceivedAt();
+        sample.bytesIn = shared->GetData().size();
+        
+        try {
+            registered->handler(*shared, *writer);
+            writer->End();
+        } catch (const std::exception& e) {
+            writer->Fail("Handler exception: " + std::string(e.what()), 500);
+            sample.success = false;
+        }
+        
+        // Execution time includes waiting for the consumer's credit
+        sample.execUs = Metrics::NowUs() - start;
+        sample.bytesOut = writer->GetBytesWritten();
+        sample.success = sample.success && !writer->IsCancelled();
+        Metrics::GetInstance()->Record(shared->GetMethod(), sample);
+    }, shared->GetPriority());
+    
+    if (!posted) {
+        writer->Fail("Server busy: " + shared->GetMethod(), 503);
+    }
+}
+
+void InvokeDispatcher::AckStream(int sessionId, const std::string& clientKey, int streamId, int credits) {
+    auto it = streams_.find(StreamKey(sessionId, clientKey, streamId));
+    if (it != streams_.end()) {
+        it->second->AddCredits(credits);
+    }
+}
+
+void InvokeDispatcher::CancelStream(int sessionId, const std::string& clientKey, int streamId) {
+    auto it = streams_.find(StreamKey(sessionId, clientKey, streamId));
+    if (it != streams_.end()) {
+        it->second->Cancel();
+    }
+}
+
+void InvokeDispatcher::Cancel(int sessionId, const std::string& clientKey, int requestId) {
+    auto client = inFlightPerClient_.find(clientKey);
+    if (client == inFlightPerClient_.end()) {
+        return;
+    }
+    auto it = inFlight_.find(InFlightKey(client->second.id, requestId));
+    if (it == inFlight_.end() || it->second.channel->GetSessionId() != sessionId) {
+        return;
+    }
+    
+    callStats_.cancelled++;
+    AbandonInFlight(it);
+}
+
+void InvokeDispatcher::CloseSession(int sessionId) {
+    // Worker-pool calls stop at their next cancellation check
+    for (auto it = inFlight_.begin(); it != inFlight_.end();) {
+        if (it->second.channel->GetSessionId() == sessionId) {
+            callStats_.cancelled++;
+            AbandonInFlight(it++);
+        } else {
+            ++it;
+        }
+    }
+    
+    // Wake writers blocked waiting for credit; their handlers then return
+    for (auto& stream : streams_) {
+        if (std::get<0>(stream.first) == sessionId) {
+            stream.second->Cancel();
+        }
+    }
+    
+    EventHub::GetInstance()->CloseSession(sessionId);
+    FileHandleTable::GetInstance()->CloseSession(sessionId);
+}
+
+InvokeCallStats InvokeDispatcher::GetInvokeCallStats() const {
+    InvokeCallStats stats = callStats_;
+    stats.inFlight = inFlight_.size();
+    stats.cached = cache_.size();
+    return stats;
+}
+
+void InvokeDispatcher::InvalidateCache(const std::string& method) {
+    methods_.Reclaim();
+    const MethodId id = methods_.Read().Find(method);
+    if (id != kNoMethodId) {
+        InvalidateCache(id);
+    }
+}
+
+void InvokeDispatcher::InvalidateCache(MethodId method) {
+    cacheGeneration_++;
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        if (it->second.method == method) {
+            EraseCached(it++);
+        } else {
+            ++it;
+        }
+    }
+    
+    // Later calls must not join an execution that may have read stale data
+    for (auto it = sharedCalls_.begin(); it != sharedCalls_.end();) {
+        if (it->second->method == method) {
+            it = sharedCalls_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void InvokeDispatcher::InvalidateCache() {
+    cacheGeneration_++;
+    cache_.clear();
+    cacheOrder_.clear();
+    sharedCalls_.clear();
+}
+
+void InvokeDispatcher::SetMaxCachedResults(size_t maxResults) {
+    maxCachedResults_ = maxResults;
+    while (cache_.size() > maxResults) {
+        EraseCached(cache_.find(cacheOrder_.front()));
+    }
+}
+
+std::string InvokeDispatcher::CacheKey(const InvokeRequest& request) {
+    if (request.HasBinary()) {
+        return std::string();
+    }
+    
+    const MethodId id = request.GetMethodId();
+    std::string key(reinterpret_cast<const char*>(&id), sizeof(id));
+    
+    // Data that is not JSON is compared byte for byte
+    const std::string_view data = request.GetData();
+    if (!JsonCursor::IsValid(data.data(), data.data() + data.size())) {
+        key += '!';
+        key += data;
+        return key;
+    }
+    
+    key.reserve(key.size() + data.size());
+    AppendCanonical(data.data(), data.data() + data.size(), key, request.GetArena());
+    return key;
+}
+
+bool InvokeDispatcher::AnswerFromCache(InvokeChannel& channel, const std::string& key,
+                                       const InvokeRequest& request) {
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        return false;
+    }
+    if (it->second.expiresMs <= CancellationToken::NowMs()) {
+        EraseCached(it);
+        return false;
+    }
+    
+    InvokeResponse response(*it->second.response);
+    response.SetRequestId(request.GetRequestId());
+    callStats_.cacheHits++;
+    Metrics::GetInstance()->RecordReused(request.GetMethod(), true);
+    channel.SendResponse(response);
+    return true;
+}
+
+void InvokeDispatcher::StoreResult(const std::string& key, MethodId method, int ttlMs,
+                                   const InvokeResponse& response) {
+    if (ttlMs <= 0 || maxCachedResults_ == 0 || !response.IsSuccess()) {
+        return;
+    }
+    
+    const int64_t now = CancellationToken::NowMs();
+    auto existing = cache_.find(key);
+    if (existing != cache_.end()) {
+        EraseCached(existing);
+    }
+    
+    // Oldest first; with one TTL per method that is also soonest to expire
+    while (cache_.size() >= maxCachedResults_) {
+        EraseCached(cache_.find(cacheOrder_.front()));
+    }
+    
+    cacheOrder_.push_back(key);
+    cache_.emplace(key, CachedResult{std::make_shared<const InvokeResponse>(response), now + ttlMs,
+                                     method, std::prev(cacheOrder_.end())});
+}
+
+void InvokeDispatcher::EraseCached(std::unordered_map<std::string, CachedResult>::iterator it) {
+    cacheOrder_.erase(it->second.order);
+    cache_.erase(it);
+}
+
+void InvokeDispatcher::InvalidateAfter(const RegisteredHandler& handler, const InvokeResponse& response) {
+    if (!response.IsSuccess()) {
+        return;
+    }
+    for (const std::string& method : handler.options.invalidates) {
+        InvalidateCache(method);
+    }
+}
+
+void InvokeDispatcher::Complete(InvokeChannel& channel, const RegisteredHandler& handler,
+                                const std::shared_ptr<SharedCall>& shared,
+                                const InvokeResponse& response) {
+    if (shared) {
+        FinishShared(shared, handler, response);
+        return;
+    }
+    
+    // Whatever it changed is stale in the cache even if nobody waits
+    InvalidateAfter(handler, response);
+    
+    // Dropped if the call was cancelled or already answered with a 408
+    if (FinishInFlight(channel, response.GetRequestId())) {
+        channel.SendResponse(response);
+    }
+}
+
+void InvokeDispatcher::DetachShared(const std::shared_ptr<SharedCall>& call) {
+    auto it = sharedCalls_.find(call->key);
+    if (it != sharedCalls_.end() && it->second == call) {
+        sharedCalls_.erase(it);
+    }
+}
+
+void InvokeDispatcher::FinishShared(const std::shared_ptr<SharedCall>& call,
+                                    const RegisteredHandler& handler,
+                                    const InvokeResponse& response) {
+    DetachShared(call);
+    if (call->generation == cacheGeneration_) {
+        StoreResult(call->key, call->method, handler.options.cacheTtlMs, response);
+    }
+    
+    for (const auto& caller : call->callers) {
+        if (!FinishInFlight(*caller.first, caller.second)) {
+            continue;  // gave up or timed out on its own
+        }
+        if (caller.second == response.GetRequestId()) {
+            caller.first->SendResponse(response);
+        } else {
+            InvokeResponse copy(response);
+            copy.SetRequestId(caller.second);
+            caller.first->SendResponse(copy);
+        }
+    }
+}
+
+void InvokeDispatcher::RunHandler(const NativeHandler& handler,
+                                  const InvokeRequest& request,
+                                  InvokeResponse& response) {
+    CallSample sample;
+    const uint64_t start = Metrics::NowUs();
+    sample.queueUs = start - request.GetReceivedAt();
+    sample.bytesIn = request.GetData().size() + request.GetBinary().size;
+    
+    // Cancelled while queued: nobody is waiting for the work
+    if (request.IsCancelled()) {
+        response.SetCancelled(request.GetCancellation().GetReason());
+    } else {
+        try {
+            handler(request, response);
+        } catch (const std::exception& e) {
+            response.SetError("Handler exception: " + std::string(e.what()), 500);
+        }
+    }
+    
+    sample.execUs = Metrics::NowUs() - start;
+    sample.bytesOut = response.IsBinary() ? response.GetBinary().size : response.GetData().size();
+    sample.success = response.IsSuccess();
+    Metrics::GetInstance()->Record(request.GetMethod(), sample);
+}
+
+void InvokeDispatcher::RunAsync(std::shared_ptr<const RegisteredHandler> handler,
+                                std::shared_ptr<const InvokeRequest> request,
+                                std::function<void(const InvokeResponse& response)> done) {
+    const uint64_t start = Metrics::NowUs();
+    
+    // Holds the handler too: a lambda coroutine's captures live in it
+    auto finish = [handler, request, start, done](InvokeResponse& response) {
+        response.SetRequestId(request->GetRequestId());
+        
+        // Execution time is wall time, including every await
+        CallSample sample;
+        sample.queueUs = start - request->GetReceivedAt();
+        sample.execUs = Metrics::NowUs() - start;
+        sample.bytesIn = request->GetData().size() + request->GetBinary().size;
+        sample.bytesOut = response.IsBinary() ? response.GetBinary().size : response.GetData().size();
+        sample.success = response.IsSuccess();
+        Metrics::GetInstance()->Record(request->GetMethod(), sample);
+        
+        done(response);
+    };
+    
+    auto failed = [request, finish](std::exception_ptr error) {
+        InvokeResponse response(request->GetRequestId());
+        try {
+            std::rethrow_exception(error);
+        } catch (const InvokeError& e) {
+            response.SetError(e.what(), e.GetCode());
+        } catch (const std::exception& e) {
+            response.SetError("Handler exception: " + std::string(e.what()), 500);
+        } catch (...) {
+            response.SetError("Handler exception", 500);
+        }
+        finish(response);
+    };
+    
+    if (request->IsCancelled()) {
+        InvokeResponse response(request->GetRequestId());
+        response.SetCancelled(request->GetCancellation().GetReason());
+        finish(response);
+        return;
+    }
+    
+    Async::Task<InvokeResponse> task;
+    try {
+        task = handler->async(*request);
+    } catch (...) {
+        failed(std::current_exception());
+        return;
+    }
+    
+    Async::Spawn<InvokeResponse>(std::move(task), [finish](InvokeResponse response) {
+        finish(response);
+    }, failed);
+}
+
+void InvokeDispatcher::HandleMetrics(const InvokeRequest& request, InvokeResponse& response) {
+    response.SetSuccessJSON(Metrics::GetInstance()->ToJSON());
+    
+    bool reset = false;
+    if (request.GetParam("reset", reset) && reset) {
+        Metrics::GetInstance()->Reset();
+    }
+}
+
+bool InvokeDispatcher::TrackInFlight(const std::shared_ptr<InvokeChannel>& channel,
+                                     const InvokeRequest& request, int timeoutMs,
+                                     InvokeResponse& refusal,
+                                     std::shared_ptr<SharedCall> shared) {
+    const std::string& clientKey = channel->GetClientKey();
+    auto client = inFlightPerClient_.find(clientKey);
+    if (maxInFlightPerClient_ > 0 && client != inFlightPerClient_.end() &&
+        client->second.inFlight >= maxInFlightPerClient_) {
+        callStats_.busy++;
+        refusal.SetError("Server busy: too many calls in flight", 503);
+        return false;
+    }
+    if (client == inFlightPerClient_.end()) {
+        // An idle client has no keys in inFlight_, so its id can be retired
+        if (inFlightPerClient_.size() >= kMaxIdleClients) {
+            std::erase_if(inFlightPerClient_, [](const auto& entry) { return entry.second.inFlight == 0; });
+        }
+        client = inFlightPerClient_.emplace(clientKey, ClientCalls{nextClientId_++}).first;
+    }
+    
+    // Answering either call with the other's result would be wrong, and
+    // dropping the first one silently leaves its caller waiting
+    const uint64_t key = InFlightKey(client->second.id, request.GetRequestId());
+    if (inFlight_.count(key) != 0) {
+        refusal.SetError("Duplicate request id: " + std::to_string(request.GetRequestId()), 409);
+        return false;
+    }
+    
+    CancellationToken token = request.GetCancellation();
+    if (timeoutMs == 0) {
+        timeoutMs = defaultTimeoutMs_;
+    }
+    if (timeoutMs > 0) {
+        const int64_t deadline = CancellationToken::NowMs() + timeoutMs;
+        token.SetDeadline(deadline);
+        deadlines_.Schedule(key, deadline);
+        ScheduleTick();
+    }
+    
+    ++client->second.inFlight;
+    if (shared) {
+        shared->waiting++;
+    }
+    inFlight_.emplace(key, InFlightCall{channel, request.GetMethodId(), token, std::move(shared)});
+    return true;
+}
+
+bool InvokeDispatcher::FinishInFlight(const InvokeChannel& channel, int requestId) {
+    auto client = inFlightPerClient_.find(channel.GetClientKey());
+    if (client == inFlightPerClient_.end()) {
+        return false;
+    }
+    auto it = inFlight_.find(InFlightKey(client->second.id, requestId));
+    if (it == inFlight_.end()) {
+        return false;
+    }
+    EraseInFlight(it);
+    return true;
+}
+
+void InvokeDispatcher::EraseInFlight(InFlightMap::iterator it) {
+    // Kept at zero, so a client's next call does not copy its key again
+    auto client = inFlightPerClient_.find(it->second.channel->GetClientKey());
+    if (client != inFlightPerClient_.end() && client->second.inFlight > 0) {
+        --client->second.inFlight;
+    }
+    if (it->second.shared) {
+        it->second.shared->waiting--;
+    }
+    inFlight_.erase(it);
+}
+
+void InvokeDispatcher::AbandonInFlight(InFlightMap::iterator it) {
+    std::shared_ptr<SharedCall> shared = it->second.shared;
+    CancellationToken token = it->second.token;
+    EraseInFlight(it);
+    
+    if (!shared) {
+        token.Cancel();
+    } else if (shared->waiting == 0) {
+        shared->token.Cancel();
+        DetachShared(shared);
+    }
+}
+
+void InvokeDispatcher::ScheduleTick() {
+    // Ticks only while something can expire, so an idle app never wakes for it
+    if (tickScheduled_ || deadlines_.GetSize() == 0) {
+        return;
+    }
+    
+    tickScheduled_ = true;
+    Executor::PostDelayedToUI([this]() { OnTick(); }, deadlines_.GetTickMs());
+}
+
+void InvokeDispatcher::OnTick() {
+    tickScheduled_ = false;
+    
+    // Runaway worker-pool calls: answer now, let the handler notice later
+    std::vector<uint64_t> expired;
+    deadlines_.Advance(CancellationToken::NowMs(), expired);
+    for (uint64_t key : expired) {
+        auto it = inFlight_.find(key);
+        if (it == inFlight_.end() || !it->second.token.IsCancelled()) {
+            continue;  // answered already, or the key was reused by a later call
+        }
+        
+        InFlightCall call = it->second;
+        EraseInFlight(it);
+        call.token.Cancel(CancelReason::DeadlineExceeded);
+        if (call.shared && call.shared->token.IsCancelled()) {
+            DetachShared(call.shared);  // the shared execution is stopping
+        }
+        callStats_.timedOut++;
+        Logger::Warning("Invoke timed out: " + methods_.Read().GetName(call.method));
+        
+        InvokeResponse response(static_cast<int>(key & 0xFFFFFFFFu));
+        response.SetCancelled(CancelReason::DeadlineExceeded);
+        call.channel->SendResponse(response);
+    }
+    
+    ScheduleTick();
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
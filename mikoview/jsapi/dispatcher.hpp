@@ -0,0 +1,339 @@
+#pragma once
+
+#include "arena.hpp"
+#include "async.hpp"
+#include "events.hpp"
+#include "methodtable.hpp"
+#include "recorder.hpp"
+#include "request.hpp"
+#include "stream.hpp"
+#include "timerwheel.hpp"
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Deadline for worker-pool handlers that do not set their own
+constexpr int kDefaultInvokeTimeoutMs = 60000;
+
+// Worker-pool calls one client may have outstanding before it gets a 503
+constexpr size_t kDefaultMaxInFlightPerClient = 64;
+
+// Built-in method answering with Metrics::ToJSON(); { reset: true } clears
+// the counters after the snapshot
+constexpr char kMetricsMethod[] = "mikoview.metrics";
+
+// Worker-pool calls, across every transport
+struct InvokeCallStats {
+    size_t inFlight = 0;
+    uint64_t cancelled = 0;   // aborted by the caller or its session closed
+    uint64_t timedOut = 0;    // deadline passed before the handler answered
+    uint64_t busy = 0;        // refused: client limit reached or lane full
+    
+    // Idempotent methods, every affinity
+    size_t cached = 0;        // answers held in the result cache
+    uint64_t cacheHits = 0;   // answered from the cache
+    uint64_t cacheMisses = 0; // ran the handler
+    uint64_t coalesced = 0;   // joined an identical call already running
+};
+
+// Answers the result cache holds before the oldest are dropped
+constexpr size_t kDefaultMaxCachedResults = 1024;
+
+// Where a session's responses go: a CEF frame, a loopback caller, a socket
+// peer. Only called on the UI thread.
+class InvokeChannel {
+public:
+    virtual ~InvokeChannel() = default;
+    
+    // Calls are keyed by (session, request id). Browser ids are sessions for
+    // CEF; other transports take theirs from InvokeDispatcher::NewSessionId().
+    virtual int GetSessionId() const = 0;
+    
+    // The in-flight limit applies per client key (a frame for CEF)
+    virtual const std::string& GetClientKey() const = 0;
+    
+    virtual void SendResponse(const InvokeResponse& response) = 0;
+    
+    // Answers a batch at once; by default each response is sent on its own
+    virtual void SendBatchResponse(const std::vector<const InvokeResponse*>& responses);
+    
+    // data is null for End and Error
+    virtual void SendStreamMessage(int streamId, StreamEvent event, const std::string* data,
+                                   bool binary, const std::string& error, int code) = 0;
+    
+    // One EventHub flush worth of the client's subscriptions; transports
+    // without events drop them
+    virtual void SendEvents(const std::vector<EventDelivery>& deliveries);
+};
+
+// Transport-agnostic half of invoke: the handler registry, worker-pool
+// dispatch, deadlines, cancellation and streams. Has no CEF dependency;
+// transports decode their wire format into InvokeRequests and hand them here
+// together with the channel that carries the answer back.
+//
+// Registration is safe from any thread at any time; everything else runs on
+// the UI thread (Executor::PostToUI), which is TID_UI under CEF.
+class InvokeDispatcher {
+public:
+    static InvokeDispatcher* GetInstance();
+    
+    void RegisterHandler(const std::string& method, NativeHandler handler,
+                         HandlerOptions options = HandlerOptions());
+    void UnregisterHandler(const std::string& method);
+    
+    // Coroutine handlers run on the UI thread, suspending at each co_await
+    // (Async::RunOn, Async::Delay, Async::ReadFile, another Task) so the UI
+    // thread is free while they wait. The affinity in options is ignored;
+    // deadlines, the in-flight limit and caching apply as for worker-pool
+    // handlers. The request stays valid, and the handler alive, until the
+    // task finishes.
+    //
+    //   RegisterAsyncHandler("doc.render", [](const InvokeRequest& request) -> Async::Task<InvokeResponse> {
+    //       std::string text = co_await Async::ReadFile(path);
+    //       ...
+    //   });
+    void RegisterAsyncHandler(const std::string& method, AsyncHandler handler,
+                              HandlerOptions options = HandlerOptions());
+    
+    // Streaming handlers always run on a worker pool (UI affinity is treated
+    // as IO) because writes block for credit
+    void RegisterStreamHandler(const std::string& method, StreamHandler handler,
+                               HandlerOptions options = HandlerAffinity::IO);
+    void UnregisterStreamHandler(const std::string& method);
+    
+    // Interned id of a registered method, for transports that let the peer
+    // send ids instead of names; kNoMethodId if unknown. Ids stay valid for
+    // the life of the process, even across Unregister/Register. UI thread.
+    MethodId FindMethod(const std::string& method);
+    
+    // Requests may name their method or carry its id (InvokeRequest::SetMethodId)
+    void Dispatch(std::shared_ptr<InvokeChannel> channel, InvokeRequest request);
+    
+    // Dispatches every request (non-UI handlers in parallel) and answers
+    // with one SendBatchResponse once all have finished
+    void DispatchBatch(std::shared_ptr<InvokeChannel> channel, std::vector<InvokeRequest> requests);
+    
+    // The request id doubles as the stream id
+    void OpenStream(std::shared_ptr<InvokeChannel> channel, InvokeRequest request,
+                    size_t chunkSize, int credits);
+    void AckStream(int sessionId, const std::string& clientKey, int streamId, int credits);
+    void CancelStream(int sessionId, const std::string& clientKey, int streamId);
+    
+    // The caller gave up; the handler's token is cancelled and its answer
+    // dropped. Request ids are only unique per client, hence the client key.
+    void Cancel(int sessionId, const std::string& clientKey, int requestId);
+    
+    // Cancels every call and stream the session has outstanding, drops its
+    // event subscriptions and closes the files it left open
+    void CloseSession(int sessionId);
+    
+    // Session ids for non-CEF transports; negative, so never a browser id
+    static int NewSessionId();
+    
+    // Deadline for worker-pool handlers registered without one; 0 disables
+    void SetDefaultTimeout(int timeoutMs) { defaultTimeoutMs_ = timeoutMs; }
+    
+    // Worker-pool calls a client may have outstanding; 0 disables the limit
+    void SetMaxInFlightPerClient(size_t maxInFlight) { maxInFlightPerClient_ = maxInFlight; }
+    
+    // Drops cached answers of one method, or of every method. Calls of it
+    // already running still answer their callers but are not cached.
+    void InvalidateCache(const std::string& method);
+    void InvalidateCache();
+    
+    // 0 disables the result cache; coalescing still applies
+    void SetMaxCachedResults(size_t maxResults);
+    
+    InvokeCallStats GetInvokeCallStats() const;
+    
+    // Logs every call, batch and stream dispatched from now on, with its
+    // payload, arrival time and client, for `invokehost replay`. Stops by
+    // itself after maxBytes (0 = no limit). Any thread.
+    bool StartRecording(const std::string& path, uint64_t maxBytes = 0, std::string* error = nullptr) {
+        return recorder_.Start(path, maxBytes, error);
+    }
+    void StopRecording() { recorder_.Stop(); }
+    
+private:
+    InvokeDispatcher() = default;
+    
+    // Exactly one of handler and async is set
+    struct RegisteredHandler {
+        NativeHandler handler;
+        HandlerOptions options;
+        AsyncHandler async;
+    };
+    
+    struct RegisteredStreamHandler {
+        StreamHandler handler;
+        HandlerOptions options;
+    };
+    
+    // Both kinds share one id space; either may be unset. Shared so table
+    // copies stay cheap and a running call keeps its handler alive.
+    struct MethodHandlers {
+        std::shared_ptr<const RegisteredHandler> call;
+        std::shared_ptr<const RegisteredStreamHandler> stream;
+    };
+    
+    // One execution of an idempotent worker-pool call and every caller
+    // waiting for it. The first caller's token (and deadline) drives the
+    // handler; it is cancelled only once no caller is left.
+    struct SharedCall {
+        std::string key;
+        MethodId method;
+        CancellationToken token;
+        std::vector<std::pair<std::shared_ptr<InvokeChannel>, int>> callers;
+        size_t waiting = 0;       // callers still in inFlight_
+        uint64_t generation = 0;  // cacheGeneration_ when it started
+    };
+    
+    struct CachedResult {
+        std::shared_ptr<const InvokeResponse> response;
+        int64_t expiresMs;
+        MethodId method;
+        std::list<std::string>::iterator order;  // into cacheOrder_
+    };
+    
+    // A worker-pool call that has not been answered yet
+    struct InFlightCall {
+        std::shared_ptr<InvokeChannel> channel;
+        MethodId method;
+        CancellationToken token;
+        std::shared_ptr<SharedCall> shared;  // idempotent calls only
+    };
+    
+    // Nodes come and go with every call, so they are pooled
+    using InFlightMap = std::map<uint64_t, InFlightCall, std::less<uint64_t>,
+                                 PoolAllocator<std::pair<const uint64_t, InFlightCall>>>;
+    
+    // A worker-pool call on its way to a pool and back. The tasks posted for
+    // it capture just this pointer, which fits in std::function's inline
+    // storage; it is deleted on the UI thread once the handler has answered.
+    struct PendingCall {
+        static void* operator new(size_t size) { return BlockPool::Allocate(size); }
+        static void operator delete(void* block, size_t size) noexcept { BlockPool::Deallocate(block, size); }
+        
+        InvokeRequest request;
+        InvokeResponse response;
+        std::shared_ptr<const RegisteredHandler> handler;
+        std::shared_ptr<InvokeChannel> channel;
+        std::shared_ptr<SharedCall> shared;
+    };
+    
+    MethodTable<MethodHandlers> methods_;
+    
+    // Open streams keyed by (session id, client key, stream id); stream ids
+    // are request ids, so only unique per client
+    using StreamKey = std::tuple<int, std::string, int>;
+    std::map<StreamKey, std::shared_ptr<StreamWriter>> streams_;
+    
+    // Worker-pool calls keyed by InFlightKey()
+    InFlightMap inFlight_;
+    // Every client with calls in flight gets a small id for InFlightKey();
+    // idle clients stay at zero until pruned in bulk (see TrackInFlight)
+    struct ClientCalls {
+        uint32_t id;
+        size_t inFlight = 0;
+    };
+    std::map<std::string, ClientCalls> inFlightPerClient_;
+    uint32_t nextClientId_ = 0;
+    TimerWheel deadlines_{50, 256};
+    bool tickScheduled_ = false;
+    int defaultTimeoutMs_ = kDefaultInvokeTimeoutMs;
+    size_t maxInFlightPerClient_ = kDefaultMaxInFlightPerClient;
+    InvokeCallStats callStats_;
+    InvokeRecorder recorder_;
+    
+    // Idempotent calls keyed by CacheKey()
+    std::unordered_map<std::string, std::shared_ptr<SharedCall>> sharedCalls_;
+    std::unordered_map<std::string, CachedResult> cache_;
+    std::list<std::string> cacheOrder_;  // keys, oldest first
+    size_t maxCachedResults_ = kDefaultMaxCachedResults;
+    // Bumped by every invalidation; calls that started before one are not
+    // cached, whichever method they belong to
+    uint64_t cacheGeneration_ = 0;
+    
+    static std::atomic<int> nextSessionId_;
+    
+    // Runs the handler and records its metrics
+    static void RunHandler(const NativeHandler& handler,
+                           const InvokeRequest& request,
+                           InvokeResponse& response);
+    // Starts the handler's coroutine; done runs on the UI thread, possibly
+    // before this returns
+    static void RunAsync(std::shared_ptr<const RegisteredHandler> handler,
+                         std::shared_ptr<const InvokeRequest> request,
+                         std::function<void(const InvokeResponse& response)> done);
+    static void HandleMetrics(const InvokeRequest& request, InvokeResponse& response);
+    
+    // Looks the request's method up by id or name and interns its name into
+    // the request; null if nothing is registered under it
+    const MethodHandlers* Resolve(InvokeRequest& request);
+    static std::string NotFound(const InvokeRequest& request);
+    
+    // Method id plus the canonical form of the request data; empty for
+    // requests that must run (binary payload)
+    static std::string CacheKey(const InvokeRequest& request);
+    
+    // Answers the caller from the cache if a live entry exists
+    bool AnswerFromCache(InvokeChannel& channel, const std::string& key,
+                         const InvokeRequest& request);
+    // Successful answers only, for ttlMs
+    void StoreResult(const std::string& key, MethodId method, int ttlMs,
+                     const InvokeResponse& response);
+    // Applies handler's `invalidates` after a successful call
+    void InvalidateAfter(const RegisteredHandler& handler, const InvokeResponse& response);
+    void InvalidateCache(MethodId method);
+    void EraseCached(std::unordered_map<std::string, CachedResult>::iterator it);
+    
+    // Answers a worker-pool or async call once its handler is done
+    void Complete(InvokeChannel& channel, const RegisteredHandler& handler,
+                  const std::shared_ptr<SharedCall>& shared,
+                  const InvokeResponse& response);
+    
+    // Stops new callers from joining call
+    void DetachShared(const std::shared_ptr<SharedCall>& call);
+    // Sends the answer of a shared execution to each caller still waiting
+    void FinishShared(const std::shared_ptr<SharedCall>& call,
+                      const RegisteredHandler& handler,
+                      const InvokeResponse& response);
+    
+    struct BatchState;
+    void FinishBatch(InvokeChannel& channel, BatchState& batch);
+    
+    // Request ids come from each client's own counter: frames of one browser,
+    // the legacy script path and socket clients all start at 1
+    static uint64_t InFlightKey(uint32_t clientId, int requestId) {
+        return (static_cast<uint64_t>(clientId) << 32) | static_cast<uint32_t>(requestId);
+    }
+    
+    // Registers a worker-pool call and arms its deadline. Returns false, and
+    // tracks nothing, when the client is at its in-flight limit (503) or
+    // already has a call with this id running (409); `refusal` then holds
+    // the answer to send.
+    bool TrackInFlight(const std::shared_ptr<InvokeChannel>& channel,
+                       const InvokeRequest& request, int timeoutMs,
+                       InvokeResponse& refusal,
+                       std::shared_ptr<SharedCall> shared = nullptr);
+    // True if the call was still waiting for its answer (and now is not)
+    bool FinishInFlight(const InvokeChannel& channel, int requestId);
+    void EraseInFlight(InFlightMap::iterator it);
+    // Cancel() and CloseSession(): the call's token is cancelled, unless it
+    // shares an execution other callers still wait for
+    void AbandonInFlight(InFlightMap::iterator it);
+    
+    void ScheduleTick();
+    void OnTick();
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
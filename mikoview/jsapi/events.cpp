@@ -0,0 +1,233 @@
+#include "events.hpp"
+#include "dispatcher.hpp"
+#include "executor.hpp"
+#include "jsonwriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+constexpr int kMaxStressDurationMs = 10000;
+
+} // namespace
+
+EventHub* EventHub::GetInstance() {
+    static EventHub instance;
+    return &instance;
+}
+
+void EventHub::Publish(const std::string& topic, std::string json) {
+    bool schedule = false;
+    int delayMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.published++;
+        auto it = topics_.find(topic);
+        if (it == topics_.end()) {
+            return;
+        }
+
+        const auto& subscriptions = it->second;
+        for (size_t i = 0; i < subscriptions.size(); ++i) {
+            Subscription& subscription = *subscriptions[i];
+            if (subscription.policy == EventPolicy::Latest && !subscription.pending.empty()) {
+                stats_.coalesced++;
+                subscription.pending.back() = i + 1 == subscriptions.size() ? std::move(json) : json;
+                continue;
+            }
+            if (subscription.policy != EventPolicy::Latest && subscription.pending.size() >= subscription.cap) {
+                subscription.dropped++;
+                stats_.dropped++;
+                continue;
+            }
+
+            // The last subscriber takes the string itself
+            subscription.pending.push_back(i + 1 == subscriptions.size() ? std::move(json) : json);
+            if (!subscription.dirty) {
+                subscription.dirty = true;
+                dirty_.push_back(subscriptions[i]);
+            }
+        }
+
+        if (!dirty_.empty() && !flushScheduled_) {
+            flushScheduled_ = true;
+            schedule = true;
+            delayMs = flushIntervalMs_;
+        }
+    }
+
+    if (schedule) {
+        Executor::PostDelayedToUI([this]() { Flush(); }, delayMs);
+    }
+}
+
+void EventHub::Subscribe(std::shared_ptr<InvokeChannel> channel, int subscriptionId,
+                         const std::string& topic, EventPolicy policy, size_t cap) {
+    SubscriptionKey key(channel->GetSessionId(), channel->GetClientKey(), subscriptionId);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto existing = subscriptions_.find(key);
+    if (existing != subscriptions_.end()) {
+        RemoveLocked(existing);
+    }
+
+    // Subscriptions of one client share a channel, so a flush can hand it
+    // all of theirs at once
+    auto first = subscriptions_.lower_bound({std::get<0>(key), std::get<1>(key), INT_MIN});
+    if (first != subscriptions_.end() && std::get<0>(first->first) == std::get<0>(key) &&
+        std::get<1>(first->first) == std::get<1>(key)) {
+        channel = first->second->channel;
+    }
+
+    auto subscription = std::make_shared<Subscription>();
+    subscription->channel = std::move(channel);
+    subscription->subscriptionId = subscriptionId;
+    subscription->topic = topic;
+    subscription->policy = policy;
+    subscription->cap = cap ? cap : kDefaultEventCap;
+    topics_[topic].push_back(subscription);
+    subscriptions_.emplace(std::move(key), std::move(subscription));
+}
+
+void EventHub::Unsubscribe(int sessionId, const std::string& clientKey, int subscriptionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subscriptions_.find({sessionId, clientKey, subscriptionId});
+    if (it != subscriptions_.end()) {
+        RemoveLocked(it);
+    }
+}
+
+void EventHub::CloseSession(int sessionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subscriptions_.lower_bound({sessionId, std::string(), INT_MIN});
+    while (it != subscriptions_.end() && std::get<0>(it->first) == sessionId) {
+        RemoveLocked(it++);
+    }
+}
+
+void EventHub::SetFlushInterval(int intervalMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushIntervalMs_ = std::max(intervalMs, 0);
+}
+
+EventHubStats EventHub::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EventHubStats stats = stats_;
+    stats.subscriptions = subscriptions_.size();
+    return stats;
+}
+
+void EventHub::RemoveLocked(std::map<SubscriptionKey, std::shared_ptr<Subscription>>::iterator it) {
+    std::shared_ptr<Subscription> subscription = std::move(it->second);
+    subscriptions_.erase(it);
+
+    // A flush already under way skips it
+    subscription->removed = true;
+    subscription->pending.clear();
+
+    auto topic = topics_.find(subscription->topic);
+    if (topic != topics_.end()) {
+        auto& list = topic->second;
+        list.erase(std::remove(list.begin(), list.end(), subscription), list.end());
+        if (list.empty()) {
+            topics_.erase(topic);
+        }
+    }
+}
+
+void EventHub::Flush() {
+    // One entry per client, in the order their events came in
+    std::vector<std::pair<std::shared_ptr<InvokeChannel>, std::vector<EventDelivery>>> clients;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushScheduled_ = false;
+
+        std::vector<std::shared_ptr<Subscription>> dirty;
+        dirty.swap(dirty_);
+        for (const auto& subscription : dirty) {
+            subscription->dirty = false;
+            if (subscription->removed) {
+                continue;
+            }
+
+            auto client = std::find_if(clients.begin(), clients.end(), [&subscription](const auto& entry) {
+                return entry.first == subscription->channel;
+            });
+            if (client == clients.end()) {
+                clients.emplace_back(subscription->channel, std::vector<EventDelivery>());
+                client = clients.end() - 1;
+            }
+
+            stats_.delivered += subscription->pending.size();
+            client->second.push_back(EventDelivery{subscription->subscriptionId, subscription->dropped,
+                                                   std::move(subscription->pending)});
+            subscription->pending.clear();
+            subscription->dropped = 0;
+        }
+        stats_.flushes += clients.size();
+    }
+
+    for (const auto& client : clients) {
+        client.first->SendEvents(client.second);
+    }
+}
+
+void EventHub::RegisterStressHandler() {
+    InvokeDispatcher::GetInstance()->RegisterHandler(kEventStressMethod, HandleStress, HandlerAffinity::IO);
+}
+
+void EventHub::HandleStress(const InvokeRequest& request, InvokeResponse& response) {
+    std::string topic = std::string(kEventStressTopicPrefix) + "default";
+    int rate = 10000;
+    int durationMs = 1000;
+    request.GetParam("topic", topic);
+    request.GetParam("rate", rate);
+    request.GetParam("durationMs", durationMs);
+    if (topic.rfind(kEventStressTopicPrefix, 0) != 0) {
+        response.SetError("topic must start with " + std::string(kEventStressTopicPrefix), 400);
+        return;
+    }
+    if (rate <= 0) {
+        response.SetError("rate must be positive", 400);
+        return;
+    }
+    durationMs = std::clamp(durationMs, 0, kMaxStressDurationMs);
+
+    // Catches up on whatever is due after each sleep, so the rate holds even
+    // where sleeps are coarser than the interval between events
+    EventHub* hub = GetInstance();
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::milliseconds(durationMs);
+    uint64_t published = 0;
+    JsonWriter event(32);
+    while (!request.IsCancelled()) {
+        const auto now = std::chrono::steady_clock::now();
+        const uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::min(now, end) - start).count();
+        const uint64_t due = elapsedUs * static_cast<uint64_t>(rate) / 1000000;
+        while (published < due) {
+            event.Clear();
+            event.BeginObject();
+            event.Key("seq").UInt(published++);
+            event.EndObject();
+            hub->Publish(topic, event.GetString());
+        }
+        if (now >= end) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    JsonWriter result;
+    result.BeginObject();
+    result.Key("published").UInt(published);
+    result.EndObject();
+    response.SetSuccessJSON(result.Release());
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
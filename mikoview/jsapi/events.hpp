@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+class InvokeChannel;
+class InvokeRequest;
+class InvokeResponse;
+
+// How a subscription's events are held between flushes
+enum class EventPolicy {
+    Latest = 0,  // only the newest event is kept
+    Frame = 1,   // every event, handed to the listener once per animation frame
+    Queue = 2    // every event, handed to the listener one by one
+};
+
+// One subscription's share of a flush
+struct EventDelivery {
+    int subscriptionId;
+    uint64_t dropped;                 // events over the cap since the last delivery
+    std::vector<std::string> events;  // JSON, oldest first
+};
+
+struct EventHubStats {
+    size_t subscriptions = 0;
+    uint64_t published = 0;
+    uint64_t coalesced = 0;  // replaced by a newer event (Latest)
+    uint64_t dropped = 0;    // over a subscription's cap (Frame, Queue)
+    uint64_t delivered = 0;
+    uint64_t flushes = 0;    // SendEvents calls
+};
+
+// Pending flushes run this often while anything is waiting
+constexpr int kDefaultEventFlushMs = 16;
+
+// Events a Frame or Queue subscription holds between flushes
+constexpr size_t kDefaultEventCap = 1024;
+
+// Publishes a synthetic event stream, for measuring delivery under load:
+// { topic, rate: per second, durationMs } answers { published }. Not
+// registered by default; see EventHub::RegisterStressHandler().
+constexpr char kEventStressMethod[] = "mikoview.events.stress";
+
+// The only topics kEventStressMethod publishes to, so a page cannot flood
+// real subscribers with it
+constexpr char kEventStressTopicPrefix[] = "mikoview.stress.";
+
+// Native-to-renderer events by topic. Publishing only queues the event on
+// each subscriber; a flush on the UI thread, at most every flush interval,
+// hands each client everything it is owed in one SendEvents call. A topic
+// published at 10 kHz therefore costs a renderer one message per flush,
+// not one script per event.
+//
+// Publish is callable from any thread; the rest runs on the UI thread.
+class EventHub {
+public:
+    static EventHub* GetInstance();
+
+    // json must be a JSON value
+    void Publish(const std::string& topic, std::string json);
+
+    // Ids are chosen by the subscriber and unique only within its client
+    // (one frame of a browser, one socket connection); resubscribing with a
+    // live id replaces that subscription. cap applies to Frame and Queue;
+    // 0 means kDefaultEventCap.
+    void Subscribe(std::shared_ptr<InvokeChannel> channel, int subscriptionId,
+                   const std::string& topic, EventPolicy policy, size_t cap = 0);
+    void Unsubscribe(int sessionId, const std::string& clientKey, int subscriptionId);
+
+    // Drops the session's subscriptions along with anything still queued
+    void CloseSession(int sessionId);
+
+    void SetFlushInterval(int intervalMs);
+
+    EventHubStats GetStats() const;
+
+    // Registers kEventStressMethod with the dispatcher. For benchmark hosts
+    // and debug builds only: any page can call it to publish at up to
+    // whatever rate it asks for.
+    static void RegisterStressHandler();
+
+    // Handler for kEventStressMethod
+    static void HandleStress(const InvokeRequest& request, InvokeResponse& response);
+
+private:
+    EventHub() = default;
+
+    struct Subscription {
+        std::shared_ptr<InvokeChannel> channel;
+        int subscriptionId;
+        std::string topic;
+        EventPolicy policy;
+        size_t cap;
+        std::vector<std::string> pending;
+        uint64_t dropped = 0;
+        bool dirty = false;      // listed in dirty_
+        bool removed = false;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Subscription>>> topics_;
+    // Keyed by (session id, client key, subscription id)
+    using SubscriptionKey = std::tuple<int, std::string, int>;
+    std::map<SubscriptionKey, std::shared_ptr<Subscription>> subscriptions_;
+    // Subscriptions with something to deliver, in the order they got it
+    std::vector<std::shared_ptr<Subscription>> dirty_;
+    bool flushScheduled_ = false;
+    int flushIntervalMs_ = kDefaultEventFlushMs;
+    EventHubStats stats_;
+
+    void RemoveLocked(std::map<SubscriptionKey, std::shared_ptr<Subscription>>::iterator it);
+    void Flush();
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
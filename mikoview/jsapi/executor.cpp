@@ -0,0 +1,485 @@
+#include "executor.hpp"
+#include "../logger.hpp"
+#include <algorithm>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+// Identifies the pool/worker the current thread belongs to
+thread_local WorkStealingPool* t_pool = nullptr;
+thread_local size_t t_worker = 0;
+
+void RunTask(Task& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        Logger::Error("Executor task threw: " + std::string(e.what()));
+    } catch (...) {
+        Logger::Error("Executor task threw an unknown exception");
+    }
+}
+
+} // namespace
+
+// WorkStealingPool implementation
+WorkStealingPool::WorkStealingPool(size_t threads)
+    : pending_(0), next_(0), executed_(0), steals_(0), stop_(false) {
+    threads = (std::max<size_t>)(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    Shutdown();
+}
+
+void WorkStealingPool::Submit(Task task) {
+    const size_t index = t_pool == this
+        ? t_worker
+        : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+    
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        if (stop_.exchange(true)) {
+            return;
+        }
+    }
+    wake_.notify_all();
+    
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+bool WorkStealingPool::PopLocal(size_t index, Task& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::Steal(size_t index, Task& task) {
+    const size_t count = workers_.size();
+    for (size_t offset = 1; offset < count; ++offset) {
+        Worker& victim = *workers_[(index + offset) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+    t_pool = this;
+    t_worker = index;
+    
+    while (true) {
+        Task task;
+        if (PopLocal(index, task) || Steal(index, task)) {
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            RunTask(task);
+            executed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        if (stop_.load() && pending_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+        wake_.wait(lock, [this]() {
+            return stop_.load() || pending_.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+// BoundedPool implementation
+BoundedPool::BoundedPool(size_t threads)
+    : stop_(false), executed_(0) {
+    threads = (std::max<size_t>)(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&BoundedPool::WorkerLoop, this);
+    }
+}
+
+BoundedPool::~BoundedPool() {
+    Shutdown();
+}
+
+bool BoundedPool::Submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void BoundedPool::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+            return;
+        }
+        stop_ = true;
+    }
+    wake_.notify_all();
+    
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+size_t BoundedPool::GetQueueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void BoundedPool::WorkerLoop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        RunTask(task);
+        executed_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// PriorityLanes implementation
+PriorityLanes::PriorityLanes(size_t window, size_t laneCapacity,
+                             const std::array<int, kInvokePriorityCount>& weights, Dispatch dispatch)
+    : window_((std::max<size_t>)(window, 1)),
+      capacity_((std::max<size_t>)(laneCapacity, 1)),
+      weights_(weights),
+      current_(),
+      dispatch_(std::move(dispatch)),
+      running_(0),
+      stopped_(false),
+      rejected_(0) {
+    for (int& weight : weights_) {
+        weight = (std::max)(weight, 1);
+    }
+}
+
+bool PriorityLanes::Submit(InvokePriority priority, Task task) {
+    const size_t lane = static_cast<size_t>(priority);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) {
+            return false;
+        }
+        
+        // Every worker busy: wait in the lane instead of the pool's FIFO
+        if (running_ >= window_) {
+            if (lanes_[lane].size() >= capacity_) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            lanes_[lane].push_back(std::move(task));
+            return true;
+        }
+        ++running_;
+    }
+    
+    Release(std::move(task));
+    return true;
+}
+
+void PriorityLanes::Shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    for (auto& lane : lanes_) {
+        lane.clear();
+    }
+}
+
+size_t PriorityLanes::GetDepth(InvokePriority priority) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lanes_[static_cast<size_t>(priority)].size();
+}
+
+void PriorityLanes::Release(Task task) {
+    // The slot is handed straight to the next task when this one finishes.
+    // A pool only refuses once it is shut down, when queued tasks are
+    // dropped anyway; the slot must still come back or the lanes stall.
+    while (!dispatch_([this, task = std::move(task)]() mutable {
+        RunTask(task);
+        OnTaskDone();
+    })) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || !PickNext(task)) {
+            --running_;
+            return;
+        }
+    }
+}
+
+void PriorityLanes::OnTaskDone() {
+    Task next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_ || !PickNext(next)) {
+            --running_;
+            return;
+        }
+    }
+    Release(std::move(next));
+}
+
+bool PriorityLanes::PickNext(Task& task) {
+    // Smooth weighted round robin over the non-empty lanes
+    int total = 0;
+    int best = -1;
+    for (size_t i = 0; i < kInvokePriorityCount; ++i) {
+        if (lanes_[i].empty()) {
+            continue;
+        }
+        current_[i] += weights_[i];
+        total += weights_[i];
+        if (best < 0 || current_[i] > current_[best]) {
+            best = static_cast<int>(i);
+        }
+    }
+    
+    if (best < 0) {
+        return false;
+    }
+    
+    current_[best] -= total;
+    task = std::move(lanes_[best].front());
+    lanes_[best].pop_front();
+    return true;
+}
+
+// SerialThread implementation
+SerialThread::SerialThread() : sequence_(0), stop_(false) {
+    thread_ = std::thread(&SerialThread::Loop, this);
+}
+
+SerialThread::~SerialThread() {
+    Shutdown();
+}
+
+void SerialThread::Post(Task task, int64_t delay_ms) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+            return;
+        }
+        const auto due = std::chrono::steady_clock::now() + std::chrono::milliseconds((std::max)(delay_ms, int64_t(0)));
+        tasks_.push(Item{due, sequence_++, std::move(task)});
+    }
+    wake_.notify_one();
+}
+
+void SerialThread::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        tasks_ = decltype(tasks_)();
+    }
+    wake_.notify_one();
+    if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+        thread_.join();
+    }
+}
+
+void SerialThread::Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (tasks_.empty()) {
+            wake_.wait(lock);
+            continue;
+        }
+        
+        // A task posted meanwhile may be due sooner; re-check on every wake
+        const auto due = tasks_.top().due;
+        if (due > std::chrono::steady_clock::now()) {
+            wake_.wait_until(lock, due);
+            continue;
+        }
+        
+        // top() is const; the item is popped right after
+        Task task = std::move(const_cast<Item&>(tasks_.top()).task);
+        tasks_.pop();
+        lock.unlock();
+        RunTask(task);
+        lock.lock();
+    }
+}
+
+// Executor implementation
+Executor* Executor::GetInstance() {
+    static Executor instance;
+    return &instance;
+}
+
+void Executor::Configure(const ExecutorConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_.load()) {
+        Logger::Warning("Executor already started; configuration ignored");
+        return;
+    }
+    config_ = config;
+}
+
+void Executor::EnsureStarted() {
+    if (started_.load(std::memory_order_acquire)) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_.load()) {
+        return;
+    }
+    
+    int cpu_threads = config_.cpu_threads;
+    if (cpu_threads <= 0) {
+        cpu_threads = (std::max)(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    
+    const size_t io_threads = static_cast<size_t>((std::max)(1, config_.io_threads));
+    
+    // The lanes keep at most one task per worker inside each pool, so the
+    // pools' own queues stay short and ordering is decided by priority
+    cpu_pool_ = std::make_unique<WorkStealingPool>(static_cast<size_t>(cpu_threads));
+    io_pool_ = std::make_unique<BoundedPool>(io_threads);
+    
+    WorkStealingPool* cpu_pool = cpu_pool_.get();
+    BoundedPool* io_pool = io_pool_.get();
+    cpu_lanes_ = std::make_unique<PriorityLanes>(
+        static_cast<size_t>(cpu_threads), config_.cpu_queue_limit, config_.priority_weights,
+        [cpu_pool](Task task) {
+            cpu_pool->Submit(std::move(task));
+            return true;
+        });
+    io_lanes_ = std::make_unique<PriorityLanes>(
+        io_threads, config_.io_queue_limit, config_.priority_weights,
+        [io_pool](Task task) { return io_pool->Submit(std::move(task)); });
+    started_.store(true, std::memory_order_release);
+    
+    Logger::Info("Executor started: " + std::to_string(cpu_threads) + " CPU workers, " +
+                 std::to_string(config_.io_threads) + " IO workers");
+}
+
+bool Executor::Post(HandlerAffinity affinity, Task task, InvokePriority priority) {
+    switch (affinity) {
+        case HandlerAffinity::UI:
+            PostToUI(std::move(task));
+            return true;
+        case HandlerAffinity::CPU:
+            EnsureStarted();
+            return cpu_lanes_->Submit(priority, std::move(task));
+        case HandlerAffinity::IO:
+            EnsureStarted();
+            return io_lanes_->Submit(priority, std::move(task));
+    }
+    return false;
+}
+
+void Executor::PostToUI(Task task) {
+    GetInstance()->PostUI(std::move(task), 0);
+}
+
+void Executor::PostDelayedToUI(Task task, int64_t delay_ms) {
+    GetInstance()->PostUI(std::move(task), delay_ms);
+}
+
+void Executor::SetUIPoster(UIPoster poster) {
+    GetInstance()->ui_poster_ = std::move(poster);
+}
+
+void Executor::PostUI(Task task, int64_t delay_ms) {
+    if (ui_poster_) {
+        ui_poster_(std::move(task), delay_ms);
+        return;
+    }
+    
+    std::call_once(ui_thread_once_, [this]() { ui_thread_ = std::make_unique<SerialThread>(); });
+    ui_thread_->Post(std::move(task), delay_ms);
+}
+
+ExecutorStats Executor::GetStats() const {
+    ExecutorStats stats;
+    if (!started_.load(std::memory_order_acquire)) {
+        return stats;
+    }
+    
+    stats.cpu_queue_depth = cpu_pool_->GetQueueDepth();
+    stats.cpu_executed = cpu_pool_->GetExecutedCount();
+    stats.cpu_rejected = cpu_lanes_->GetRejectedCount();
+    stats.steals = cpu_pool_->GetStealCount();
+    stats.io_queue_depth = io_pool_->GetQueueDepth();
+    stats.io_executed = io_pool_->GetExecutedCount();
+    stats.io_rejected = io_lanes_->GetRejectedCount();
+    
+    for (size_t i = 0; i < kInvokePriorityCount; ++i) {
+        const InvokePriority priority = static_cast<InvokePriority>(i);
+        const size_t cpu = cpu_lanes_->GetDepth(priority);
+        const size_t io = io_lanes_->GetDepth(priority);
+        stats.queued_by_priority[i] = cpu + io;
+        stats.cpu_queue_depth += cpu;
+        stats.io_queue_depth += io;
+    }
+    return stats;
+}
+
+void Executor::Shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_.load()) {
+        cpu_lanes_->Shutdown();
+        io_lanes_->Shutdown();
+        cpu_pool_->Shutdown();
+        io_pool_->Shutdown();
+    }
+    
+    // Workers are gone, so nothing posts to it any more
+    if (ui_thread_) {
+        ui_thread_->Shutdown();
+    }
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
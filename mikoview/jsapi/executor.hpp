@@ -0,0 +1,241 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Where an invoke handler runs
+enum class HandlerAffinity {
+    UI,   // inline on the browser UI thread (cheap, non-blocking handlers)
+    CPU,  // work-stealing pool sized to the machine
+    IO    // bounded pool for blocking file system / network calls
+};
+
+// Scheduling class of a pool task (normally an invoke call)
+enum class InvokePriority {
+    Interactive = 0,  // the user is waiting on it (keystrokes, clicks)
+    Normal = 1,
+    Background = 2    // prefetch, indexing, thumbnails
+};
+
+constexpr size_t kInvokePriorityCount = 3;
+
+using Task = std::function<void()>;
+
+// Runs a task on the UI thread after delay_ms (0 = as soon as possible)
+using UIPoster = std::function<void(Task task, int64_t delay_ms)>;
+
+struct ExecutorConfig {
+    int cpu_threads = 0;            // 0 = hardware concurrency - 1 (at least 1)
+    int io_threads = 4;
+    size_t io_queue_limit = 256;    // queued IO tasks per priority lane before Post() refuses
+    size_t cpu_queue_limit = 4096;  // same, for the CPU pool
+    
+    // Share of freed worker slots each lane gets while several are backed up
+    std::array<int, kInvokePriorityCount> priority_weights = {{8, 3, 1}};
+};
+
+struct ExecutorStats {
+    size_t cpu_queue_depth = 0;
+    size_t io_queue_depth = 0;
+    std::array<size_t, kInvokePriorityCount> queued_by_priority = {};
+    uint64_t cpu_executed = 0;
+    uint64_t io_executed = 0;
+    uint64_t steals = 0;
+    uint64_t cpu_rejected = 0;
+    uint64_t io_rejected = 0;
+};
+
+// Fixed set of workers, each with its own deque. Workers pop their own
+// deque LIFO and steal FIFO from the others when it runs dry. Tasks
+// submitted from a worker land on that worker's deque.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads);
+    ~WorkStealingPool();
+    
+    void Submit(Task task);
+    void Shutdown();
+    
+    size_t GetQueueDepth() const { return pending_.load(std::memory_order_relaxed); }
+    uint64_t GetExecutedCount() const { return executed_.load(std::memory_order_relaxed); }
+    uint64_t GetStealCount() const { return steals_.load(std::memory_order_relaxed); }
+    
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    void WorkerLoop(size_t index);
+    bool PopLocal(size_t index, Task& task);
+    bool Steal(size_t index, Task& task);
+    
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_;
+    std::atomic<size_t> next_;
+    std::atomic<uint64_t> executed_;
+    std::atomic<uint64_t> steals_;
+    std::atomic<bool> stop_;
+};
+
+// Shared FIFO for handlers that block on the OS. The queue itself has no
+// limit: the PriorityLanes in front of it admit at most one task per worker.
+class BoundedPool {
+public:
+    explicit BoundedPool(size_t threads);
+    ~BoundedPool();
+    
+    // False only once shut down
+    bool Submit(Task task);
+    void Shutdown();
+    
+    size_t GetQueueDepth() const;
+    uint64_t GetExecutedCount() const { return executed_.load(std::memory_order_relaxed); }
+    
+private:
+    void WorkerLoop();
+    
+    std::vector<std::thread> threads_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Task> tasks_;
+    bool stop_;
+    std::atomic<uint64_t> executed_;
+};
+
+// Admission in front of a pool. At most `window` tasks are inside the pool
+// at once (one per worker); the rest wait in per-priority lanes. Each freed
+// slot goes to a lane picked by smooth weighted round robin, so interactive
+// tasks overtake a background backlog without starving it.
+class PriorityLanes {
+public:
+    // False if the pool refused the task; it is dropped and its slot freed
+    using Dispatch = std::function<bool(Task)>;
+    
+    PriorityLanes(size_t window, size_t laneCapacity,
+                  const std::array<int, kInvokePriorityCount>& weights, Dispatch dispatch);
+    
+    // Returns false without queuing when the task's lane is full
+    bool Submit(InvokePriority priority, Task task);
+    
+    // Drops queued tasks and refuses new ones
+    void Shutdown();
+    
+    size_t GetDepth(InvokePriority priority) const;
+    uint64_t GetRejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+    
+private:
+    void Release(Task task);
+    void OnTaskDone();
+    bool PickNext(Task& task);  // mutex_ held
+    
+    const size_t window_;
+    const size_t capacity_;
+    std::array<int, kInvokePriorityCount> weights_;
+    std::array<int, kInvokePriorityCount> current_;
+    std::array<std::deque<Task>, kInvokePriorityCount> lanes_;
+    Dispatch dispatch_;
+    mutable std::mutex mutex_;
+    size_t running_;
+    bool stopped_;
+    std::atomic<uint64_t> rejected_;
+};
+
+// One thread running tasks in due-time order (FIFO among equal times); the
+// UI thread for hosts that have no browser UI thread of their own
+class SerialThread {
+public:
+    SerialThread();
+    ~SerialThread();
+    
+    void Post(Task task, int64_t delay_ms);
+    
+    // Drops tasks not yet run and joins
+    void Shutdown();
+    
+private:
+    struct Item {
+        std::chrono::steady_clock::time_point due;
+        uint64_t sequence;
+        Task task;
+    };
+    
+    struct Later {
+        bool operator()(const Item& a, const Item& b) const {
+            return a.due != b.due ? a.due > b.due : a.sequence > b.sequence;
+        }
+    };
+    
+    void Loop();
+    
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::priority_queue<Item, std::vector<Item>, Later> tasks_;
+    uint64_t sequence_;
+    bool stop_;
+    std::thread thread_;
+};
+
+// Process-wide executor used by InvokeDispatcher for non-UI handlers
+class Executor {
+public:
+    static Executor* GetInstance();
+    
+    // Takes effect if called before the first Post()
+    void Configure(const ExecutorConfig& config);
+    
+    // Runs `task` according to `affinity`. UI tasks go to the UI thread and
+    // ignore priority. Returns false if the task's priority lane is full.
+    bool Post(HandlerAffinity affinity, Task task,
+              InvokePriority priority = InvokePriority::Normal);
+    
+    // Marshals `task` to the UI thread: TID_UI once InvokeHandler has
+    // installed its poster, otherwise a single executor-owned thread, so the
+    // dispatcher also runs in processes without CEF
+    static void PostToUI(Task task);
+    static void PostDelayedToUI(Task task, int64_t delay_ms);
+    
+    // Replaces the UI thread; call before anything is posted
+    static void SetUIPoster(UIPoster poster);
+    
+    ExecutorStats GetStats() const;
+    
+    // Joins all workers (and the executor-owned UI thread, if it ran);
+    // call before CefShutdown
+    void Shutdown();
+    
+private:
+    Executor() = default;
+    void EnsureStarted();
+    void PostUI(Task task, int64_t delay_ms);
+    
+    ExecutorConfig config_;
+    std::mutex mutex_;
+    std::atomic<bool> started_{false};
+    std::unique_ptr<WorkStealingPool> cpu_pool_;
+    std::unique_ptr<BoundedPool> io_pool_;
+    std::unique_ptr<PriorityLanes> cpu_lanes_;
+    std::unique_ptr<PriorityLanes> io_lanes_;
+    UIPoster ui_poster_;
+    std::once_flag ui_thread_once_;
+    std::unique_ptr<SerialThread> ui_thread_;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
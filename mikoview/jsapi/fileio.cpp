@@ -0,0 +1,462 @@
+#include "fileio.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(_WIN32)
+    #include <filesystem>
+    #include <fstream>
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+// Where an empty file's view points; BinaryView treats null as "no bytes"
+const uint8_t kEmpty[1] = {0};
+
+#if defined(_WIN32)
+using NativeFile = HANDLE;
+#else
+using NativeFile = int;
+#endif
+
+FileBytes FromBuffer(std::shared_ptr<uint8_t[]> buffer, size_t size) {
+    FileBytes bytes;
+    bytes.view.data = size ? buffer.get() : kEmpty;
+    bytes.view.size = size;
+    bytes.owner = std::move(buffer);
+    return bytes;
+}
+
+#if !defined(_WIN32)
+
+class Descriptor {
+public:
+    explicit Descriptor(int fd) : fd_(fd) {}
+    ~Descriptor() { ::close(fd_); }
+
+    Descriptor(const Descriptor&) = delete;
+    Descriptor& operator=(const Descriptor&) = delete;
+
+    int Get() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// Files whose size stat cannot tell (/proc, pipes behind a path) are read
+// until EOF
+FileBytes ReadToEnd(int fd, const CancellationToken& cancellation) {
+    constexpr size_t kBlockSize = 64 * 1024;
+    std::string data;
+    while (!cancellation.IsCancelled()) {
+        const size_t offset = data.size();
+        data.resize(offset + kBlockSize);
+        const ssize_t got = ::read(fd, &data[offset], kBlockSize);
+        if (got < 0 && errno == EINTR) {
+            data.resize(offset);
+            continue;
+        }
+        if (got < 0) {
+            throw InvokeError("Failed to read file", 500);
+        }
+        data.resize(offset + static_cast<size_t>(got));
+        if (got == 0) {
+            break;
+        }
+    }
+
+    std::shared_ptr<uint8_t[]> buffer(new uint8_t[data.size() ? data.size() : 1]);
+    std::memcpy(buffer.get(), data.data(), data.size());
+    return FromBuffer(std::move(buffer), data.size());
+}
+
+#endif // !_WIN32
+
+} // namespace
+
+#if defined(_WIN32)
+
+// Read a block at a time into a buffer of the file's size
+FileBytes ReadFileBytes(const std::string& path, const CancellationToken& cancellation) {
+    std::error_code error;
+    const std::filesystem::path fsPath(path);
+    if (!std::filesystem::exists(fsPath, error)) {
+        throw InvokeError("File not found", 404);
+    }
+    if (!std::filesystem::is_regular_file(fsPath, error)) {
+        throw InvokeError("Path is not a file", 400);
+    }
+
+    std::ifstream file(fsPath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw InvokeError("Failed to open file", 500);
+    }
+    const size_t size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    std::shared_ptr<uint8_t[]> buffer(new uint8_t[size ? size : 1]);
+    size_t done = 0;
+    while (done < size && file && !cancellation.IsCancelled()) {
+        const size_t want = (std::min)(size - done, kFileReadBlockSize);
+        file.read(reinterpret_cast<char*>(buffer.get() + done), static_cast<std::streamsize>(want));
+        done += static_cast<size_t>(file.gcount());
+    }
+    return FromBuffer(std::move(buffer), done);
+}
+
+#else
+
+FileBytes ReadFileBytes(const std::string& path, const CancellationToken& cancellation) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT || errno == ENOTDIR) {
+            throw InvokeError("File not found", 404);
+        }
+        throw InvokeError("Failed to open file", 500);
+    }
+    Descriptor file(fd);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw InvokeError("Failed to open file", 500);
+    }
+    if (!S_ISREG(info.st_mode)) {
+        throw InvokeError("Path is not a file", 400);
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        return ReadToEnd(fd, cancellation);
+    }
+
+    // Not zero-filled first: every byte is about to be overwritten
+    std::shared_ptr<uint8_t[]> buffer(new uint8_t[size]);
+    size_t done = 0;
+    while (done < size && !cancellation.IsCancelled()) {
+        const size_t want = (std::min)(size - done, kFileReadBlockSize);
+        const ssize_t got = ::pread(fd, buffer.get() + done, want, static_cast<off_t>(done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            throw InvokeError("Failed to read file", 500);
+        }
+        if (got == 0) {
+            break;  // truncated since fstat
+        }
+        done += static_cast<size_t>(got);
+    }
+    return FromBuffer(std::move(buffer), done);
+}
+
+#endif // _WIN32
+
+#if defined(_WIN32)
+
+namespace {
+
+NativeFile OpenNative(const std::string& path, FileOpenMode mode, uint64_t& size) {
+    const bool readable = mode != FileOpenMode::Write;
+    const bool writable = mode != FileOpenMode::Read;
+    const bool create = mode == FileOpenMode::Write || mode == FileOpenMode::ReadWriteNew;
+
+    const HANDLE file = ::CreateFileW(std::filesystem::path(path).wstring().c_str(),
+                                      (readable ? GENERIC_READ : 0) | (writable ? GENERIC_WRITE : 0),
+                                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                      create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        const DWORD error = ::GetLastError();
+        if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) {
+            throw InvokeError("File not found", 404);
+        }
+        if (error == ERROR_ACCESS_DENIED) {
+            throw InvokeError("Permission denied", 403);
+        }
+        throw InvokeError("Failed to open file", 500);
+    }
+
+    LARGE_INTEGER length;
+    if (!::GetFileSizeEx(file, &length)) {
+        ::CloseHandle(file);
+        throw InvokeError("Failed to open file", 500);
+    }
+    size = static_cast<uint64_t>(length.QuadPart);
+    return file;
+}
+
+} // namespace
+
+#else
+
+namespace {
+
+NativeFile OpenNative(const std::string& path, FileOpenMode mode, uint64_t& size) {
+    int flags = O_CLOEXEC;
+    switch (mode) {
+    case FileOpenMode::Read:         flags |= O_RDONLY; break;
+    case FileOpenMode::ReadWrite:    flags |= O_RDWR; break;
+    case FileOpenMode::Write:        flags |= O_WRONLY | O_CREAT | O_TRUNC; break;
+    case FileOpenMode::ReadWriteNew: flags |= O_RDWR | O_CREAT | O_TRUNC; break;
+    }
+
+    const int fd = ::open(path.c_str(), flags, 0666);
+    if (fd < 0) {
+        switch (errno) {
+        case ENOENT:
+        case ENOTDIR: throw InvokeError("File not found", 404);
+        case EACCES:
+        case EPERM:   throw InvokeError("Permission denied", 403);
+        case EISDIR:  throw InvokeError("Path is not a file", 400);
+        case EMFILE:
+        case ENFILE:  throw InvokeError("Too many open files", 503);
+        default:      throw InvokeError("Failed to open file", 500);
+        }
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw InvokeError("Failed to open file", 500);
+    }
+    if (!S_ISREG(info.st_mode)) {
+        ::close(fd);
+        throw InvokeError("Path is not a file", 400);
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    return fd;
+}
+
+} // namespace
+
+#endif // _WIN32
+
+class FileHandleTable::OpenFile {
+public:
+    OpenFile(int sessionId, FileOpenMode mode, NativeFile file)
+        : sessionId_(sessionId), mode_(mode), file_(file) {}
+    ~OpenFile();
+
+    OpenFile(const OpenFile&) = delete;
+    OpenFile& operator=(const OpenFile&) = delete;
+
+    int GetSessionId() const { return sessionId_; }
+    bool CanRead() const { return mode_ != FileOpenMode::Write; }
+    bool CanWrite() const { return mode_ != FileOpenMode::Read; }
+
+    // Stop early only at the end of the file
+    size_t ReadAt(uint64_t offset, uint8_t* data, size_t size) const;
+    void WriteAt(uint64_t offset, const uint8_t* data, size_t size) const;
+
+private:
+    const int sessionId_;
+    const FileOpenMode mode_;
+    const NativeFile file_;
+};
+
+#if defined(_WIN32)
+
+FileHandleTable::OpenFile::~OpenFile() {
+    ::CloseHandle(file_);
+}
+
+// An OVERLAPPED offset makes ReadFile/WriteFile positional on a
+// synchronous handle, like pread/pwrite
+size_t FileHandleTable::OpenFile::ReadAt(uint64_t offset, uint8_t* data, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        const uint64_t position = offset + done;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD want = static_cast<DWORD>(size - done < MAXDWORD ? size - done : MAXDWORD);
+        DWORD got = 0;
+        if (!::ReadFile(file_, data + done, want, &got, &overlapped)) {
+            if (::GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            throw InvokeError("Failed to read file", 500);
+        }
+        if (got == 0) {
+            break;
+        }
+        done += got;
+    }
+    return done;
+}
+
+void FileHandleTable::OpenFile::WriteAt(uint64_t offset, const uint8_t* data, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        const uint64_t position = offset + done;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD want = static_cast<DWORD>(size - done < MAXDWORD ? size - done : MAXDWORD);
+        DWORD put = 0;
+        if (!::WriteFile(file_, data + done, want, &put, &overlapped) || put == 0) {
+            throw InvokeError("Failed to write file", 500);
+        }
+        done += put;
+    }
+}
+
+#else
+
+FileHandleTable::OpenFile::~OpenFile() {
+    ::close(file_);
+}
+
+size_t FileHandleTable::OpenFile::ReadAt(uint64_t offset, uint8_t* data, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t got = ::pread(file_, data + done, size - done, static_cast<off_t>(offset + done));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            throw InvokeError("Failed to read file", 500);
+        }
+        if (got == 0) {
+            break;
+        }
+        done += static_cast<size_t>(got);
+    }
+    return done;
+}
+
+void FileHandleTable::OpenFile::WriteAt(uint64_t offset, const uint8_t* data, size_t size) const {
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t put = ::pwrite(file_, data + done, size - done, static_cast<off_t>(offset + done));
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put < 0) {
+            throw InvokeError(errno == ENOSPC ? "No space left on device" : "Failed to write file", 500);
+        }
+        done += static_cast<size_t>(put);
+    }
+}
+
+#endif // _WIN32
+
+FileHandleTable* FileHandleTable::GetInstance() {
+    static FileHandleTable instance;
+    return &instance;
+}
+
+int FileHandleTable::Open(int sessionId, const std::string& path, FileOpenMode mode, uint64_t* size) {
+    // The slot is taken before opening: "w" truncates, and a refused open
+    // must not have touched the file
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t& open = openPerSession_[sessionId];
+        if (open >= kMaxOpenFilesPerSession) {
+            throw InvokeError("Too many open files", 503);
+        }
+        ++open;
+    }
+
+    std::shared_ptr<OpenFile> file;
+    uint64_t length = 0;
+    try {
+        file = std::make_shared<OpenFile>(sessionId, mode, OpenNative(path, mode, length));
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Release(sessionId);
+        throw;
+    }
+    if (size) {
+        *size = length;
+    }
+
+    // Handles are not reused, so a stale one never reaches another file
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int handle = nextHandle_;
+    nextHandle_ = nextHandle_ == INT32_MAX ? 1 : nextHandle_ + 1;
+    files_.emplace(handle, std::move(file));
+    return handle;
+}
+
+FileBytes FileHandleTable::Read(int sessionId, int handle, uint64_t offset, size_t length) {
+    if (length > kMaxFileReadLength) {
+        throw InvokeError("Read length is too large", 400);
+    }
+    const std::shared_ptr<OpenFile> file = Find(sessionId, handle);
+    if (!file->CanRead()) {
+        throw InvokeError("File handle is not open for reading", 400);
+    }
+
+    // Not zero-filled first: every byte returned is read from the file
+    std::shared_ptr<uint8_t[]> buffer(new uint8_t[length ? length : 1]);
+    return FromBuffer(buffer, file->ReadAt(offset, buffer.get(), length));
+}
+
+size_t FileHandleTable::Write(int sessionId, int handle, uint64_t offset, const void* data, size_t size) {
+    const std::shared_ptr<OpenFile> file = Find(sessionId, handle);
+    if (!file->CanWrite()) {
+        throw InvokeError("File handle is not open for writing", 400);
+    }
+    file->WriteAt(offset, static_cast<const uint8_t*>(data), size);
+    return size;
+}
+
+void FileHandleTable::Close(int sessionId, int handle) {
+    std::shared_ptr<OpenFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(handle);
+        if (it == files_.end() || it->second->GetSessionId() != sessionId) {
+            throw InvokeError("Unknown file handle", 404);
+        }
+        file = std::move(it->second);
+        files_.erase(it);
+        Release(sessionId);
+    }
+    // Closed here, outside the lock, unless a read or write still holds it
+}
+
+void FileHandleTable::CloseSession(int sessionId) {
+    std::vector<std::shared_ptr<OpenFile>> closed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (openPerSession_.erase(sessionId) == 0) {
+            return;
+        }
+        for (auto it = files_.begin(); it != files_.end();) {
+            if (it->second->GetSessionId() == sessionId) {
+                closed.push_back(std::move(it->second));
+                it = files_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void FileHandleTable::Release(int sessionId) {
+    auto it = openPerSession_.find(sessionId);
+    if (it != openPerSession_.end() && --it->second == 0) {
+        openPerSession_.erase(it);
+    }
+}
+
+std::shared_ptr<FileHandleTable::OpenFile> FileHandleTable::Find(int sessionId, int handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = files_.find(handle);
+    if (it == files_.end() || it->second->GetSessionId() != sessionId) {
+        throw InvokeError("Unknown file handle", 404);
+    }
+    return it->second;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
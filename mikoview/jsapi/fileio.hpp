@@ -0,0 +1,97 @@
+#pragma once
+
+#include "request.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace MikoView {
+namespace JSAPI {
+
+// ReadFileBytes reads this much between cancellation checks, so a cancelled
+// or expired read of a large file stops after at most one more block
+constexpr size_t kFileReadBlockSize = 1024 * 1024;
+
+// A whole file's bytes in a heap buffer, kept alive by owner. Hand view and
+// owner to InvokeResponse::SetBinary and the IPC layer copies them once,
+// into shared memory, with no copy in between.
+struct FileBytes {
+    BinaryView view;
+    std::shared_ptr<const void> owner;
+
+    std::string_view Text() const {
+        return std::string_view(reinterpret_cast<const char*>(view.data), view.size);
+    }
+};
+
+// Throws InvokeError: 404 if path does not exist, 400 if it is not a
+// regular file, 500 if it cannot be read. view is never null, even for an
+// empty file. Once cancellation fires the bytes read so far are returned;
+// the caller checks the token and discards them.
+//
+// Files are read into a buffer of their own, never mapped: the answer is
+// copied into IPC shared memory later on the UI thread, and a mapped file
+// truncated by then would raise SIGBUS there. That costs one copy more than
+// mapping did (binary 16 MB reads in invokehost: 475 -> 213 calls/s); pread
+// still beats mapping and copying out of the mapping on the IO thread.
+FileBytes ReadFileBytes(const std::string& path, const CancellationToken& cancellation = CancellationToken());
+
+// Largest single FileHandleTable::Read; bigger ranges belong to readFile or
+// a stream
+constexpr size_t kMaxFileReadLength = 64 * 1024 * 1024;
+
+// Files one session may have open at once
+constexpr size_t kMaxOpenFilesPerSession = 256;
+
+enum class FileOpenMode {
+    Read,          // "r": read only, must exist
+    ReadWrite,     // "r+": read and write, must exist
+    Write,         // "w": write only, created or truncated
+    ReadWriteNew   // "w+": read and write, created or truncated
+};
+
+// Files opened through fs.open. Each handle belongs to the session (browser
+// or transport connection) that opened it: other sessions cannot use it, and
+// CloseSession closes whatever the session left open. Reads and writes are
+// positional (pread/pwrite), so calls on one handle may run in parallel on
+// the worker pools; a handle closed during a call stays open until the call
+// returns.
+//
+// Safe from any thread. Failures throw InvokeError.
+class FileHandleTable {
+public:
+    static FileHandleTable* GetInstance();
+
+    // Returns the handle; size is the file's size once opened
+    int Open(int sessionId, const std::string& path, FileOpenMode mode, uint64_t* size = nullptr);
+
+    // Up to length bytes at offset; fewer at the end of the file
+    FileBytes Read(int sessionId, int handle, uint64_t offset, size_t length);
+
+    // Returns the bytes written, which is size
+    size_t Write(int sessionId, int handle, uint64_t offset, const void* data, size_t size);
+
+    void Close(int sessionId, int handle);
+    void CloseSession(int sessionId);
+
+private:
+    class OpenFile;
+
+    FileHandleTable() = default;
+
+    std::shared_ptr<OpenFile> Find(int sessionId, int handle) const;
+    // Frees one of the session's slots; callers hold mutex_
+    void Release(int sessionId);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, std::shared_ptr<OpenFile>> files_;
+    std::unordered_map<int, size_t> openPerSession_;
+    int nextHandle_ = 1;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
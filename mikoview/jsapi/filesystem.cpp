@@ -1,112 +1,169 @@
 #include "filesystem.hpp"
+#include "fileio.hpp"
 #include "../logger.hpp"
 #include <filesystem>
 #include <fstream>
-#include <sstream>
-#include <json/json.h>
 #include <algorithm>
+#include <chrono>
 #include <regex>
 
 namespace MikoView {
 namespace JSAPI {
 namespace FileSystem {
 
+namespace {
+
+// Per-method deadlines; see HandlerOptions::timeoutMs
+constexpr int kReadTimeoutMs = 30000;
+constexpr int kInfoTimeoutMs = 5000;
+
+// Repeated stat calls within a render share one answer. Changes made through
+// fs.* drop it at once; changes made behind our back show after the TTL.
+constexpr int kInfoCacheTtlMs = 250;
+
+// { success, error } for operations that return nothing else
+void SetStatus(InvokeResponse& response, const std::error_code& ec) {
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Key("success").Bool(!ec);
+    if (ec) {
+        writer.Key("error").String(ec.message());
+    }
+    writer.EndObject();
+    response.SetSuccessJSON(writer.Release());
+}
+
+// Unix seconds; file_time_type has no portable epoch before C++20
+time_t ToTimeT(std::filesystem::file_time_type time) {
+    using namespace std::chrono;
+    auto system = time_point_cast<system_clock::duration>(
+        time - std::filesystem::file_time_type::clock::now() + system_clock::now());
+    return system_clock::to_time_t(system);
+}
+
+} // namespace
+
 // FileInfo implementation
+void FileInfo::Write(JsonWriter& writer) const {
+    writer.BeginObject();
+    writer.Key("name").String(name);
+    writer.Key("path").String(path);
+    writer.Key("extension").String(extension);
+    writer.Key("size").UInt(size);
+    writer.Key("modified").Int(static_cast<int64_t>(modified));
+    writer.Key("created").Int(static_cast<int64_t>(created));
+    writer.Key("isDirectory").Bool(isDirectory);
+    writer.Key("isFile").Bool(isFile);
+    writer.Key("isSymlink").Bool(isSymlink);
+    writer.EndObject();
+}
+
 std::string FileInfo::ToJSON() const {
-    Json::Value root;
-    root["name"] = name;
-    root["path"] = path;
-    root["extension"] = extension;
-    root["size"] = static_cast<Json::Int64>(size);
-    root["modified"] = static_cast<Json::Int64>(modified);
-    root["created"] = static_cast<Json::Int64>(created);
-    root["isDirectory"] = isDirectory;
-    root["isFile"] = isFile;
-    root["isSymlink"] = isSymlink;
-    
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    return Json::writeString(builder, root);
+    JsonWriter writer;
+    Write(writer);
+    return writer.Release();
 }
 
 // DirectoryEntry implementation
+void DirectoryEntry::Write(JsonWriter& writer) const {
+    writer.BeginObject();
+    writer.Key("name").String(name);
+    writer.Key("path").String(path);
+    writer.Key("isDirectory").Bool(isDirectory);
+    writer.EndObject();
+}
+
 std::string DirectoryEntry::ToJSON() const {
-    Json::Value root;
-    root["name"] = name;
-    root["path"] = path;
-    root["isDirectory"] = isDirectory;
-    
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    return Json::writeString(builder, root);
+    JsonWriter writer;
+    Write(writer);
+    return writer.Release();
 }
 
 // ReadResult implementation
+void ReadResult::Write(JsonWriter& writer) const {
+    writer.BeginObject();
+    writer.Key("success").Bool(success);
+    writer.Key("data").String(data);
+    writer.Key("error").String(error);
+    writer.Key("encoding").String(encoding);
+    writer.EndObject();
+}
+
 std::string ReadResult::ToJSON() const {
-    Json::Value root;
-    root["success"] = success;
-    root["data"] = data;
-    root["error"] = error;
-    root["encoding"] = encoding;
-    
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    return Json::writeString(builder, root);
+    JsonWriter writer(data.size() + 64);
+    Write(writer);
+    return writer.Release();
 }
 
 // WriteResult implementation
+void WriteResult::Write(JsonWriter& writer) const {
+    writer.BeginObject();
+    writer.Key("success").Bool(success);
+    writer.Key("error").String(error);
+    writer.Key("bytesWritten").UInt(bytesWritten);
+    writer.EndObject();
+}
+
 std::string WriteResult::ToJSON() const {
-    Json::Value root;
-    root["success"] = success;
-    root["error"] = error;
-    root["bytesWritten"] = static_cast<Json::Int64>(bytesWritten);
-    
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    return Json::writeString(builder, root);
+    JsonWriter writer;
+    Write(writer);
+    return writer.Release();
 }
 
 // FileSystemHandler implementation
 void FileSystemHandler::RegisterHandlers() {
-    auto* handler = InvokeHandler::GetInstance();
+    auto* handler = InvokeDispatcher::GetInstance();
+    
+    // File operations (these touch the disk, so they run on the IO pool)
+    const HandlerOptions read(HandlerAffinity::IO, kReadTimeoutMs);
+    const HandlerOptions write = HandlerOptions(HandlerAffinity::IO).Invalidates({"fs.exists", "fs.getFileInfo"});
+    handler->RegisterHandler("fs.readFile", HandleReadFile, read);
+    handler->RegisterHandler("fs.writeFile", HandleWriteFile, write);
+    handler->RegisterHandler("fs.appendFile", HandleAppendFile, write);
+    handler->RegisterHandler("fs.deleteFile", HandleDeleteFile, write);
+    handler->RegisterHandler("fs.copyFile", HandleCopyFile, write);
+    handler->RegisterHandler("fs.moveFile", HandleMoveFile, write);
     
-    // File operations
-    handler->RegisterHandler("fs.readFile", HandleReadFile);
-    handler->RegisterHandler("fs.writeFile", HandleWriteFile);
-    handler->RegisterHandler("fs.appendFile", HandleAppendFile);
-    handler->RegisterHandler("fs.deleteFile", HandleDeleteFile);
-    handler->RegisterHandler("fs.copyFile", HandleCopyFile);
-    handler->RegisterHandler("fs.moveFile", HandleMoveFile);
+    // File handles, owned by the calling session; see FileHandleTable
+    RegisterTyped<&OpenFile>("fs.open", write);
+    handler->RegisterHandler("fs.read", HandleRead, read);
+    handler->RegisterHandler("fs.write", HandleWrite, write);
+    RegisterTyped<&CloseFile>("fs.close", HandlerAffinity::IO);
     
     // Directory operations
-    handler->RegisterHandler("fs.readDir", HandleReadDir);
-    handler->RegisterHandler("fs.createDir", HandleCreateDir);
-    handler->RegisterHandler("fs.deleteDir", HandleDeleteDir);
+    handler->RegisterHandler("fs.readDir", HandleReadDir, read);
+    handler->RegisterHandler("fs.createDir", HandleCreateDir, write);
+    handler->RegisterHandler("fs.deleteDir", HandleDeleteDir, write);
     
-    // File/Directory info
-    handler->RegisterHandler("fs.getFileInfo", HandleGetFileInfo);
-    handler->RegisterHandler("fs.exists", HandleExists);
+    // File/Directory info; typed methods also appear in the generated TypeScript
+    const HandlerOptions info = HandlerOptions(HandlerAffinity::IO, kInfoTimeoutMs).Idempotent(kInfoCacheTtlMs);
+    RegisterTyped<&GetFileInfo>("fs.getFileInfo", info);
+    RegisterTyped<&Exists>("fs.exists", info);
     
     // Path operations
-    handler->RegisterHandler("fs.resolvePath", HandleResolvePath);
-    handler->RegisterHandler("fs.basename", HandleGetBasename);
-    handler->RegisterHandler("fs.dirname", HandleGetDirname);
-    handler->RegisterHandler("fs.extname", HandleGetExtname);
-    handler->RegisterHandler("fs.joinPath", HandleJoinPath);
+    RegisterTyped<&ResolvePath>("fs.resolvePath");
+    RegisterTyped<&GetBasename>("fs.basename");
+    RegisterTyped<&GetDirname>("fs.dirname");
+    RegisterTyped<&GetExtname>("fs.extname");
+    RegisterTyped<&JoinPath>("fs.joinPath");
+    
+    // Streaming reads: same method names, consumed through invokeStream
+    handler->RegisterStreamHandler("fs.readFile", StreamReadFile);
+    handler->RegisterStreamHandler("fs.readDir", StreamReadDir);
     
     Logger::Info("FileSystem handlers registered");
 }
 
 void FileSystemHandler::HandleReadFile(const InvokeRequest& request, InvokeResponse& response) {
-    std::string path;
-    std::string encoding = "utf8";
-    
-    if (!request.GetParam("path", path)) {
-        response.SetError("Missing required parameter: path", 400);
+    ReadFileArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
         return;
     }
     
-    request.GetParam("encoding", encoding);
+    const std::string& path = args.path;
+    const std::string& encoding = args.encoding;
     
     if (!IsPathSafe(path)) {
         response.SetError("Unsafe path", 403);
@@ -114,70 +171,47 @@ void FileSystemHandler::HandleReadFile(const InvokeRequest& request, InvokeRespo
     }
     
     try {
-        std::filesystem::path fsPath(path);
-        if (!std::filesystem::exists(fsPath)) {
-            response.SetError("File not found", 404);
+        FileBytes bytes = ReadFileBytes(path, request.GetCancellation());
+        if (request.IsCancelled()) {
+            response.SetCancelled(request.GetCancellation().GetReason());
             return;
         }
         
-        if (!std::filesystem::is_regular_file(fsPath)) {
-            response.SetError("Path is not a file", 400);
+        // Raw bytes (an ArrayBuffer in the renderer); the buffer itself goes to IPC
+        if (encoding == "binary") {
+            response.SetBinary(bytes.view, std::move(bytes.owner));
             return;
         }
         
-        ReadResult result;
-        result.encoding = encoding;
-        
-        if (encoding == "binary" || encoding == "base64") {
-            std::ifstream file(fsPath, std::ios::binary);
-            if (!file) {
-                result.success = false;
-                result.error = "Failed to open file";
-            } else {
-                std::ostringstream buffer;
-                buffer << file.rdbuf();
-                std::string content = buffer.str();
-                
-                if (encoding == "base64") {
-                    // Base64 encode the content
-                    // Implementation needed for base64 encoding
-                    result.data = content; // Placeholder
-                } else {
-                    result.data = content;
-                }
-                result.success = true;
-            }
-        } else {
-            std::ifstream file(fsPath);
-            if (!file) {
-                result.success = false;
-                result.error = "Failed to open file";
-            } else {
-                std::ostringstream buffer;
-                buffer << file.rdbuf();
-                result.data = buffer.str();
-                result.success = true;
-            }
-        }
-        
-        response.SetSuccess(result.ToJSON());
+        // Same shape as ReadResult, encoded straight from the file's bytes
+        JsonWriter writer(bytes.view.size + 64);
+        writer.BeginObject();
+        writer.Key("success").Bool(true);
+        writer.Key("data").String(bytes.Text());
+        writer.Key("error").String("");
+        writer.Key("encoding").String(encoding);
+        writer.EndObject();
+        response.SetSuccessJSON(writer.Release());
+    } catch (const InvokeError& e) {
+        response.SetError(e.what(), e.GetCode());
     } catch (const std::exception& e) {
         response.SetError("File read error: " + std::string(e.what()), 500);
     }
 }
 
 void FileSystemHandler::HandleWriteFile(const InvokeRequest& request, InvokeResponse& response) {
-    std::string path, data;
-    std::string encoding = "utf8";
-    bool createDirs = false;
-    
-    if (!request.GetParam("path", path) || !request.GetParam("data", data)) {
-        response.SetError("Missing required parameters: path, data", 400);
+    // One pass over the payload; the file body is decoded exactly once
+    WriteFileArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
         return;
     }
     
-    request.GetParam("encoding", encoding);
-    request.GetParam("createDirs", createDirs);
+    const std::string& path = args.path;
+    const std::string& data = args.data;
+    const std::string& encoding = args.encoding;
+    const bool createDirs = args.createDirs;
     
     if (!IsPathSafe(path)) {
         response.SetError("Unsafe path", 403);
@@ -199,7 +233,7 @@ void FileSystemHandler::HandleWriteFile(const InvokeRequest& request, InvokeResp
                 result.success = false;
                 result.error = "Failed to open file for writing";
             } else {
-                std::string writeData = data;
+                const std::string& writeData = data;
                 if (encoding == "base64") {
                     // Base64 decode the data
                     // Implementation needed for base64 decoding
@@ -220,22 +254,133 @@ void FileSystemHandler::HandleWriteFile(const InvokeRequest& request, InvokeResp
             }
         }
         
-        response.SetSuccess(result.ToJSON());
+        response.SetSuccessJSON(result.ToJSON());
     } catch (const std::exception& e) {
         response.SetError("File write error: " + std::string(e.what()), 500);
     }
 }
 
-void FileSystemHandler::HandleReadDir(const InvokeRequest& request, InvokeResponse& response) {
-    std::string path;
-    bool recursive = false;
+OpenResult FileSystemHandler::OpenFile(const OpenArgs& args, const InvokeRequest& request) {
+    if (!IsPathSafe(args.path)) {
+        throw InvokeError("Unsafe path", 403);
+    }
+    
+    FileOpenMode mode;
+    if (args.flags == "r") {
+        mode = FileOpenMode::Read;
+    } else if (args.flags == "r+") {
+        mode = FileOpenMode::ReadWrite;
+    } else if (args.flags == "w") {
+        mode = FileOpenMode::Write;
+    } else if (args.flags == "w+") {
+        mode = FileOpenMode::ReadWriteNew;
+    } else {
+        throw InvokeError("Unknown flags: " + args.flags, 400);
+    }
+    
+    FileHandleTable* files = FileHandleTable::GetInstance();
+    uint64_t size = 0;
+    OpenResult result;
+    result.fd = files->Open(request.GetSessionId(), args.path, mode, &size);
+    result.size = static_cast<int64_t>(size);
     
-    if (!request.GetParam("path", path)) {
-        response.SetError("Missing required parameter: path", 400);
+    // A session closed while this ran was already swept; nobody would
+    // close the handle
+    if (request.IsCancelled()) {
+        try {
+            files->Close(request.GetSessionId(), result.fd);
+        } catch (const InvokeError&) {
+        }
+        throw InvokeError("Request cancelled", 499);
+    }
+    return result;
+}
+
+void FileSystemHandler::HandleRead(const InvokeRequest& request, InvokeResponse& response) {
+    ReadArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    if (args.offset < 0 || args.length < 0) {
+        response.SetError("offset and length must not be negative", 400);
         return;
     }
     
-    request.GetParam("recursive", recursive);
+    try {
+        // Raw bytes (an ArrayBuffer in the renderer); short at the end of the file
+        FileBytes bytes = FileHandleTable::GetInstance()->Read(request.GetSessionId(), args.fd,
+                                                               static_cast<uint64_t>(args.offset),
+                                                               static_cast<size_t>(args.length));
+        response.SetBinary(bytes.view, std::move(bytes.owner));
+    } catch (const InvokeError& e) {
+        response.SetError(e.what(), e.GetCode());
+    }
+}
+
+void FileSystemHandler::HandleWrite(const InvokeRequest& request, InvokeResponse& response) {
+    int fd = 0;
+    uint64_t offset = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    
+    // Bytes come as an ArrayBuffer behind a small header; text as JSON
+    WriteArgs args;
+    if (request.HasBinary()) {
+        const BinaryView& binary = request.GetBinary();
+        if (binary.size < kWriteHeaderSize) {
+            response.SetError("fs.write payload has no header", 400);
+            return;
+        }
+        auto word = [&binary](size_t at) {
+            return static_cast<uint32_t>(binary.data[at]) | static_cast<uint32_t>(binary.data[at + 1]) << 8 |
+                   static_cast<uint32_t>(binary.data[at + 2]) << 16 | static_cast<uint32_t>(binary.data[at + 3]) << 24;
+        };
+        fd = static_cast<int>(word(0));
+        offset = static_cast<uint64_t>(word(4)) | static_cast<uint64_t>(word(8)) << 32;
+        data = binary.data + kWriteHeaderSize;
+        size = binary.size - kWriteHeaderSize;
+    } else {
+        std::string error;
+        if (!request.Bind(args, &error)) {
+            response.SetError(error, 400);
+            return;
+        }
+        if (args.offset < 0) {
+            response.SetError("offset must not be negative", 400);
+            return;
+        }
+        fd = args.fd;
+        offset = static_cast<uint64_t>(args.offset);
+        data = reinterpret_cast<const uint8_t*>(args.data.data());
+        size = args.data.size();
+    }
+    
+    try {
+        WriteResult result;
+        result.success = true;
+        result.bytesWritten = FileHandleTable::GetInstance()->Write(request.GetSessionId(), fd, offset, data, size);
+        response.SetSuccessJSON(result.ToJSON());
+    } catch (const InvokeError& e) {
+        response.SetError(e.what(), e.GetCode());
+    }
+}
+
+void FileSystemHandler::CloseFile(const HandleArgs& args, const InvokeRequest& request) {
+    FileHandleTable::GetInstance()->Close(request.GetSessionId(), args.fd);
+}
+
+void FileSystemHandler::HandleReadDir(const InvokeRequest& request, InvokeResponse& response) {
+    ReadDirArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    const std::string& path = args.path;
+    const bool recursive = args.recursive;
     
     if (!IsPathSafe(path)) {
         response.SetError("Unsafe path", 403);
@@ -254,65 +399,161 @@ void FileSystemHandler::HandleReadDir(const InvokeRequest& request, InvokeRespon
             return;
         }
         
-        Json::Value entries(Json::arrayValue);
+        // Entries are written straight into the response; nothing is re-parsed
+        JsonWriter writer;
+        writer.BeginArray();
+        
+        // Checked per entry: recursive walks are the usual runaway calls
+        auto addEntry = [&writer, &request](const std::filesystem::directory_entry& entry) {
+            if (request.IsCancelled()) {
+                return false;
+            }
+            
+            DirectoryEntry dirEntry;
+            dirEntry.name = entry.path().filename().string();
+            dirEntry.path = entry.path().string();
+            dirEntry.isDirectory = entry.is_directory();
+            dirEntry.Write(writer);
+            return true;
+        };
         
+        bool completed = true;
         if (recursive) {
             for (const auto& entry : std::filesystem::recursive_directory_iterator(fsPath)) {
-                DirectoryEntry dirEntry;
-                dirEntry.name = entry.path().filename().string();
-                dirEntry.path = entry.path().string();
-                dirEntry.isDirectory = entry.is_directory();
-                
-                Json::Value entryJson;
-                Json::Reader reader;
-                reader.parse(dirEntry.ToJSON(), entryJson);
-                entries.append(entryJson);
+                if (!(completed = addEntry(entry))) {
+                    break;
+                }
             }
         } else {
             for (const auto& entry : std::filesystem::directory_iterator(fsPath)) {
-                DirectoryEntry dirEntry;
-                dirEntry.name = entry.path().filename().string();
-                dirEntry.path = entry.path().string();
-                dirEntry.isDirectory = entry.is_directory();
-                
-                Json::Value entryJson;
-                Json::Reader reader;
-                reader.parse(dirEntry.ToJSON(), entryJson);
-                entries.append(entryJson);
+                if (!(completed = addEntry(entry))) {
+                    break;
+                }
             }
         }
         
-        Json::StreamWriterBuilder builder;
-        builder["indentation"] = "";
-        response.SetSuccess(Json::writeString(builder, entries));
+        if (!completed) {
+            response.SetCancelled(request.GetCancellation().GetReason());
+            return;
+        }
+        
+        writer.EndArray();
+        response.SetSuccessJSON(writer.Release());
     } catch (const std::exception& e) {
         response.SetError("Directory read error: " + std::string(e.what()), 500);
     }
 }
 
-void FileSystemHandler::HandleExists(const InvokeRequest& request, InvokeResponse& response) {
-    std::string path;
+void FileSystemHandler::StreamReadFile(const InvokeRequest& request, StreamWriter& writer) {
+    ReadFileArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        writer.Fail(error, 400);
+        return;
+    }
     
-    if (!request.GetParam("path", path)) {
-        response.SetError("Missing required parameter: path", 400);
+    if (!IsPathSafe(args.path)) {
+        writer.Fail("Unsafe path", 403);
         return;
     }
     
-    if (!IsPathSafe(path)) {
-        response.SetError("Unsafe path", 403);
+    std::ifstream file(args.path, std::ios::binary);
+    if (!file) {
+        writer.Fail("Failed to open file", 404);
         return;
     }
     
-    try {
-        bool exists = std::filesystem::exists(path);
-        Json::Value result;
-        result["exists"] = exists;
+    // Raw bytes; the renderer decodes text itself
+    const size_t chunkSize = writer.GetChunkSize(64 * 1024);
+    while (file) {
+        std::string chunk(chunkSize, '\0');
+        file.read(&chunk[0], static_cast<std::streamsize>(chunkSize));
+        chunk.resize(static_cast<size_t>(file.gcount()));
+        if (chunk.empty() || !writer.WriteBinary(std::move(chunk))) {
+            break;
+        }
+    }
+    
+    if (file.bad()) {
+        writer.Fail("File read error", 500);
+    }
+}
+
+void FileSystemHandler::StreamReadDir(const InvokeRequest& request, StreamWriter& writer) {
+    ReadDirArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        writer.Fail(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.path)) {
+        writer.Fail("Unsafe path", 403);
+        return;
+    }
+    
+    std::filesystem::path fsPath(args.path);
+    if (!std::filesystem::is_directory(fsPath)) {
+        writer.Fail("Directory not found", 404);
+        return;
+    }
+    
+    // Each chunk is a JSON array of up to chunkSize entries
+    const size_t chunkSize = writer.GetChunkSize(256);
+    JsonWriter chunk;
+    size_t count = 0;
+    
+    auto addEntry = [&](const std::filesystem::directory_entry& entry) {
+        if (count == 0) {
+            chunk.Clear();
+            chunk.BeginArray();
+        }
         
-        Json::StreamWriterBuilder builder;
-        builder["indentation"] = "";
-        response.SetSuccess(Json::writeString(builder, result));
-    } catch (const std::exception& e) {
-        response.SetError("Path check error: " + std::string(e.what()), 500);
+        DirectoryEntry dirEntry;
+        dirEntry.name = entry.path().filename().string();
+        dirEntry.path = entry.path().string();
+        dirEntry.isDirectory = entry.is_directory();
+        dirEntry.Write(chunk);
+        
+        if (++count < chunkSize) {
+            return true;
+        }
+        count = 0;
+        chunk.EndArray();
+        return writer.WriteJSON(chunk.Release());
+    };
+    
+    if (args.recursive) {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(fsPath)) {
+            if (!addEntry(entry)) {
+                return;
+            }
+        }
+    } else {
+        for (const auto& entry : std::filesystem::directory_iterator(fsPath)) {
+            if (!addEntry(entry)) {
+                return;
+            }
+        }
+    }
+    
+    if (count > 0) {
+        chunk.EndArray();
+        writer.WriteJSON(chunk.Release());
+    }
+}
+
+ExistsResult FileSystemHandler::Exists(const PathArgs& args) {
+    if (!IsPathSafe(args.path)) {
+        throw InvokeError("Unsafe path", 403);
+    }
+    
+    try {
+        ExistsResult result;
+        result.exists = std::filesystem::exists(args.path);
+        return result;
+    } catch (const std::filesystem::filesystem_error& e) {
+        throw InvokeError("Path check error: " + std::string(e.what()), 500);
     }
 }
 
@@ -341,8 +582,257 @@ std::string FileSystemHandler::NormalizePath(const std::string& path) {
     }
 }
 
-// Additional handler implementations would go here...
-// (HandleAppendFile, HandleDeleteFile, HandleCopyFile, etc.)
+void FileSystemHandler::HandleAppendFile(const InvokeRequest& request, InvokeResponse& response) {
+    WriteFileArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.path)) {
+        response.SetError("Unsafe path", 403);
+        return;
+    }
+    
+    try {
+        std::filesystem::path fsPath(args.path);
+        if (args.createDirs) {
+            std::filesystem::create_directories(fsPath.parent_path());
+        }
+        
+        WriteResult result;
+        std::ofstream file(fsPath, std::ios::binary | std::ios::app);
+        if (!file) {
+            result.success = false;
+            result.error = "Failed to open file for appending";
+            result.bytesWritten = 0;
+        } else {
+            file.write(args.data.data(), static_cast<std::streamsize>(args.data.size()));
+            result.success = static_cast<bool>(file);
+            result.bytesWritten = result.success ? args.data.size() : 0;
+        }
+        
+        response.SetSuccessJSON(result.ToJSON());
+    } catch (const std::exception& e) {
+        response.SetError("File append error: " + std::string(e.what()), 500);
+    }
+}
+
+void FileSystemHandler::HandleDeleteFile(const InvokeRequest& request, InvokeResponse& response) {
+    PathArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.path)) {
+        response.SetError("Unsafe path", 403);
+        return;
+    }
+    
+    std::error_code ec;
+    std::filesystem::file_status status = std::filesystem::symlink_status(args.path, ec);
+    if (!std::filesystem::exists(status)) {
+        response.SetError("File not found", 404);
+        return;
+    }
+    if (std::filesystem::is_directory(status)) {
+        response.SetError("Path is a directory", 400);
+        return;
+    }
+    
+    std::filesystem::remove(args.path, ec);
+    SetStatus(response, ec);
+}
+
+void FileSystemHandler::HandleCopyFile(const InvokeRequest& request, InvokeResponse& response) {
+    CopyFileArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.source) || !IsPathSafe(args.destination)) {
+        response.SetError("Unsafe path", 403);
+        return;
+    }
+    
+    if (!std::filesystem::is_regular_file(args.source)) {
+        response.SetError("File not found", 404);
+        return;
+    }
+    
+    std::error_code ec;
+    std::filesystem::copy_file(args.source, args.destination,
+                               std::filesystem::copy_options::overwrite_existing, ec);
+    SetStatus(response, ec);
+}
+
+void FileSystemHandler::HandleMoveFile(const InvokeRequest& request, InvokeResponse& response) {
+    CopyFileArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.source) || !IsPathSafe(args.destination)) {
+        response.SetError("Unsafe path", 403);
+        return;
+    }
+    
+    std::error_code ec;
+    if (!std::filesystem::exists(args.source, ec)) {
+        response.SetError("File not found", 404);
+        return;
+    }
+    
+    std::filesystem::rename(args.source, args.destination, ec);
+    SetStatus(response, ec);
+}
+
+void FileSystemHandler::HandleCreateDir(const InvokeRequest& request, InvokeResponse& response) {
+    DirArgs args;
+    args.recursive = true;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.path)) {
+        response.SetError("Unsafe path", 403);
+        return;
+    }
+    
+    // Creating a directory that already exists is not an error
+    std::error_code ec;
+    if (args.recursive) {
+        std::filesystem::create_directories(args.path, ec);
+    } else {
+        std::filesystem::create_directory(args.path, ec);
+    }
+    SetStatus(response, ec);
+}
+
+void FileSystemHandler::HandleDeleteDir(const InvokeRequest& request, InvokeResponse& response) {
+    DirArgs args;
+    std::string error;
+    if (!request.Bind(args, &error)) {
+        response.SetError(error, 400);
+        return;
+    }
+    
+    if (!IsPathSafe(args.path)) {
+        response.SetError("Unsafe path", 403);
+        return;
+    }
+    
+    std::error_code ec;
+    if (!std::filesystem::is_directory(args.path, ec)) {
+        response.SetError("Directory not found", 404);
+        return;
+    }
+    
+    // Without recursive, a non-empty directory fails with ENOTEMPTY
+    if (args.recursive) {
+        std::filesystem::remove_all(args.path, ec);
+    } else {
+        std::filesystem::remove(args.path, ec);
+    }
+    SetStatus(response, ec);
+}
+
+FileInfo FileSystemHandler::GetFileInfo(const PathArgs& args) {
+    if (!IsPathSafe(args.path)) {
+        throw InvokeError("Unsafe path", 403);
+    }
+    
+    try {
+        std::filesystem::path fsPath(args.path);
+        std::filesystem::file_status linkStatus = std::filesystem::symlink_status(fsPath);
+        if (!std::filesystem::exists(linkStatus)) {
+            throw InvokeError("File not found", 404);
+        }
+        
+        std::filesystem::file_status status = std::filesystem::status(fsPath);
+        FileInfo info;
+        info.name = fsPath.filename().string();
+        info.path = fsPath.string();
+        info.extension = fsPath.extension().string();
+        info.isDirectory = std::filesystem::is_directory(status);
+        info.isFile = std::filesystem::is_regular_file(status);
+        info.isSymlink = std::filesystem::is_symlink(linkStatus);
+        info.size = info.isFile ? static_cast<size_t>(std::filesystem::file_size(fsPath)) : 0;
+        info.modified = ToTimeT(std::filesystem::last_write_time(fsPath));
+        // Creation time is not exposed by std::filesystem
+        info.created = 0;
+        return info;
+    } catch (const std::filesystem::filesystem_error& e) {
+        throw InvokeError("File info error: " + std::string(e.what()), 500);
+    }
+}
+
+PathResult FileSystemHandler::ResolvePath(const PathArgs& args) {
+    if (!IsPathSafe(args.path)) {
+        throw InvokeError("Unsafe path", 403);
+    }
+    
+    // Resolves what exists and keeps the rest, so the path need not exist
+    std::error_code ec;
+    std::filesystem::path resolved = std::filesystem::weakly_canonical(std::filesystem::absolute(args.path, ec), ec);
+    if (ec) {
+        throw InvokeError("Path resolve error: " + ec.message(), 500);
+    }
+    
+    PathResult result;
+    result.path = resolved.string();
+    return result;
+}
+
+BasenameResult FileSystemHandler::GetBasename(const BasenameArgs& args) {
+    // Matches Node's path.basename(path, ext)
+    BasenameResult result;
+    result.basename = std::filesystem::path(args.path).filename().string();
+    std::string& basename = result.basename;
+    if (!args.ext.empty() && basename.size() > args.ext.size() &&
+        basename.compare(basename.size() - args.ext.size(), args.ext.size(), args.ext) == 0) {
+        basename.resize(basename.size() - args.ext.size());
+    }
+    return result;
+}
+
+DirnameResult FileSystemHandler::GetDirname(const PathArgs& args) {
+    DirnameResult result;
+    result.dirname = std::filesystem::path(args.path).parent_path().string();
+    if (result.dirname.empty()) {
+        result.dirname = ".";
+    }
+    return result;
+}
+
+ExtnameResult FileSystemHandler::GetExtname(const PathArgs& args) {
+    ExtnameResult result;
+    result.extname = std::filesystem::path(args.path).extension().string();
+    return result;
+}
+
+PathResult FileSystemHandler::JoinPath(const JoinPathArgs& args) {
+    std::filesystem::path joined;
+    for (const auto& segment : args.segments) {
+        joined /= segment;
+    }
+    
+    PathResult result;
+    result.path = joined.lexically_normal().string();
+    if (result.path.empty()) {
+        result.path = ".";
+    }
+    return result;
+}
 
 } // namespace FileSystem
 } // namespace JSAPI
@@ -1,6 +1,8 @@
 #pragma once
 
-#include "invoke.hpp"
+#include "dispatcher.hpp"
+#include "jsonwriter.hpp"
+#include "typed.hpp"
 #include <string>
 #include <vector>
 #include <memory>
@@ -22,6 +24,7 @@ struct FileInfo {
     bool isFile;
     bool isSymlink;
     
+    void Write(JsonWriter& writer) const;
     std::string ToJSON() const;
 };
 
@@ -30,6 +33,7 @@ struct DirectoryEntry {
     std::string path;
     bool isDirectory;
     
+    void Write(JsonWriter& writer) const;
     std::string ToJSON() const;
 };
 
@@ -40,6 +44,7 @@ struct ReadResult {
     std::string error;
     std::string encoding;
     
+    void Write(JsonWriter& writer) const;
     std::string ToJSON() const;
 };
 
@@ -48,9 +53,255 @@ struct WriteResult {
     std::string error;
     size_t bytesWritten;
     
+    void Write(JsonWriter& writer) const;
     std::string ToJSON() const;
 };
 
+// Request arguments
+struct ReadFileArgs {
+    std::string path;
+    std::string encoding = "utf8";
+};
+
+struct WriteFileArgs {
+    std::string path;
+    std::string data;
+    std::string encoding = "utf8";
+    bool createDirs = false;
+};
+
+struct ReadDirArgs {
+    std::string path;
+    bool recursive = false;
+};
+
+struct PathArgs {
+    std::string path;
+};
+
+struct CopyFileArgs {
+    std::string source;
+    std::string destination;
+};
+
+struct DirArgs {
+    std::string path;
+    bool recursive = false;
+};
+
+struct BasenameArgs {
+    std::string path;
+    std::string ext;
+};
+
+struct JoinPathArgs {
+    std::vector<std::string> segments;
+};
+
+// File handles (fs.open/read/write/close, see FileHandleTable)
+struct OpenArgs {
+    std::string path;
+    std::string flags = "r";  // "r", "r+", "w" or "w+"
+};
+
+struct HandleArgs {
+    int fd = 0;
+};
+
+struct ReadArgs {
+    int fd = 0;
+    int64_t offset = 0;
+    int64_t length = 0;
+};
+
+struct WriteArgs {
+    int fd = 0;
+    int64_t offset = 0;
+    std::string data;
+};
+
+// fs.write with an ArrayBuffer: the bytes are preceded by this header of
+// little-endian uint32s: handle, offset low 32 bits, offset high 32 bits
+constexpr size_t kWriteHeaderSize = 12;
+
+// Typed results
+struct ExistsResult {
+    bool exists = false;
+};
+
+struct PathResult {
+    std::string path;
+};
+
+struct BasenameResult {
+    std::string basename;
+};
+
+struct DirnameResult {
+    std::string dirname;
+};
+
+struct ExtnameResult {
+    std::string extname;
+};
+
+struct OpenResult {
+    int fd = 0;
+    int64_t size = 0;
+};
+
+} // namespace FileSystem
+
+template<> struct Binding<FileSystem::FileInfo> {
+    static constexpr std::string_view Name = "FileInfo";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("name", &FileSystem::FileInfo::name),
+                               Required("path", &FileSystem::FileInfo::path),
+                               Required("extension", &FileSystem::FileInfo::extension),
+                               Required("size", &FileSystem::FileInfo::size),
+                               Required("modified", &FileSystem::FileInfo::modified),
+                               Required("created", &FileSystem::FileInfo::created),
+                               Required("isDirectory", &FileSystem::FileInfo::isDirectory),
+                               Required("isFile", &FileSystem::FileInfo::isFile),
+                               Required("isSymlink", &FileSystem::FileInfo::isSymlink));
+    }
+};
+
+template<> struct Binding<FileSystem::ReadFileArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::ReadFileArgs::path),
+                               Optional("encoding", &FileSystem::ReadFileArgs::encoding));
+    }
+};
+
+template<> struct Binding<FileSystem::WriteFileArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::WriteFileArgs::path),
+                               Required("data", &FileSystem::WriteFileArgs::data),
+                               Optional("encoding", &FileSystem::WriteFileArgs::encoding),
+                               Optional("createDirs", &FileSystem::WriteFileArgs::createDirs));
+    }
+};
+
+template<> struct Binding<FileSystem::ReadDirArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::ReadDirArgs::path),
+                               Optional("recursive", &FileSystem::ReadDirArgs::recursive));
+    }
+};
+
+template<> struct Binding<FileSystem::PathArgs> {
+    static constexpr std::string_view Name = "PathArgs";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::PathArgs::path));
+    }
+};
+
+template<> struct Binding<FileSystem::CopyFileArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("source", &FileSystem::CopyFileArgs::source),
+                               Required("destination", &FileSystem::CopyFileArgs::destination));
+    }
+};
+
+template<> struct Binding<FileSystem::DirArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::DirArgs::path),
+                               Optional("recursive", &FileSystem::DirArgs::recursive));
+    }
+};
+
+template<> struct Binding<FileSystem::BasenameArgs> {
+    static constexpr std::string_view Name = "BasenameArgs";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::BasenameArgs::path),
+                               Optional("ext", &FileSystem::BasenameArgs::ext));
+    }
+};
+
+template<> struct Binding<FileSystem::JoinPathArgs> {
+    static constexpr std::string_view Name = "JoinPathArgs";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("segments", &FileSystem::JoinPathArgs::segments));
+    }
+};
+
+template<> struct Binding<FileSystem::OpenArgs> {
+    static constexpr std::string_view Name = "OpenArgs";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::OpenArgs::path),
+                               Optional("flags", &FileSystem::OpenArgs::flags));
+    }
+};
+
+template<> struct Binding<FileSystem::HandleArgs> {
+    static constexpr std::string_view Name = "HandleArgs";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("fd", &FileSystem::HandleArgs::fd));
+    }
+};
+
+template<> struct Binding<FileSystem::ReadArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("fd", &FileSystem::ReadArgs::fd),
+                               Optional("offset", &FileSystem::ReadArgs::offset),
+                               Required("length", &FileSystem::ReadArgs::length));
+    }
+};
+
+template<> struct Binding<FileSystem::WriteArgs> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("fd", &FileSystem::WriteArgs::fd),
+                               Optional("offset", &FileSystem::WriteArgs::offset),
+                               Required("data", &FileSystem::WriteArgs::data));
+    }
+};
+
+template<> struct Binding<FileSystem::ExistsResult> {
+    static constexpr std::string_view Name = "ExistsResult";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("exists", &FileSystem::ExistsResult::exists));
+    }
+};
+
+template<> struct Binding<FileSystem::PathResult> {
+    static constexpr std::string_view Name = "PathResult";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("path", &FileSystem::PathResult::path));
+    }
+};
+
+template<> struct Binding<FileSystem::OpenResult> {
+    static constexpr std::string_view Name = "OpenResult";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("fd", &FileSystem::OpenResult::fd),
+                               Required("size", &FileSystem::OpenResult::size));
+    }
+};
+
+template<> struct Binding<FileSystem::BasenameResult> {
+    static constexpr std::string_view Name = "BasenameResult";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("basename", &FileSystem::BasenameResult::basename));
+    }
+};
+
+template<> struct Binding<FileSystem::DirnameResult> {
+    static constexpr std::string_view Name = "DirnameResult";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("dirname", &FileSystem::DirnameResult::dirname));
+    }
+};
+
+template<> struct Binding<FileSystem::ExtnameResult> {
+    static constexpr std::string_view Name = "ExtnameResult";
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("extname", &FileSystem::ExtnameResult::extname));
+    }
+};
+
+namespace FileSystem {
+
 // Main filesystem handler class
 class FileSystemHandler {
 public:
@@ -65,21 +316,31 @@ private:
     static void HandleCopyFile(const InvokeRequest& request, InvokeResponse& response);
     static void HandleMoveFile(const InvokeRequest& request, InvokeResponse& response);
     
+    // File handles: positional reads and writes without whole-file copies
+    static OpenResult OpenFile(const OpenArgs& args, const InvokeRequest& request);
+    static void HandleRead(const InvokeRequest& request, InvokeResponse& response);
+    static void HandleWrite(const InvokeRequest& request, InvokeResponse& response);
+    static void CloseFile(const HandleArgs& args, const InvokeRequest& request);
+    
     // Directory operations
     static void HandleReadDir(const InvokeRequest& request, InvokeResponse& response);
     static void HandleCreateDir(const InvokeRequest& request, InvokeResponse& response);
     static void HandleDeleteDir(const InvokeRequest& request, InvokeResponse& response);
     
-    // File/Directory info
-    static void HandleGetFileInfo(const InvokeRequest& request, InvokeResponse& response);
-    static void HandleExists(const InvokeRequest& request, InvokeResponse& response);
+    // File/Directory info (typed, see RegisterTyped)
+    static FileInfo GetFileInfo(const PathArgs& args);
+    static ExistsResult Exists(const PathArgs& args);
+    
+    // Path operations (typed)
+    static PathResult ResolvePath(const PathArgs& args);
+    static BasenameResult GetBasename(const BasenameArgs& args);
+    static DirnameResult GetDirname(const PathArgs& args);
+    static ExtnameResult GetExtname(const PathArgs& args);
+    static PathResult JoinPath(const JoinPathArgs& args);
     
-    // Path operations
-    static void HandleResolvePath(const InvokeRequest& request, InvokeResponse& response);
-    static void HandleGetBasename(const InvokeRequest& request, InvokeResponse& response);
-    static void HandleGetDirname(const InvokeRequest& request, InvokeResponse& response);
-    static void HandleGetExtname(const InvokeRequest& request, InvokeResponse& response);
-    static void HandleJoinPath(const InvokeRequest& request, InvokeResponse& response);
+    // Streaming variants (mikoview.invokeStream)
+    static void StreamReadFile(const InvokeRequest& request, StreamWriter& writer);
+    static void StreamReadDir(const InvokeRequest& request, StreamWriter& writer);
     
     // Utility functions
     static bool IsPathSafe(const std::string& path);
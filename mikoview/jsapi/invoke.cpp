@@ -1,8 +1,14 @@
 #include "invoke.hpp"
+#include "ipc.hpp"
+#include "jsonwriter.hpp"
+#include "script.hpp"
 #include "../logger.hpp"
 #include "cef_task.h"
 #include "wrapper/cef_helpers.h"
 #include <json/json.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <sstream>
 
 namespace MikoView {
@@ -11,142 +17,497 @@ namespace JSAPI {
 // Static instance
 std::unique_ptr<InvokeHandler> InvokeHandler::instance_ = nullptr;
 
-// InvokeRequest implementation
-InvokeRequest::InvokeRequest(const std::string& method, const std::string& data, int requestId)
-    : method_(method), data_(data), requestId_(requestId) {
+namespace {
+
+// Untrusted wire value; anything unknown is Normal
+InvokePriority PriorityFromInt(int value) {
+    if (value < 0 || value >= static_cast<int>(kInvokePriorityCount)) {
+        return InvokePriority::Normal;
+    }
+    return static_cast<InvokePriority>(value);
 }
 
-template<typename T>
-bool InvokeRequest::GetParam(const std::string& key, T& value) const {
-    try {
-        Json::Value root;
-        Json::Reader reader;
-        if (!reader.parse(data_, root)) {
-            return false;
+// "interactive" | "normal" | "background"
+InvokePriority PriorityFromV8(CefRefPtr<CefV8Value> value) {
+    if (value && value->IsString()) {
+        const std::string name = value->GetStringValue();
+        if (name == "interactive") {
+            return InvokePriority::Interactive;
         }
-        
-        if (!root.isMember(key)) {
-            return false;
+        if (name == "background") {
+            return InvokePriority::Background;
+        }
+    }
+    return InvokePriority::Normal;
+}
+
+// Untrusted wire value; anything unknown is Latest
+EventPolicy EventPolicyFromInt(int value) {
+    if (value < 0 || value > static_cast<int>(EventPolicy::Queue)) {
+        return EventPolicy::Latest;
+    }
+    return static_cast<EventPolicy>(value);
+}
+
+// "latest" | "frame" | "queue"
+EventPolicy EventPolicyFromV8(CefRefPtr<CefV8Value> value) {
+    if (value && value->IsString()) {
+        const std::string name = value->GetStringValue();
+        if (name == "frame") {
+            return EventPolicy::Frame;
+        }
+        if (name == "queue") {
+            return EventPolicy::Queue;
+        }
+    }
+    return EventPolicy::Latest;
+}
+
+// CefStrings hold UTF-16. Converts into the arena directly rather than
+// through a temporary std::string.
+std::string_view CopyUTF8(Arena& arena, const CefString& text) {
+    const auto* in = text.c_str();
+    const size_t length = text.length();
+    if (length == 0) {
+        return std::string_view();
+    }
+    
+    // At most 3 bytes per UTF-16 unit; a surrogate pair takes 4 for 2
+    char* out = arena.AllocateArray<char>(length * 3);
+    size_t used = 0;
+    for (size_t i = 0; i < length; ++i) {
+        uint32_t c = static_cast<uint32_t>(in[i]);
+        if (c < 0x80) {
+            out[used++] = static_cast<char>(c);
+            continue;
         }
         
-        // Type-specific extraction
-        if constexpr (std::is_same_v<T, std::string>) {
-            if (root[key].isString()) {
-                value = root[key].asString();
-                return true;
-            }
-        } else if constexpr (std::is_same_v<T, int>) {
-            if (root[key].isInt()) {
-                value = root[key].asInt();
-                return true;
-            }
-        } else if constexpr (std::is_same_v<T, bool>) {
-            if (root[key].isBool()) {
-                value = root[key].asBool();
-                return true;
-            }
-        } else if constexpr (std::is_same_v<T, double>) {
-            if (root[key].isDouble()) {
-                value = root[key].asDouble();
-                return true;
-            }
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < length &&
+            static_cast<uint32_t>(in[i + 1]) >= 0xDC00 && static_cast<uint32_t>(in[i + 1]) <= 0xDFFF) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (static_cast<uint32_t>(in[++i]) - 0xDC00);
+        } else if (c >= 0xD800 && c <= 0xDFFF) {
+            c = 0xFFFD;  // unpaired surrogate
         }
         
-        return false;
-    } catch (...) {
-        return false;
+        if (c < 0x800) {
+            out[used++] = static_cast<char>(0xC0 | (c >> 6));
+        } else if (c < 0x10000) {
+            out[used++] = static_cast<char>(0xE0 | (c >> 12));
+            out[used++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        } else {
+            out[used++] = static_cast<char>(0xF0 | (c >> 18));
+            out[used++] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out[used++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        }
+        out[used++] = static_cast<char>(0x80 | (c & 0x3F));
     }
+    
+    arena.Shrink(out, length * 3, used);
+    return std::string_view(out, used);
 }
 
-// InvokeResponse implementation
-InvokeResponse::InvokeResponse(int requestId)
-    : requestId_(requestId), success_(false), errorCode_(0) {
+std::string_view PayloadText(const BinaryView& payload) {
+    return std::string_view(reinterpret_cast<const char*>(payload.data), payload.size);
 }
 
-void InvokeResponse::SetSuccess(const std::string& data) {
-    success_ = true;
-    data_ = data;
-    error_.clear();
-    errorCode_ = 0;
+// The method argument of an invoke, batch entry or stream message is the
+// interned id once the renderer knows it, and the name until then. A name
+// that resolves is announced back so the next call sends only the id.
+InvokeRequest ReadRequest(CefRefPtr<CefFrame> frame, CefRefPtr<CefListValue> args,
+                          const CefString& data, int requestId) {
+    if (args->GetType(0) == VTYPE_INT) {
+        InvokeRequest request(std::string_view(), std::string_view(), requestId);
+        request.SetData(CopyUTF8(request.GetArena(), data));
+        request.SetMethodId(static_cast<MethodId>(args->GetInt(0)));
+        return request;
+    }
+    
+    InvokeRequest request(args->GetString(0).ToString(), std::string_view(), requestId);
+    request.SetData(CopyUTF8(request.GetArena(), data));
+    const MethodId id = InvokeDispatcher::GetInstance()->FindMethod(request.GetMethod());
+    if (id != kNoMethodId) {
+        request.SetMethodId(id);
+        if (frame && frame->IsValid()) {
+            CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeMethodIdMessage);
+            message->GetArgumentList()->SetString(0, request.GetMethod());
+            message->GetArgumentList()->SetInt(1, static_cast<int>(id));
+            frame->SendProcessMessage(PID_RENDERER, message);
+        }
+    }
+    return request;
 }
 
-void InvokeResponse::SetError(const std::string& error, int code) {
-    success_ = false;
-    error_ = error;
-    errorCode_ = code;
-    data_.clear();
+class FunctionTask : public CefTask {
+public:
+    explicit FunctionTask(Task task) : task_(std::move(task)) {}
+    
+    void Execute() override {
+        task_();
+    }
+    
+private:
+    Task task_;
+    IMPLEMENT_REFCOUNTING(FunctionTask);
+};
+
+// Answers one renderer call (or batch, or stream) through its frame
+class CefInvokeChannel : public InvokeChannel {
+public:
+    CefInvokeChannel(CefRefPtr<CefBrowser> browser, CefRefPtr<CefFrame> frame, ResponseMode mode)
+        : browser_(browser),
+          frame_(frame),
+          mode_(mode),
+          browserId_(browser->GetIdentifier()),
+          clientKey_(ClientKey(frame, mode)) {
+    }
+    
+    // The legacy script path and the frame's RendererInvokeRouter number
+    // their requests independently, so they are separate clients
+    static std::string ClientKey(CefRefPtr<CefFrame> frame, ResponseMode mode) {
+        std::string key = frame ? frame->GetIdentifier().ToString() : std::string();
+        return mode == ResponseMode::Script ? key + "/script" : key;
+    }
+    
+    int GetSessionId() const override { return browserId_; }
+    const std::string& GetClientKey() const override { return clientKey_; }
+    
+    void SendResponse(const InvokeResponse& response) override {
+        InvokeHandler::GetInstance()->SendResponse(browser_, frame_, response, mode_);
+    }
+    
+    void SendBatchResponse(const std::vector<const InvokeResponse*>& responses) override;
+    void SendStreamMessage(int streamId, StreamEvent event, const std::string* data,
+                           bool binary, const std::string& error, int code) override;
+    void SendEvents(const std::vector<EventDelivery>& deliveries) override;
+    
+private:
+    CefRefPtr<CefBrowser> browser_;
+    CefRefPtr<CefFrame> frame_;
+    ResponseMode mode_;
+    int browserId_;
+    std::string clientKey_;
+};
+
+void CefInvokeChannel::SendBatchResponse(const std::vector<const InvokeResponse*>& responses) {
+    if (!frame_ || !frame_->IsValid()) {
+        return;
+    }
+    
+    // Binary and shared-memory sized responses keep their own message; the
+    // renderer matches them by request id either way
+    CefRefPtr<CefListValue> entries = CefListValue::Create();
+    size_t count = 0;
+    for (const InvokeResponse* response : responses) {
+        if (response->IsBinary() || response->GetData().size() >= IPC::kSharedMemoryThreshold) {
+            InvokeHandler::GetInstance()->SendResponse(browser_, frame_, *response, ResponseMode::ProcessMessage);
+            continue;
+        }
+        
+        // [requestId, success, data, error, errorCode]
+        CefRefPtr<CefListValue> entry = CefListValue::Create();
+        entry->SetInt(0, response->GetRequestId());
+        entry->SetBool(1, response->IsSuccess());
+        entry->SetString(2, response->GetData());
+        entry->SetString(3, response->GetError());
+        entry->SetInt(4, response->GetErrorCode());
+        entries->SetList(count++, entry);
+    }
+    
+    if (count == 0) {
+        return;
+    }
+    
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeBatchResponseMessage);
+    message->GetArgumentList()->SetList(0, entries);
+    frame_->SendProcessMessage(PID_RENDERER, message);
 }
 
-std::string InvokeResponse::ToJSON() const {
-    Json::Value root;
-    root["requestId"] = requestId_;
-    root["success"] = success_;
+void CefInvokeChannel::SendStreamMessage(int streamId, StreamEvent event, const std::string* data,
+                                         bool binary, const std::string& error, int code) {
+    if (!frame_ || !frame_->IsValid()) {
+        return;
+    }
     
-    if (success_) {
-        // Try to parse data as JSON, if it fails, treat as string
-        Json::Value dataJson;
-        Json::Reader reader;
-        if (reader.parse(data_, dataJson)) {
-            root["data"] = dataJson;
-        } else {
-            root["data"] = data_;
+    PayloadKind kind = PayloadKind::None;
+    BinaryView payload;
+    if (data && (binary || data->size() >= IPC::kSharedMemoryThreshold)) {
+        kind = binary ? PayloadKind::Binary : PayloadKind::Json;
+        payload.data = reinterpret_cast<const uint8_t*>(data->data());
+        payload.size = data->size();
+    }
+    
+    // [streamId, event, data, error, errorCode, payloadKind] + optional payload
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeStreamChunkMessage);
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    args->SetInt(0, streamId);
+    args->SetInt(1, static_cast<int>(event));
+    args->SetString(2, data && kind == PayloadKind::None ? *data : std::string());
+    args->SetString(3, error);
+    args->SetInt(4, code);
+    args->SetInt(5, static_cast<int>(kind));
+    frame_->SendProcessMessage(PID_RENDERER, IPC::AttachPayload(message, payload));
+}
+
+void CefInvokeChannel::SendEvents(const std::vector<EventDelivery>& deliveries) {
+    if (!frame_ || !frame_->IsValid()) {
+        return;
+    }
+    
+    // [subscriptionId, dropped, events] per entry; the events go as one JSON
+    // array so the renderer parses each delivery once
+    CefRefPtr<CefListValue> entries = CefListValue::Create();
+    std::string events;
+    for (size_t i = 0; i < deliveries.size(); ++i) {
+        const EventDelivery& delivery = deliveries[i];
+        events.clear();
+        events += '[';
+        for (const std::string& event : delivery.events) {
+            if (events.size() > 1) {
+                events += ',';
+            }
+            events += event;
         }
-    } else {
-        root["error"] = error_;
-        root["errorCode"] = errorCode_;
+        events += ']';
+        
+        CefRefPtr<CefListValue> entry = CefListValue::Create();
+        entry->SetInt(0, delivery.subscriptionId);
+        entry->SetInt(1, static_cast<int>((std::min)(delivery.dropped, static_cast<uint64_t>(INT_MAX))));
+        entry->SetString(2, events);
+        entries->SetList(i, entry);
     }
     
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    return Json::writeString(builder, root);
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kEventBatchMessage);
+    message->GetArgumentList()->SetList(0, entries);
+    frame_->SendProcessMessage(PID_RENDERER, message);
 }
 
+} // namespace
+
 // InvokeHandler implementation
 InvokeHandler* InvokeHandler::GetInstance() {
     if (!instance_) {
-        instance_ = std::make_unique<InvokeHandler>();
+        // The dispatcher's UI thread is the browser UI thread
+        Executor::SetUIPoster([](Task task, int64_t delay_ms) {
+            if (delay_ms > 0) {
+                CefPostDelayedTask(TID_UI, new FunctionTask(std::move(task)), delay_ms);
+            } else {
+                CefPostTask(TID_UI, new FunctionTask(std::move(task)));
+            }
+        });
+        
+        instance_.reset(new InvokeHandler());
         instance_->nextRequestId_ = 1;
+        InvokeDispatcher::GetInstance()->RegisterHandler(kRendererResponseMethod,
+            [](const InvokeRequest& request, InvokeResponse& response) {
+                instance_->OnRendererResponse(request);
+                response.SetSuccessJSON("true");
+            });
     }
     return instance_.get();
 }
 
-void InvokeHandler::RegisterHandler(const std::string& method, NativeHandler handler) {
-    handlers_[method] = handler;
-    Logger::Info("Registered invoke handler: " + method);
+void InvokeHandler::RegisterHandler(const std::string& method, NativeHandler handler,
+                                    HandlerOptions options) {
+    InvokeDispatcher::GetInstance()->RegisterHandler(method, std::move(handler), options);
 }
 
 void InvokeHandler::UnregisterHandler(const std::string& method) {
-    handlers_.erase(method);
-    Logger::Info("Unregistered invoke handler: " + method);
+    InvokeDispatcher::GetInstance()->UnregisterHandler(method);
 }
 
-void InvokeHandler::HandleInvoke(CefRefPtr<CefBrowser> browser,
-                                CefRefPtr<CefFrame> frame,
-                                const std::string& method,
-                                const std::string& data,
-                                int requestId) {
-    auto it = handlers_.find(method);
-    if (it == handlers_.end()) {
-        InvokeResponse response(requestId);
-        response.SetError("Method not found: " + method, 404);
-        SendResponse(browser, response);
-        return;
+void InvokeHandler::RegisterAsyncHandler(const std::string& method, AsyncHandler handler,
+                                         HandlerOptions options) {
+    InvokeDispatcher::GetInstance()->RegisterAsyncHandler(method, std::move(handler), options);
+}
+
+void InvokeHandler::RegisterStreamHandler(const std::string& method, StreamHandler handler,
+                                          HandlerOptions options) {
+    InvokeDispatcher::GetInstance()->RegisterStreamHandler(method, std::move(handler), options);
+}
+
+void InvokeHandler::UnregisterStreamHandler(const std::string& method) {
+    InvokeDispatcher::GetInstance()->UnregisterStreamHandler(method);
+}
+
+void InvokeHandler::SetDefaultTimeout(int timeoutMs) {
+    InvokeDispatcher::GetInstance()->SetDefaultTimeout(timeoutMs);
+}
+
+void InvokeHandler::SetMaxInFlightPerFrame(size_t maxInFlight) {
+    InvokeDispatcher::GetInstance()->SetMaxInFlightPerClient(maxInFlight);
+}
+
+void InvokeHandler::InvalidateCache(const std::string& method) {
+    InvokeDispatcher::GetInstance()->InvalidateCache(method);
+}
+
+void InvokeHandler::InvalidateCache() {
+    InvokeDispatcher::GetInstance()->InvalidateCache();
+}
+
+bool InvokeHandler::StartRecording(const std::string& path, uint64_t maxBytes, std::string* error) {
+    return InvokeDispatcher::GetInstance()->StartRecording(path, maxBytes, error);
+}
+
+void InvokeHandler::StopRecording() {
+    InvokeDispatcher::GetInstance()->StopRecording();
+}
+
+bool InvokeHandler::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                             CefRefPtr<CefFrame> frame,
+                                             CefRefPtr<CefProcessMessage> message) {
+    CEF_REQUIRE_UI_THREAD();
+    
+    if (ScriptService::GetInstance()->OnProcessMessageReceived(browser, frame, message)) {
+        return true;
     }
     
-    try {
-        InvokeRequest request(method, data, requestId);
-        InvokeResponse response(requestId);
+    if (message->GetName() == kInvokeBatchMessage) {
+        // [entries], each entry [method or id, data, requestId, priority]
+        CefRefPtr<CefListValue> entries = message->GetArgumentList()->GetList(0);
+        if (!entries) {
+            Logger::Warning("Malformed invoke batch message");
+            return true;
+        }
         
-        // Execute handler
-        it->second(request, response);
+        std::vector<InvokeRequest> requests;
+        requests.reserve(entries->GetSize());
+        for (size_t i = 0; i < entries->GetSize(); ++i) {
+            CefRefPtr<CefListValue> entry = entries->GetList(i);
+            if (!entry || entry->GetSize() < 3) {
+                continue;
+            }
+            requests.push_back(ReadRequest(frame, entry, entry->GetString(1), entry->GetInt(2)));
+            if (entry->GetSize() > 3) {
+                requests.back().SetPriority(PriorityFromInt(entry->GetInt(3)));
+            }
+        }
         
-        // Send response
-        SendResponse(browser, response);
-    } catch (const std::exception& e) {
-        InvokeResponse response(requestId);
-        response.SetError("Handler exception: " + std::string(e.what()), 500);
-        SendResponse(browser, response);
+        HandleInvokeBatch(browser, frame, std::move(requests));
+        return true;
+    }
+    
+    if (message->GetName() == kInvokeStreamMessage) {
+        // [method or id, data, streamId, chunkSize, credits, payloadKind] + optional payload
+        IPC::ReceivedMessage received;
+        if (!IPC::ReadMessage(message, 6, received)) {
+            Logger::Warning("Malformed invoke stream message");
+            return true;
+        }
+        
+        CefRefPtr<CefListValue> args = received.args;
+        InvokeRequest request = ReadRequest(frame, args, args->GetString(1), args->GetInt(2));
+        if (static_cast<PayloadKind>(args->GetInt(5)) == PayloadKind::Json && !received.payload.IsNull()) {
+            request.SetData(PayloadText(received.payload), received.owner);
+        }
+        HandleInvokeStream(browser, frame, request,
+                           static_cast<size_t>((std::max)(args->GetInt(3), 0)), args->GetInt(4));
+        return true;
+    }
+    
+    if (message->GetName() == kInvokeStreamAckMessage ||
+        message->GetName() == kInvokeStreamCancelMessage) {
+        // [streamId] or [streamId, credits]
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        const std::string clientKey = CefInvokeChannel::ClientKey(frame, ResponseMode::ProcessMessage);
+        if (message->GetName() == kInvokeStreamCancelMessage) {
+            InvokeDispatcher::GetInstance()->CancelStream(browser->GetIdentifier(), clientKey, args->GetInt(0));
+        } else {
+            InvokeDispatcher::GetInstance()->AckStream(browser->GetIdentifier(), clientKey, args->GetInt(0), args->GetInt(1));
+        }
+        return true;
+    }
+    
+    if (message->GetName() == kEventSubscribeMessage) {
+        // [subscriptionId, topic, policy, cap]
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        if (args->GetSize() < 4) {
+            Logger::Warning("Malformed event subscribe message");
+            return true;
+        }
+        EventHub::GetInstance()->Subscribe(
+            std::make_shared<CefInvokeChannel>(browser, frame, ResponseMode::ProcessMessage),
+            args->GetInt(0), args->GetString(1), EventPolicyFromInt(args->GetInt(2)),
+            static_cast<size_t>((std::max)(args->GetInt(3), 0)));
+        return true;
+    }
+    
+    if (message->GetName() == kEventUnsubscribeMessage) {
+        // [subscriptionId]
+        EventHub::GetInstance()->Unsubscribe(browser->GetIdentifier(),
+                                             CefInvokeChannel::ClientKey(frame, ResponseMode::ProcessMessage),
+                                             message->GetArgumentList()->GetInt(0));
+        return true;
+    }
+    
+    if (message->GetName() == kInvokeCancelMessage) {
+        // [requestId]; the renderer has already rejected its promise
+        InvokeDispatcher::GetInstance()->Cancel(browser->GetIdentifier(),
+                                                CefInvokeChannel::ClientKey(frame, ResponseMode::ProcessMessage),
+                                                message->GetArgumentList()->GetInt(0));
+        return true;
+    }
+    
+    if (message->GetName() != kInvokeMessage) {
+        return false;
+    }
+    
+    // [method or id, data, requestId, mode, payloadKind, priority] + optional payload
+    IPC::ReceivedMessage received;
+    if (!IPC::ReadMessage(message, 6, received)) {
+        Logger::Warning("Malformed invoke message");
+        return true;
+    }
+    
+    CefRefPtr<CefListValue> args = received.args;
+    ResponseMode mode = args->GetInt(3) == static_cast<int>(ResponseMode::ProcessMessage)
+        ? ResponseMode::ProcessMessage : ResponseMode::Script;
+    PayloadKind kind = static_cast<PayloadKind>(args->GetInt(4));
+    
+    // Large JSON is read in place from the shared memory it arrived in
+    InvokeRequest request = ReadRequest(frame, args, args->GetString(1), args->GetInt(2));
+    if (kind == PayloadKind::Json && !received.payload.IsNull()) {
+        request.SetData(PayloadText(received.payload), received.owner);
     }
+    request.SetPriority(PriorityFromInt(args->GetInt(5)));
+    if (kind == PayloadKind::Binary && !received.payload.IsNull()) {
+        request.SetBinary(received.payload, received.owner);
+    }
+    
+    HandleInvoke(browser, frame, request, mode);
+    return true;
+}
+
+void InvokeHandler::HandleInvoke(CefRefPtr<CefBrowser> browser,
+                                CefRefPtr<CefFrame> frame,
+                                const std::string& method,
+                                const std::string& data,
+                                int requestId,
+                                ResponseMode mode) {
+    HandleInvoke(browser, frame, InvokeRequest(method, data, requestId), mode);
+}
+
+void InvokeHandler::HandleInvoke(CefRefPtr<CefBrowser> browser,
+                                CefRefPtr<CefFrame> frame,
+                                const InvokeRequest& request,
+                                ResponseMode mode) {
+    InvokeDispatcher::GetInstance()->Dispatch(std::make_shared<CefInvokeChannel>(browser, frame, mode), request);
+}
+
+void InvokeHandler::HandleInvokeBatch(CefRefPtr<CefBrowser> browser,
+                                     CefRefPtr<CefFrame> frame,
+                                     std::vector<InvokeRequest> requests) {
+    InvokeDispatcher::GetInstance()->DispatchBatch(
+        std::make_shared<CefInvokeChannel>(browser, frame, ResponseMode::ProcessMessage), std::move(requests));
+}
+
+void InvokeHandler::HandleInvokeStream(CefRefPtr<CefBrowser> browser,
+                                      CefRefPtr<CefFrame> frame,
+                                      const InvokeRequest& request,
+                                      size_t chunkSize,
+                                      int credits) {
+    InvokeDispatcher::GetInstance()->OpenStream(
+        std::make_shared<CefInvokeChannel>(browser, frame, ResponseMode::ProcessMessage), request, chunkSize, credits);
 }
 
 void InvokeHandler::SendResponse(CefRefPtr<CefBrowser> browser,
@@ -155,16 +516,79 @@ void InvokeHandler::SendResponse(CefRefPtr<CefBrowser> browser,
         return;
     }
     
-    std::string script = "if (window.mikoview && window.mikoview._handleInvokeResponse) { "
-                        "window.mikoview._handleInvokeResponse(" + response.ToJSON() + "); }";
+    // Built in one buffer: the JSON is written straight after the prefix
+    std::string script;
+    script.reserve(response.GetData().size() + response.GetError().size() + 160);
+    script += "if (window.mikoview && window.mikoview._handleInvokeResponse) { "
+              "window.mikoview._handleInvokeResponse(";
+    response.AppendJSON(script);
+    script += "); }";
     
-    browser->GetMainFrame()->ExecuteJavaScript(script, "", 0);
+    // Batched with the other scripts for the main frame this turn
+    ScriptService::GetInstance()->Execute(browser, std::string(), std::move(script));
+}
+
+void InvokeHandler::SendResponse(CefRefPtr<CefBrowser> browser,
+                                CefRefPtr<CefFrame> frame,
+                                const InvokeResponse& response,
+                                ResponseMode mode) {
+    if (mode == ResponseMode::Script) {
+        if (response.IsBinary()) {
+            // Raw bytes cannot be embedded in the legacy script transport
+            InvokeResponse error(response.GetRequestId());
+            error.SetError("Binary responses require the process message transport", 415);
+            SendResponse(browser, error);
+            return;
+        }
+        SendResponse(browser, response);
+        return;
+    }
+    
+    // The requesting frame may have navigated away; its promise is gone with it
+    if (!frame || !frame->IsValid()) {
+        return;
+    }
+    
+    // Data stays raw text or bytes; the renderer turns it into V8 values
+    // without compiling a script around it. Large payloads go through
+    // shared memory.
+    PayloadKind kind = PayloadKind::None;
+    BinaryView payload;
+    if (response.IsBinary()) {
+        kind = PayloadKind::Binary;
+        payload = response.GetBinary();
+    } else if (response.GetData().size() >= IPC::kSharedMemoryThreshold) {
+        kind = PayloadKind::Json;
+        payload.data = reinterpret_cast<const uint8_t*>(response.GetData().data());
+        payload.size = response.GetData().size();
+    }
+    
+    // [requestId, success, data, error, errorCode, payloadKind] + optional payload
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeResponseMessage);
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    args->SetInt(0, response.GetRequestId());
+    args->SetBool(1, response.IsSuccess());
+    args->SetString(2, kind == PayloadKind::None ? response.GetData() : std::string());
+    args->SetString(3, response.GetError());
+    args->SetInt(4, response.GetErrorCode());
+    args->SetInt(5, static_cast<int>(kind));
+    
+    frame->SendProcessMessage(PID_RENDERER, IPC::AttachPayload(message, payload));
 }
 
 void InvokeHandler::InvokeRenderer(CefRefPtr<CefBrowser> browser,
                                   const std::string& method,
                                   const std::string& data,
-                                  InvokeCallback callback) {
+                                  InvokeCallback callback,
+                                  int timeoutMs) {
+    // The pending table and timer wheel belong to the UI thread
+    if (!CefCurrentlyOn(TID_UI)) {
+        Executor::PostToUI([this, browser, method, data, callback, timeoutMs]() {
+            InvokeRenderer(browser, method, data, callback, timeoutMs);
+        });
+        return;
+    }
+    
     if (!browser || !browser->GetMainFrame()) {
         if (callback) {
             callback("", false);
@@ -172,30 +596,582 @@ void InvokeHandler::InvokeRenderer(CefRefPtr<CefBrowser> browser,
         return;
     }
     
-    int requestId = GenerateRequestId();
+    // Fire-and-forget calls use id 0, which the renderer does not answer
+    int requestId = 0;
     if (callback) {
-        pendingCallbacks_[requestId] = callback;
+        while (maxPendingCalls_ > 0 && pendingCallbacks_.size() >= maxPendingCalls_) {
+            rendererStats_.evicted++;
+            CompleteRendererCall(pendingCallbacks_.begin(), "Renderer invoke evicted", false);
+        }
+        
+        requestId = GenerateRequestId();
+        pendingCallbacks_[requestId] = PendingRendererCall{browser->GetIdentifier(), callback};
+        
+        if (timeoutMs > 0) {
+            rendererTimeouts_.Schedule(static_cast<uint64_t>(requestId), CancellationToken::NowMs() + timeoutMs);
+            ScheduleTimeoutTick();
+        }
     }
     
-    Json::Value request;
-    request["method"] = method;
-    request["data"] = data;
-    request["requestId"] = requestId;
-    
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "";
-    std::string requestJson = Json::writeString(builder, request);
+    JsonWriter request(data.size() + method.size() + 64);
+    request.BeginObject();
+    request.Key("method").String(method);
+    request.Key("data").String(data);
+    request.Key("requestId").Int(requestId);
+    request.EndObject();
     
     std::string script = "if (window.mikoview && window.mikoview._handleNativeInvoke) { "
-                        "window.mikoview._handleNativeInvoke(" + requestJson + "); }";
+                        "window.mikoview._handleNativeInvoke(" + request.GetString() + "); }";
+    
+    ScriptService::GetInstance()->Execute(browser, std::string(), std::move(script));
+}
+
+void InvokeHandler::Publish(const std::string& topic, std::string json) {
+    EventHub::GetInstance()->Publish(topic, std::move(json));
+}
+
+Async::FromCallback<RendererResult> InvokeHandler::InvokeRendererAsync(CefRefPtr<CefBrowser> browser,
+                                                                       const std::string& method,
+                                                                       const std::string& data,
+                                                                       int timeoutMs) {
+    return Async::FromCallback<RendererResult>([this, browser, method, data, timeoutMs](std::function<void(RendererResult)> resume) {
+        InvokeRenderer(browser, method, data, [resume](const std::string& result, bool success) {
+            resume(RendererResult{result, success});
+        }, timeoutMs);
+    });
+}
+
+void InvokeHandler::OnRendererResponse(const InvokeRequest& request) {
+    const Json::Value& root = request.GetJSON();
+    if (!root.isObject() || !root["requestId"].isInt()) {
+        rendererStats_.misrouted++;
+        return;
+    }
+    
+    auto it = pendingCallbacks_.find(root["requestId"].asInt());
+    if (it == pendingCallbacks_.end() || it->second.browserId != request.GetSessionId()) {
+        rendererStats_.misrouted++;
+        return;
+    }
+    
+    const bool success = root["success"].asBool();
+    std::string result;
+    if (!success) {
+        result = root["error"].asString();
+    } else if (root["data"].isString()) {
+        result = root["data"].asString();
+    } else if (!root["data"].isNull()) {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        result = Json::writeString(builder, root["data"]);
+    }
+    
+    rendererStats_.completed++;
+    CompleteRendererCall(it, result, success);
+}
+
+void InvokeHandler::CompleteRendererCall(std::map<int, PendingRendererCall>::iterator it,
+                                        const std::string& result, bool success) {
+    // Erase first: the callback may issue new calls
+    InvokeCallback callback = std::move(it->second.callback);
+    pendingCallbacks_.erase(it);
+    
+    try {
+        callback(result, success);
+    } catch (const std::exception& e) {
+        Logger::Error("Renderer invoke callback threw: " + std::string(e.what()));
+    }
+}
+
+void InvokeHandler::OnBrowserClosed(CefRefPtr<CefBrowser> browser) {
+    CEF_REQUIRE_UI_THREAD();
+    
+    // Collect first: callbacks may add or complete other calls
+    const int browserId = browser->GetIdentifier();
+    std::vector<int> closed;
+    for (const auto& entry : pendingCallbacks_) {
+        if (entry.second.browserId == browserId) {
+            closed.push_back(entry.first);
+        }
+    }
+    
+    for (int requestId : closed) {
+        auto it = pendingCallbacks_.find(requestId);
+        if (it != pendingCallbacks_.end()) {
+            rendererStats_.cancelled++;
+            CompleteRendererCall(it, "Browser closed", false);
+        }
+    }
     
-    browser->GetMainFrame()->ExecuteJavaScript(script, "", 0);
+    ScriptService::GetInstance()->OnBrowserClosed(browser);
+    
+    // Worker-pool calls and streams stop at their next cancellation check
+    InvokeDispatcher::GetInstance()->CloseSession(browserId);
+}
+
+RendererInvokeStats InvokeHandler::GetRendererInvokeStats() const {
+    RendererInvokeStats stats = rendererStats_;
+    stats.pending = pendingCallbacks_.size();
+    return stats;
+}
+
+InvokeCallStats InvokeHandler::GetInvokeCallStats() const {
+    return InvokeDispatcher::GetInstance()->GetInvokeCallStats();
+}
+
+void InvokeHandler::ScheduleTimeoutTick() {
+    // Ticks only while something can expire, so an idle app never wakes for it
+    if (timeoutTickScheduled_ || pendingCallbacks_.empty()) {
+        return;
+    }
+    
+    timeoutTickScheduled_ = true;
+    Executor::PostDelayedToUI([this]() { OnTimeoutTick(); }, rendererTimeouts_.GetTickMs());
+}
+
+void InvokeHandler::OnTimeoutTick() {
+    timeoutTickScheduled_ = false;
+    
+    std::vector<uint64_t> expired;
+    rendererTimeouts_.Advance(CancellationToken::NowMs(), expired);
+    for (uint64_t id : expired) {
+        // Calls that already completed are skipped here
+        auto it = pendingCallbacks_.find(static_cast<int>(id));
+        if (it != pendingCallbacks_.end()) {
+            rendererStats_.timedOut++;
+            CompleteRendererCall(it, "Renderer invoke timed out", false);
+        }
+    }
+    
+    ScheduleTimeoutTick();
 }
 
 int InvokeHandler::GenerateRequestId() {
     return nextRequestId_++;
 }
 
+// RendererInvokeRouter implementation
+RendererInvokeRouter* RendererInvokeRouter::GetInstance() {
+    static RendererInvokeRouter instance;
+    return &instance;
+}
+
+void RendererInvokeRouter::OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                           CefRefPtr<CefFrame> frame,
+                                           CefRefPtr<CefV8Context> context) {
+    CefRefPtr<CefV8Value> global = context->GetGlobal();
+    CefRefPtr<CefV8Value> json = global->GetValue("JSON");
+    CefRefPtr<CefV8Value> parse = json && json->IsObject() ? json->GetValue("parse") : nullptr;
+    if (parse && parse->IsFunction()) {
+        parsers_.push_back(ContextParser{context, parse});
+    }
+    
+    CefRefPtr<CefV8Value> mikoview = global->GetValue("mikoview");
+    if (!mikoview || !mikoview->IsObject()) {
+        mikoview = CefV8Value::CreateObject(nullptr, nullptr);
+        global->SetValue("mikoview", mikoview, V8_PROPERTY_ATTRIBUTE_NONE);
+    }
+    
+    CefRefPtr<CefV8Handler> handler = new V8InvokeHandler();
+    mikoview->SetValue("invoke", CefV8Value::CreateFunction("invoke", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("invokeBatch", CefV8Value::CreateFunction("invokeBatch", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("cancelInvoke", CefV8Value::CreateFunction("cancelInvoke", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("invokeStream", CefV8Value::CreateFunction("invokeStream", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("streamAck", CefV8Value::CreateFunction("streamAck", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("streamCancel", CefV8Value::CreateFunction("streamCancel", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("subscribe", CefV8Value::CreateFunction("subscribe", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+    mikoview->SetValue("unsubscribe", CefV8Value::CreateFunction("unsubscribe", handler), V8_PROPERTY_ATTRIBUTE_READONLY);
+}
+
+void RendererInvokeRouter::OnContextReleased(CefRefPtr<CefBrowser> browser,
+                                            CefRefPtr<CefFrame> frame,
+                                            CefRefPtr<CefV8Context> context) {
+    parsers_.erase(std::remove_if(parsers_.begin(), parsers_.end(), [&context](const ContextParser& parser) {
+        return parser.context->IsSame(context);
+    }), parsers_.end());
+    
+    // Responses for a released context have nowhere to go
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->second.context->IsSame(context)) {
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    // Tell the browser to stop producing for streams nobody will consume
+    for (auto it = streams_.begin(); it != streams_.end();) {
+        if (it->second.context->IsSame(context)) {
+            CefRefPtr<CefProcessMessage> cancel = CefProcessMessage::Create(kInvokeStreamCancelMessage);
+            cancel->GetArgumentList()->SetInt(0, it->first);
+            frame->SendProcessMessage(PID_BROWSER, cancel);
+            it = streams_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+        if (it->second.context->IsSame(context)) {
+            CefRefPtr<CefProcessMessage> unsubscribe = CefProcessMessage::Create(kEventUnsubscribeMessage);
+            unsubscribe->GetArgumentList()->SetInt(0, it->first);
+            frame->SendProcessMessage(PID_BROWSER, unsubscribe);
+            it = subscriptions_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool RendererInvokeRouter::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                                   CefRefPtr<CefFrame> frame,
+                                                   CefRefPtr<CefProcessMessage> message) {
+    if (message->GetName() == kInvokeBatchResponseMessage) {
+        OnBatchResponse(message->GetArgumentList()->GetList(0));
+        return true;
+    }
+    
+    if (message->GetName() == kInvokeStreamChunkMessage) {
+        OnStreamMessage(message);
+        return true;
+    }
+    
+    if (message->GetName() == kEventBatchMessage) {
+        OnEventBatch(message->GetArgumentList()->GetList(0));
+        return true;
+    }
+    
+    if (message->GetName() == kScriptBatchMessage) {
+        ScriptService::RunBatch(frame, message->GetArgumentList());
+        return true;
+    }
+    
+    if (message->GetName() == kInvokeMethodIdMessage) {
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        methodIds_[args->GetString(0)] = args->GetInt(1);
+        return true;
+    }
+    
+    if (message->GetName() != kInvokeResponseMessage) {
+        return false;
+    }
+    
+    IPC::ReceivedMessage received;
+    if (!IPC::ReadMessage(message, 6, received)) {
+        return true;
+    }
+    
+    CefRefPtr<CefListValue> args = received.args;
+    PendingInvoke pending;
+    if (!TakePending(args->GetInt(0), pending)) {
+        return true;
+    }
+    
+    if (!pending.context->IsValid() || !pending.context->Enter()) {
+        return true;
+    }
+    
+    if (args->GetBool(1)) {
+        PayloadKind kind = static_cast<PayloadKind>(args->GetInt(5));
+        const BinaryView& payload = received.payload;
+        
+        CefRefPtr<CefV8Value> value;
+        if (kind == PayloadKind::Binary && !payload.IsNull()) {
+            // Shared memory is mapped read-only here, so V8 gets its own copy
+            value = CefV8Value::CreateArrayBufferWithCopy(
+                const_cast<uint8_t*>(payload.data), payload.size);
+        } else if (kind == PayloadKind::Json && !payload.IsNull()) {
+            value = ResponseDataToV8Value(pending.context, payload);
+        } else {
+            value = ResponseDataToV8Value(pending.context, args->GetString(2));
+        }
+        pending.promise->ResolvePromise(value);
+    } else {
+        pending.promise->RejectPromise(args->GetString(3));
+    }
+    
+    pending.context->Exit();
+    return true;
+}
+
+int RendererInvokeRouter::AddPending(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> promise) {
+    int requestId = nextRequestId_++;
+    pending_[requestId] = PendingInvoke{context, promise};
+    return requestId;
+}
+
+bool RendererInvokeRouter::CancelPending(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> promise,
+                                         const std::string& reason) {
+    // Linear scan: cancellation is rare next to invokes
+    for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+        if (!it->second.promise->IsSame(promise)) {
+            continue;
+        }
+        
+        const int requestId = it->first;
+        pending_.erase(it);
+        promise->RejectPromise(reason);
+        
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeCancelMessage);
+        message->GetArgumentList()->SetInt(0, requestId);
+        context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        return true;
+    }
+    return false;
+}
+
+CefRefPtr<CefV8Value> RendererInvokeRouter::ParseJSON(CefRefPtr<CefV8Context> context, const CefString& json) {
+    CefRefPtr<CefV8Value> parse;
+    for (const ContextParser& parser : parsers_) {
+        if (parser.context->IsSame(context)) {
+            parse = parser.parse;
+            break;
+        }
+    }
+    if (!parse) {
+        return nullptr;
+    }
+    
+    // V8's own parser builds the values directly; no intermediate DOM
+    CefV8ValueList args;
+    args.push_back(CefV8Value::CreateString(json));
+    CefRefPtr<CefV8Value> value = parse->ExecuteFunction(nullptr, args);
+    if (!value || parse->HasException()) {
+        parse->ClearException();
+        return nullptr;
+    }
+    return value;
+}
+
+CefRefPtr<CefV8Value> RendererInvokeRouter::ResponseDataToV8Value(CefRefPtr<CefV8Context> context,
+                                                                  const CefString& data) {
+    CefRefPtr<CefV8Value> value = ParseJSON(context, data);
+    return value ? value : CefV8Value::CreateString(data);
+}
+
+CefRefPtr<CefV8Value> RendererInvokeRouter::ResponseDataToV8Value(CefRefPtr<CefV8Context> context,
+                                                                  const BinaryView& data) {
+    // Straight from the shared memory into the UTF-16 string V8 takes
+    CefString text;
+    cef_string_utf8_to_utf16(reinterpret_cast<const char*>(data.data), data.size, text.GetWritableStruct());
+    return ResponseDataToV8Value(context, text);
+}
+
+int RendererInvokeRouter::AddStream(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> sink) {
+    int streamId = nextStreamId_++;
+    streams_[streamId] = PendingStream{context, sink};
+    return streamId;
+}
+
+int RendererInvokeRouter::AddSubscription(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> listener) {
+    int subscriptionId = nextSubscriptionId_++;
+    subscriptions_[subscriptionId] = Subscription{context, listener};
+    return subscriptionId;
+}
+
+void RendererInvokeRouter::SetMethodArg(CefRefPtr<CefListValue> args, size_t index,
+                                        const CefString& method) const {
+    auto it = methodIds_.find(method);
+    if (it != methodIds_.end()) {
+        args->SetInt(index, it->second);
+    } else {
+        args->SetString(index, method);
+    }
+}
+
+void RendererInvokeRouter::OnStreamMessage(CefRefPtr<CefProcessMessage> message) {
+    IPC::ReceivedMessage received;
+    if (!IPC::ReadMessage(message, 6, received)) {
+        return;
+    }
+    
+    // [streamId, event, data, error, errorCode, payloadKind] + optional payload
+    CefRefPtr<CefListValue> args = received.args;
+    auto it = streams_.find(args->GetInt(0));
+    if (it == streams_.end()) {
+        return;
+    }
+    
+    PendingStream stream = it->second;
+    StreamEvent event = static_cast<StreamEvent>(args->GetInt(1));
+    if (event != StreamEvent::Chunk) {
+        streams_.erase(it);
+    }
+    
+    if (!stream.context->IsValid() || !stream.context->Enter()) {
+        return;
+    }
+    
+    CefV8ValueList callArgs;
+    const char* method = "end";
+    if (event == StreamEvent::Chunk) {
+        PayloadKind kind = static_cast<PayloadKind>(args->GetInt(5));
+        const BinaryView& payload = received.payload;
+        if (kind == PayloadKind::Binary && !payload.IsNull()) {
+            callArgs.push_back(CefV8Value::CreateArrayBufferWithCopy(
+                const_cast<uint8_t*>(payload.data), payload.size));
+        } else if (kind == PayloadKind::Json && !payload.IsNull()) {
+            callArgs.push_back(ResponseDataToV8Value(stream.context, payload));
+        } else {
+            callArgs.push_back(ResponseDataToV8Value(stream.context, args->GetString(2)));
+        }
+        method = "chunk";
+    } else if (event == StreamEvent::Error) {
+        callArgs.push_back(CefV8Value::CreateString(args->GetString(3)));
+        callArgs.push_back(CefV8Value::CreateInt(args->GetInt(4)));
+        method = "error";
+    }
+    
+    CefRefPtr<CefV8Value> callback = stream.sink->GetValue(method);
+    if (callback && callback->IsFunction()) {
+        callback->ExecuteFunction(stream.sink, callArgs);
+    }
+    
+    stream.context->Exit();
+}
+
+bool RendererInvokeRouter::TakePending(int requestId, PendingInvoke& pending) {
+    auto it = pending_.find(requestId);
+    if (it == pending_.end()) {
+        return false;
+    }
+    
+    pending = it->second;
+    pending_.erase(it);
+    return true;
+}
+
+void RendererInvokeRouter::OnBatchResponse(CefRefPtr<CefListValue> entries) {
+    if (!entries) {
+        return;
+    }
+    
+    // Entries usually share one context; enter it once per run of entries
+    CefRefPtr<CefV8Context> entered;
+    for (size_t i = 0; i < entries->GetSize(); ++i) {
+        CefRefPtr<CefListValue> entry = entries->GetList(i);
+        PendingInvoke pending;
+        if (!entry || entry->GetSize() < 5 || !TakePending(entry->GetInt(0), pending)) {
+            continue;
+        }
+        
+        if (!entered || !entered->IsSame(pending.context)) {
+            if (entered) {
+                entered->Exit();
+                entered = nullptr;
+            }
+            if (!pending.context->IsValid() || !pending.context->Enter()) {
+                continue;
+            }
+            entered = pending.context;
+        }
+        
+        if (entry->GetBool(1)) {
+            pending.promise->ResolvePromise(ResponseDataToV8Value(entered, entry->GetString(2)));
+        } else {
+            pending.promise->RejectPromise(entry->GetString(3));
+        }
+    }
+    
+    if (entered) {
+        entered->Exit();
+    }
+}
+
+void RendererInvokeRouter::OnEventBatch(CefRefPtr<CefListValue> entries) {
+    if (!entries) {
+        return;
+    }
+    
+    // One listener call per subscription per flush, however many events
+    CefRefPtr<CefV8Context> entered;
+    for (size_t i = 0; i < entries->GetSize(); ++i) {
+        CefRefPtr<CefListValue> entry = entries->GetList(i);
+        if (!entry || entry->GetSize() < 3) {
+            continue;
+        }
+        
+        // Copied: the listener may unsubscribe
+        auto it = subscriptions_.find(entry->GetInt(0));
+        if (it == subscriptions_.end()) {
+            continue;
+        }
+        Subscription subscription = it->second;
+        
+        if (!entered || !entered->IsSame(subscription.context)) {
+            if (entered) {
+                entered->Exit();
+                entered = nullptr;
+            }
+            if (!subscription.context->IsValid() || !subscription.context->Enter()) {
+                continue;
+            }
+            entered = subscription.context;
+        }
+        
+        CefV8ValueList callArgs;
+        CefRefPtr<CefV8Value> events = ParseJSON(entered, entry->GetString(2));
+        callArgs.push_back(events ? events : CefV8Value::CreateNull());
+        callArgs.push_back(CefV8Value::CreateInt(entry->GetInt(1)));
+        subscription.listener->ExecuteFunction(nullptr, callArgs);
+    }
+    
+    if (entered) {
+        entered->Exit();
+    }
+}
+
+// Sends one invoke message. With legacyRequestId == 0 the response is routed
+// back through RendererInvokeRouter and the returned promise; otherwise it
+// arrives through window.mikoview._handleInvokeResponse and nullptr is returned.
+static CefRefPtr<CefV8Value> SendInvoke(CefRefPtr<CefV8Context> context,
+                                        const CefString& method,
+                                        CefRefPtr<CefV8Value> value,
+                                        int legacyRequestId,
+                                        InvokePriority priority) {
+    // ArrayBuffer/TypedArray data travels as raw bytes instead of being
+    // walked key-by-key into JSON
+    std::string data;
+    BinaryView payload;
+    PayloadKind kind = PayloadKind::None;
+    if (Utils::GetV8BinaryData(value, payload)) {
+        kind = PayloadKind::Binary;
+        data = "null";
+    } else {
+        data = Utils::V8ValueToJSON(value);
+        if (data.size() >= IPC::kSharedMemoryThreshold) {
+            kind = PayloadKind::Json;
+            payload.data = reinterpret_cast<const uint8_t*>(data.data());
+            payload.size = data.size();
+        }
+    }
+    
+    int requestId = legacyRequestId;
+    ResponseMode mode = ResponseMode::Script;
+    CefRefPtr<CefV8Value> promise;
+    
+    if (requestId == 0) {
+        promise = CefV8Value::CreatePromise();
+        requestId = RendererInvokeRouter::GetInstance()->AddPending(context, promise);
+        mode = ResponseMode::ProcessMessage;
+    }
+    
+    // Send message to browser process:
+    // [method or id, data, requestId, mode, payloadKind, priority] + optional payload
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeMessage);
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    RendererInvokeRouter::GetInstance()->SetMethodArg(args, 0, method);
+    args->SetString(1, kind == PayloadKind::Json ? std::string() : data);
+    args->SetInt(2, requestId);
+    args->SetInt(3, static_cast<int>(mode));
+    args->SetInt(4, static_cast<int>(kind));
+    args->SetInt(5, static_cast<int>(priority));
+    message = IPC::AttachPayload(message, payload);
+    
+    context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+    return promise;
+}
+
 // V8InvokeHandler implementation
 V8InvokeHandler::V8InvokeHandler() {
 }
@@ -216,127 +1192,340 @@ bool V8InvokeHandler::Execute(const CefString& name,
             return true;
         }
         
-        std::string method = arguments[0]->GetStringValue();
-        std::string data = Utils::V8ValueToJSON(arguments[1]);
-        int requestId = 0;
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (!context || !context->GetFrame()) {
+            exception = "invoke is not available in this context";
+            return true;
+        }
         
+        // Legacy callers pass their own request id and receive the response
+        // through window.mikoview._handleInvokeResponse; everyone else may
+        // pass { priority }
+        int legacyRequestId = 0;
+        InvokePriority priority = InvokePriority::Normal;
         if (arguments.size() > 2 && arguments[2]->IsInt()) {
-            requestId = arguments[2]->GetIntValue();
+            legacyRequestId = arguments[2]->GetIntValue();
+        } else if (arguments.size() > 2 && arguments[2]->IsObject()) {
+            priority = PriorityFromV8(arguments[2]->GetValue("priority"));
         }
         
-        // Send message to browser process
-        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create("invoke");
-        CefRefPtr<CefListValue> args = message->GetArgumentList();
-        args->SetString(0, method);
-        args->SetString(1, data);
-        args->SetInt(2, requestId);
+        CefRefPtr<CefV8Value> promise = SendInvoke(context, arguments[0]->GetStringValue(),
+                                                   arguments[1], legacyRequestId, priority);
+        
+        retval = promise ? promise : CefV8Value::CreateBool(true);
+        return true;
+    }
+    
+    if (name == "cancelInvoke") {
+        // cancelInvoke(promise, reason) -> false if the call already settled
+        if (arguments.empty() || !arguments[0]->IsPromise()) {
+            exception = "cancelInvoke requires a promise returned by invoke";
+            return true;
+        }
         
         CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
-        if (context && context->GetFrame()) {
-            context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        if (!context || !context->GetFrame()) {
+            retval = CefV8Value::CreateBool(false);
+            return true;
+        }
+        
+        std::string reason = "Aborted";
+        if (arguments.size() > 1 && arguments[1]->IsString()) {
+            reason = arguments[1]->GetStringValue();
         }
         
-        retval = CefV8Value::CreateBool(true);
+        retval = CefV8Value::CreateBool(
+            RendererInvokeRouter::GetInstance()->CancelPending(context, arguments[0], reason));
         return true;
     }
     
-    return false;
-}
-
-// Utility functions
-namespace Utils {
-
-std::string V8ValueToJSON(CefRefPtr<CefV8Value> value) {
-    if (!value) {
-        return "null";
-    }
-    
-    if (value->IsNull() || value->IsUndefined()) {
-        return "null";
+    if (name == "invokeStream") {
+        // invokeStream(method, data, sink, chunkSize, credits) -> streamId
+        if (arguments.size() < 3 || !arguments[0]->IsString() || !arguments[2]->IsObject()) {
+            exception = "invokeStream requires method, data and a sink object";
+            return true;
+        }
+        
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (!context || !context->GetFrame()) {
+            exception = "invokeStream is not available in this context";
+            return true;
+        }
+        
+        auto intArg = [&arguments](size_t index, int fallback) {
+            return arguments.size() > index && arguments[index]->IsInt() && arguments[index]->GetIntValue() > 0
+                ? arguments[index]->GetIntValue() : fallback;
+        };
+        
+        std::string data = Utils::V8ValueToJSON(arguments[1]);
+        BinaryView payload;
+        PayloadKind kind = PayloadKind::None;
+        if (data.size() >= IPC::kSharedMemoryThreshold) {
+            kind = PayloadKind::Json;
+            payload.data = reinterpret_cast<const uint8_t*>(data.data());
+            payload.size = data.size();
+        }
+        
+        int streamId = RendererInvokeRouter::GetInstance()->AddStream(context, arguments[2]);
+        
+        // [method or id, data, streamId, chunkSize, credits, payloadKind] + optional payload
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeStreamMessage);
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        RendererInvokeRouter::GetInstance()->SetMethodArg(args, 0, arguments[0]->GetStringValue());
+        args->SetString(1, kind == PayloadKind::Json ? std::string() : data);
+        args->SetInt(2, streamId);
+        args->SetInt(3, intArg(3, 0));
+        args->SetInt(4, intArg(4, 4));
+        args->SetInt(5, static_cast<int>(kind));
+        context->GetFrame()->SendProcessMessage(PID_BROWSER, IPC::AttachPayload(message, payload));
+        
+        retval = CefV8Value::CreateInt(streamId);
+        return true;
     }
     
-    if (value->IsBool()) {
-        return value->GetBoolValue() ? "true" : "false";
+    if (name == "streamAck" || name == "streamCancel") {
+        if (arguments.empty() || !arguments[0]->IsInt()) {
+            exception = name.ToString() + " requires a stream id";
+            return true;
+        }
+        
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (!context || !context->GetFrame()) {
+            return true;
+        }
+        
+        const int streamId = arguments[0]->GetIntValue();
+        CefRefPtr<CefProcessMessage> message;
+        if (name == "streamCancel") {
+            RendererInvokeRouter::GetInstance()->RemoveStream(streamId);
+            message = CefProcessMessage::Create(kInvokeStreamCancelMessage);
+            message->GetArgumentList()->SetInt(0, streamId);
+        } else {
+            message = CefProcessMessage::Create(kInvokeStreamAckMessage);
+            message->GetArgumentList()->SetInt(0, streamId);
+            message->GetArgumentList()->SetInt(1, arguments.size() > 1 && arguments[1]->IsInt()
+                ? arguments[1]->GetIntValue() : 1);
+        }
+        context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        return true;
     }
     
-    if (value->IsInt()) {
-        return std::to_string(value->GetIntValue());
+    if (name == "subscribe") {
+        // subscribe(topic, policy, cap, listener) -> subscriptionId
+        if (arguments.size() < 4 || !arguments[0]->IsString() || !arguments[3]->IsFunction()) {
+            exception = "subscribe requires a topic, policy, cap and listener";
+            return true;
+        }
+        
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (!context || !context->GetFrame()) {
+            exception = "subscribe is not available in this context";
+            return true;
+        }
+        
+        const int subscriptionId = RendererInvokeRouter::GetInstance()->AddSubscription(context, arguments[3]);
+        
+        // [subscriptionId, topic, policy, cap]
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kEventSubscribeMessage);
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        args->SetInt(0, subscriptionId);
+        args->SetString(1, arguments[0]->GetStringValue());
+        args->SetInt(2, static_cast<int>(EventPolicyFromV8(arguments[1])));
+        args->SetInt(3, arguments[2]->IsInt() && arguments[2]->GetIntValue() > 0 ? arguments[2]->GetIntValue() : 0);
+        context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        
+        retval = CefV8Value::CreateInt(subscriptionId);
+        return true;
     }
     
-    if (value->IsDouble()) {
-        return std::to_string(value->GetDoubleValue());
+    if (name == "unsubscribe") {
+        if (arguments.empty() || !arguments[0]->IsInt()) {
+            exception = "unsubscribe requires a subscription id";
+            return true;
+        }
+        
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (!context || !context->GetFrame()) {
+            return true;
+        }
+        
+        const int subscriptionId = arguments[0]->GetIntValue();
+        RendererInvokeRouter::GetInstance()->RemoveSubscription(subscriptionId);
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kEventUnsubscribeMessage);
+        message->GetArgumentList()->SetInt(0, subscriptionId);
+        context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        return true;
     }
     
-    if (value->IsString()) {
-        return "\"" + EscapeJSON(value->GetStringValue()) + "\"";
+    if (name == "invokeBatch") {
+        if (arguments.size() < 1 || !arguments[0]->IsArray()) {
+            exception = "invokeBatch requires an array of { method, data } calls";
+            return true;
+        }
+        
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (!context || !context->GetFrame()) {
+            exception = "invokeBatch is not available in this context";
+            return true;
+        }
+        
+        CefRefPtr<CefV8Value> calls = arguments[0];
+        const int count = calls->GetArrayLength();
+        CefRefPtr<CefV8Value> promises = CefV8Value::CreateArray(count);
+        CefRefPtr<CefListValue> entries = CefListValue::Create();
+        size_t batched = 0;
+        
+        // Validate up front so a bad call does not leave earlier ones pending
+        std::vector<CefString> methods(count);
+        for (int i = 0; i < count; ++i) {
+            CefRefPtr<CefV8Value> call = calls->GetValue(i);
+            CefRefPtr<CefV8Value> method = call && call->IsObject() ? call->GetValue("method") : nullptr;
+            if (!method || !method->IsString()) {
+                exception = "invokeBatch call " + std::to_string(i) + " has no method";
+                return true;
+            }
+            methods[i] = method->GetStringValue();
+        }
+        
+        for (int i = 0; i < count; ++i) {
+            CefRefPtr<CefV8Value> call = calls->GetValue(i);
+            
+            // Binary and shared-memory sized data keep their own message
+            CefRefPtr<CefV8Value> data = call->GetValue("data");
+            const InvokePriority priority = PriorityFromV8(call->GetValue("priority"));
+            BinaryView binary;
+            std::string json;
+            if (Utils::GetV8BinaryData(data, binary) ||
+                (json = Utils::V8ValueToJSON(data)).size() >= IPC::kSharedMemoryThreshold) {
+                promises->SetValue(i, SendInvoke(context, methods[i], data, 0, priority));
+                continue;
+            }
+            
+            CefRefPtr<CefV8Value> promise = CefV8Value::CreatePromise();
+            int requestId = RendererInvokeRouter::GetInstance()->AddPending(context, promise);
+            
+            // [method or id, data, requestId, priority]
+            CefRefPtr<CefListValue> entry = CefListValue::Create();
+            RendererInvokeRouter::GetInstance()->SetMethodArg(entry, 0, methods[i]);
+            entry->SetString(1, json);
+            entry->SetInt(2, requestId);
+            entry->SetInt(3, static_cast<int>(priority));
+            entries->SetList(batched++, entry);
+            promises->SetValue(i, promise);
+        }
+        
+        if (batched > 0) {
+            CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kInvokeBatchMessage);
+            message->GetArgumentList()->SetList(0, entries);
+            context->GetFrame()->SendProcessMessage(PID_BROWSER, message);
+        }
+        
+        retval = promises;
+        return true;
     }
     
-    if (value->IsArray()) {
-        std::ostringstream oss;
-        oss << "[";
+    return false;
+}
+
+// Utility functions
+namespace Utils {
+
+namespace {
+
+// Cyclic objects would otherwise recurse forever
+constexpr int kMaxV8Depth = 60;
+
+void WriteV8Value(JsonWriter& writer, CefRefPtr<CefV8Value> value, int depth) {
+    if (!value || value->IsNull() || value->IsUndefined() || depth > kMaxV8Depth) {
+        writer.Null();
+    } else if (value->IsBool()) {
+        writer.Bool(value->GetBoolValue());
+    } else if (value->IsInt()) {
+        writer.Int(value->GetIntValue());
+    } else if (value->IsDouble()) {
+        writer.Double(value->GetDoubleValue());
+    } else if (value->IsString()) {
+        writer.String(value->GetStringValue().ToString());
+    } else if (value->IsArray()) {
+        writer.BeginArray();
         int length = value->GetArrayLength();
         for (int i = 0; i < length; i++) {
-            if (i > 0) oss << ",";
-            oss << V8ValueToJSON(value->GetValue(i));
+            WriteV8Value(writer, value->GetValue(i), depth + 1);
         }
-        oss << "]";
-        return oss.str();
-    }
-    
-    if (value->IsObject()) {
-        std::ostringstream oss;
-        oss << "{";
+        writer.EndArray();
+    } else if (value->IsObject()) {
+        writer.BeginObject();
         std::vector<CefString> keys;
         value->GetKeys(keys);
-        
-        bool first = true;
         for (const auto& key : keys) {
-            if (!first) oss << ",";
-            oss << "\"" << EscapeJSON(key) << "\":" << V8ValueToJSON(value->GetValue(key));
-            first = false;
+            writer.Key(key.ToString());
+            WriteV8Value(writer, value->GetValue(key), depth + 1);
         }
-        oss << "}";
-        return oss.str();
+        writer.EndObject();
+    } else {
+        writer.Null();
     }
-    
-    return "null";
+}
+
+} // namespace
+
+std::string V8ValueToJSON(CefRefPtr<CefV8Value> value) {
+    JsonWriter writer;
+    WriteV8Value(writer, value, 0);
+    return writer.Release();
 }
 
 CefRefPtr<CefV8Value> JSONToV8Value(const std::string& json) {
-    try {
-        Json::Value root;
-        Json::Reader reader;
-        if (!reader.parse(json, root)) {
-            return CefV8Value::CreateNull();
+    CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+    CefRefPtr<CefV8Value> value = context ? RendererInvokeRouter::GetInstance()->ParseJSON(context, json) : nullptr;
+    return value ? value : CefV8Value::CreateNull();
+}
+
+bool GetV8BinaryData(CefRefPtr<CefV8Value> value, BinaryView& binary) {
+    static const uint8_t kEmpty[1] = {0};
+    
+    if (!value || !value->IsObject()) {
+        return false;
+    }
+    
+    CefRefPtr<CefV8Value> buffer = value;
+    size_t offset = 0;
+    size_t length = 0;
+    
+    if (value->IsArrayBuffer()) {
+        length = value->GetArrayBufferByteLength();
+    } else {
+        // TypedArray and DataView expose their backing store through
+        // buffer/byteOffset/byteLength
+        if (value->IsArray() || value->IsFunction() || !value->HasValue("buffer")) {
+            return false;
+        }
+        buffer = value->GetValue("buffer");
+        CefRefPtr<CefV8Value> byteOffset = value->GetValue("byteOffset");
+        CefRefPtr<CefV8Value> byteLength = value->GetValue("byteLength");
+        if (!buffer || !buffer->IsArrayBuffer() || !byteOffset || !byteLength ||
+            !(byteOffset->IsInt() || byteOffset->IsUInt()) ||
+            !(byteLength->IsInt() || byteLength->IsUInt())) {
+            return false;
+        }
+        offset = byteOffset->GetUIntValue();
+        length = byteLength->GetUIntValue();
+        if (offset + length > buffer->GetArrayBufferByteLength()) {
+            return false;
         }
-        
-        return JsonValueToV8Value(root);
-    } catch (...) {
-        return CefV8Value::CreateNull();
     }
+    
+    const uint8_t* data = static_cast<const uint8_t*>(buffer->GetArrayBufferData());
+    binary.data = data ? data + offset : kEmpty;
+    binary.size = data ? length : 0;
+    return true;
 }
 
 std::string EscapeJSON(const std::string& str) {
-    std::ostringstream oss;
-    for (char c : str) {
-        switch (c) {
-            case '"': oss << "\\\""; break;
-            case '\\': oss << "\\\\"; break;
-            case '\b': oss << "\\b"; break;
-            case '\f': oss << "\\f"; break;
-            case '\n': oss << "\\n"; break;
-            case '\r': oss << "\\r"; break;
-            case '\t': oss << "\\t"; break;
-            default:
-                if (c < 0x20) {
-                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
-                } else {
-                    oss << c;
-                }
-                break;
-        }
-    }
-    return oss.str();
+    std::string escaped;
+    escaped.reserve(str.size() + 8);
+    JsonWriter::AppendEscaped(escaped, str);
+    return escaped;
 }
 
 std::string UnescapeJSON(const std::string& str) {
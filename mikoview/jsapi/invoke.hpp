@@ -4,101 +4,300 @@
 #include "cef_browser.h"
 #include "cef_frame.h"
 #include "cef_process_message.h"
+#include "dispatcher.hpp"
+#include "timerwheel.hpp"
 #include <string>
 #include <functional>
 #include <map>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 namespace MikoView {
 namespace JSAPI {
 
 // Forward declarations
 class InvokeHandler;
-class InvokeRequest;
-class InvokeResponse;
 
-// Callback types
-using InvokeCallback = std::function<void(const std::string& result, bool success)>;
-using NativeHandler = std::function<void(const InvokeRequest& request, InvokeResponse& response)>;
+// Process message names
+constexpr char kInvokeMessage[] = "invoke";
+constexpr char kInvokeResponseMessage[] = "invokeResponse";
+constexpr char kInvokeBatchMessage[] = "invokeBatch";
+constexpr char kInvokeBatchResponseMessage[] = "invokeBatchResponse";
+constexpr char kInvokeCancelMessage[] = "invokeCancel";  // renderer -> browser: [requestId]
+constexpr char kInvokeMethodIdMessage[] = "invokeMethodId";  // browser -> renderer: [method, id]
 
-// Request/Response structures
-class InvokeRequest {
-public:
-    InvokeRequest(const std::string& method, const std::string& data, int requestId);
-    
-    const std::string& GetMethod() const { return method_; }
-    const std::string& GetData() const { return data_; }
-    int GetRequestId() const { return requestId_; }
-    
-    // Parse JSON data
-    template<typename T>
-    bool GetParam(const std::string& key, T& value) const;
-    
-private:
-    std::string method_;
-    std::string data_;
-    int requestId_;
+// Process message names for streaming invokes
+constexpr char kInvokeStreamMessage[] = "invokeStream";             // renderer -> browser: open
+constexpr char kInvokeStreamChunkMessage[] = "invokeStreamChunk";   // browser -> renderer: chunk/end/error
+constexpr char kInvokeStreamAckMessage[] = "invokeStreamAck";       // renderer -> browser: grant credits
+constexpr char kInvokeStreamCancelMessage[] = "invokeStreamCancel"; // renderer -> browser: stop
+
+// Process message names for events (see EventHub)
+constexpr char kEventSubscribeMessage[] = "eventSubscribe";      // renderer -> browser: [subscriptionId, topic, policy, cap]
+constexpr char kEventUnsubscribeMessage[] = "eventUnsubscribe";  // renderer -> browser: [subscriptionId]
+constexpr char kEventBatchMessage[] = "eventBatch";              // browser -> renderer: one flush
+
+// Method the renderer invokes to answer InvokeRenderer()
+constexpr char kRendererResponseMethod[] = "_invokeResponse";
+constexpr int kDefaultRendererTimeoutMs = 5000;
+
+// Worker-pool calls one frame may have outstanding before it gets a 503
+constexpr size_t kDefaultMaxInFlightPerFrame = kDefaultMaxInFlightPerClient;
+
+// How the browser process delivers a response to the renderer
+enum class ResponseMode {
+    Script = 0,          // ExecuteJavaScript calling window.mikoview._handleInvokeResponse (legacy)
+    ProcessMessage = 1   // kInvokeResponseMessage resolved by RendererInvokeRouter
 };
 
-class InvokeResponse {
-public:
-    InvokeResponse(int requestId);
-    
-    void SetSuccess(const std::string& data);
-    void SetError(const std::string& error, int code = -1);
-    
-    bool IsSuccess() const { return success_; }
-    const std::string& GetData() const { return data_; }
-    const std::string& GetError() const { return error_; }
-    int GetErrorCode() const { return errorCode_; }
-    int GetRequestId() const { return requestId_; }
-    
-    std::string ToJSON() const;
-    
-private:
-    int requestId_;
-    bool success_;
-    std::string data_;
-    std::string error_;
-    int errorCode_;
+// What InvokeRendererAsync() resumes with
+struct RendererResult {
+    std::string result;
+    bool success;
+};
+
+// Native-to-renderer call bookkeeping (see InvokeHandler::InvokeRenderer)
+struct RendererInvokeStats {
+    size_t pending = 0;
+    uint64_t completed = 0;
+    uint64_t timedOut = 0;
+    uint64_t cancelled = 0;   // browser closed first
+    uint64_t evicted = 0;     // pending table was full
+    uint64_t misrouted = 0;   // unknown request id or wrong browser
 };
 
-// Main invoke handler
+// CEF transport for InvokeDispatcher: decodes process messages from the
+// renderer, answers through the requesting frame, and owns native-to-renderer
+// calls. Sessions are browser ids; the in-flight limit applies per frame.
 class InvokeHandler {
 public:
+    // Also points Executor::PostToUI at TID_UI
     static InvokeHandler* GetInstance();
     
-    // Register native handlers
-    void RegisterHandler(const std::string& method, NativeHandler handler);
+    // Register native handlers (forwarded to InvokeDispatcher)
+    void RegisterHandler(const std::string& method, NativeHandler handler,
+                         HandlerOptions options = HandlerOptions());
     void UnregisterHandler(const std::string& method);
     
-    // Handle invoke from renderer
+    // Coroutine handlers (see InvokeDispatcher::RegisterAsyncHandler)
+    void RegisterAsyncHandler(const std::string& method, AsyncHandler handler,
+                              HandlerOptions options = HandlerOptions());
+    
+    // Streaming handlers answer mikoview.invokeStream()
+    void RegisterStreamHandler(const std::string& method, StreamHandler handler,
+                               HandlerOptions options = HandlerAffinity::IO);
+    void UnregisterStreamHandler(const std::string& method);
+    
+    // Browser-process entry point, called from SimpleClient::OnProcessMessageReceived
+    bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefProcessMessage> message);
+    
+    // Handle invoke from renderer. mode has no default: Script is the legacy
+    // eval path and has to be asked for.
     void HandleInvoke(CefRefPtr<CefBrowser> browser, 
                      CefRefPtr<CefFrame> frame,
                      const std::string& method,
                      const std::string& data,
-                     int requestId);
+                     int requestId,
+                     ResponseMode mode);
+    void HandleInvoke(CefRefPtr<CefBrowser> browser,
+                     CefRefPtr<CefFrame> frame,
+                     const InvokeRequest& request,
+                     ResponseMode mode);
     
-    // Send response back to renderer
+    // Dispatches every request in the batch (non-UI handlers in parallel) and
+    // answers with a single kInvokeBatchResponseMessage once all have finished
+    void HandleInvokeBatch(CefRefPtr<CefBrowser> browser,
+                          CefRefPtr<CefFrame> frame,
+                          std::vector<InvokeRequest> requests);
+    
+    // Starts a streaming handler; chunks flow back as kInvokeStreamChunkMessage
+    void HandleInvokeStream(CefRefPtr<CefBrowser> browser,
+                           CefRefPtr<CefFrame> frame,
+                           const InvokeRequest& request,
+                           size_t chunkSize,
+                           int credits);
+    
+    // Send response back to renderer. The two-argument form is the legacy
+    // ResponseMode::Script path through the main frame.
     void SendResponse(CefRefPtr<CefBrowser> browser,
                      const InvokeResponse& response);
+    void SendResponse(CefRefPtr<CefBrowser> browser,
+                     CefRefPtr<CefFrame> frame,
+                     const InvokeResponse& response,
+                     ResponseMode mode);
     
-    // Invoke from native to renderer
+    // Invoke from native to renderer. Callable from any thread. The callback
+    // runs on TID_UI exactly once: with the renderer's result, or with
+    // success = false on timeout, browser close or eviction from a full
+    // pending table. timeoutMs <= 0 waits until the browser closes.
     void InvokeRenderer(CefRefPtr<CefBrowser> browser,
                        const std::string& method,
                        const std::string& data,
-                       InvokeCallback callback = nullptr);
+                       InvokeCallback callback = nullptr,
+                       int timeoutMs = kDefaultRendererTimeoutMs);
+    
+    // Sends json to the topic's subscribers (mikoview.subscribe), batched and
+    // coalesced by EventHub. Callable from any thread. Prefer it to
+    // InvokeRenderer() for anything pushed more than a few times a second.
+    void Publish(const std::string& topic, std::string json);
+    
+    // InvokeRenderer() for coroutine handlers; resumes on TID_UI
+    //
+    //   RendererResult answer = co_await handler->InvokeRendererAsync(browser, "confirm", "{}");
+    Async::FromCallback<RendererResult> InvokeRendererAsync(CefRefPtr<CefBrowser> browser,
+                                                            const std::string& method,
+                                                            const std::string& data,
+                                                            int timeoutMs = kDefaultRendererTimeoutMs);
+    
+    // Fails every pending renderer call and cancels every stream for the
+    // browser; from OnBeforeClose
+    void OnBrowserClosed(CefRefPtr<CefBrowser> browser);
+    
+    // Oldest calls are evicted beyond this many pending renderer calls
+    void SetMaxPendingRendererCalls(size_t maxPending) { maxPendingCalls_ = maxPending; }
+    
+    // Deadline for worker-pool handlers registered without one; 0 disables
+    void SetDefaultTimeout(int timeoutMs);
+    
+    // Worker-pool calls a frame may have outstanding; 0 disables the limit
+    void SetMaxInFlightPerFrame(size_t maxInFlight);
+    
+    // Drops cached answers of idempotent handlers (see HandlerOptions), of
+    // one method or all; for changes made outside invoke. UI thread only.
+    void InvalidateCache(const std::string& method);
+    void InvalidateCache();
+    
+    // Opt-in recording of every request the renderer sends (method,
+    // payload, arrival time, frame) to a binary log that `invokehost replay`
+    // feeds back into the handlers. maxBytes 0 = no limit. Any thread.
+    bool StartRecording(const std::string& path, uint64_t maxBytes = 0, std::string* error = nullptr);
+    void StopRecording();
+    
+    // UI thread only
+    RendererInvokeStats GetRendererInvokeStats() const;
+    InvokeCallStats GetInvokeCallStats() const;
     
 private:
     InvokeHandler() = default;
     static std::unique_ptr<InvokeHandler> instance_;
     
-    std::map<std::string, NativeHandler> handlers_;
-    std::map<int, InvokeCallback> pendingCallbacks_;
+    struct PendingRendererCall {
+        int browserId;
+        InvokeCallback callback;
+    };
+    
+    // Native-to-renderer calls, keyed by request id (so begin() is the oldest)
+    std::map<int, PendingRendererCall> pendingCallbacks_;
+    TimerWheel rendererTimeouts_{50, 256};
+    bool timeoutTickScheduled_ = false;
+    size_t maxPendingCalls_ = 4096;
+    RendererInvokeStats rendererStats_;
     int nextRequestId_;
     
     int GenerateRequestId();
+    
+    // Handler for kRendererResponseMethod; the request's session is the browser
+    void OnRendererResponse(const InvokeRequest& request);
+    void CompleteRendererCall(std::map<int, PendingRendererCall>::iterator it,
+                             const std::string& result, bool success);
+    void ScheduleTimeoutTick();
+    void OnTimeoutTick();
+};
+
+// Renderer-process side of invoke. Owns the promises returned by
+// mikoview.invoke() and resolves them from kInvokeResponseMessage.
+// All methods run on the renderer main thread.
+class RendererInvokeRouter {
+public:
+    static RendererInvokeRouter* GetInstance();
+    
+    // Installs window.mikoview.invoke
+    void OnContextCreated(CefRefPtr<CefBrowser> browser,
+                         CefRefPtr<CefFrame> frame,
+                         CefRefPtr<CefV8Context> context);
+    void OnContextReleased(CefRefPtr<CefBrowser> browser,
+                          CefRefPtr<CefFrame> frame,
+                          CefRefPtr<CefV8Context> context);
+    bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefProcessMessage> message);
+    
+    // Returns the request id to send with the invoke message
+    int AddPending(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> promise);
+    
+    // Rejects the promise returned by mikoview.invoke() with reason and
+    // tells the browser to cancel the call. False if it already settled.
+    bool CancelPending(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> promise,
+                       const std::string& reason);
+    
+    // Consumer side of mikoview.invokeStream(); sink has chunk/end/error
+    // methods. Returns the stream id to send with the invokeStream message.
+    int AddStream(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> sink);
+    void RemoveStream(int streamId) { streams_.erase(streamId); }
+    
+    // Listener side of mikoview.subscribe(); called with (events, dropped)
+    // once per flush. Returns the subscription id to send with the
+    // eventSubscribe message.
+    int AddSubscription(CefRefPtr<CefV8Context> context, CefRefPtr<CefV8Value> listener);
+    void RemoveSubscription(int subscriptionId) { subscriptions_.erase(subscriptionId); }
+    
+    // Writes the method's interned id into args[index] once the browser has
+    // announced it (kInvokeMethodIdMessage), and the name until then
+    void SetMethodArg(CefRefPtr<CefListValue> args, size_t index, const CefString& method) const;
+    
+    // JSON.parse in context, which must be entered; nullptr if json is not
+    // JSON. Uses the JSON.parse the context started with, so page script
+    // replacing it does not see native responses.
+    CefRefPtr<CefV8Value> ParseJSON(CefRefPtr<CefV8Context> context, const CefString& json);
+    
+private:
+    RendererInvokeRouter() = default;
+    
+    struct PendingInvoke {
+        CefRefPtr<CefV8Context> context;
+        CefRefPtr<CefV8Value> promise;
+    };
+    
+    struct PendingStream {
+        CefRefPtr<CefV8Context> context;
+        CefRefPtr<CefV8Value> sink;
+    };
+    
+    struct Subscription {
+        CefRefPtr<CefV8Context> context;
+        CefRefPtr<CefV8Value> listener;
+    };
+    
+    // A context's original JSON.parse, taken in OnContextCreated
+    struct ContextParser {
+        CefRefPtr<CefV8Context> context;
+        CefRefPtr<CefV8Value> parse;
+    };
+    
+    bool TakePending(int requestId, PendingInvoke& pending);
+    // Response and chunk data: JSON, or a string when it is not JSON
+    CefRefPtr<CefV8Value> ResponseDataToV8Value(CefRefPtr<CefV8Context> context, const CefString& data);
+    CefRefPtr<CefV8Value> ResponseDataToV8Value(CefRefPtr<CefV8Context> context, const BinaryView& data);
+    void OnBatchResponse(CefRefPtr<CefListValue> entries);
+    void OnStreamMessage(CefRefPtr<CefProcessMessage> message);
+    void OnEventBatch(CefRefPtr<CefListValue> entries);
+    
+    std::map<int, PendingInvoke> pending_;
+    int nextRequestId_ = 1;
+    std::map<int, PendingStream> streams_;
+    int nextStreamId_ = 1;
+    std::map<int, Subscription> subscriptions_;
+    int nextSubscriptionId_ = 1;
+    // One entry per live context; a renderer has few, so lookups scan
+    std::vector<ContextParser> parsers_;
+    
+    // Ids are fixed for the browser process's lifetime, so one table serves
+    // every browser and context in this renderer. Keyed by the V8 string
+    // as-is, so a lookup converts nothing.
+    std::map<CefString, int> methodIds_;
 };
 
 // V8 Handler for JavaScript side
@@ -119,7 +318,11 @@ private:
 // Utility functions
 namespace Utils {
     std::string V8ValueToJSON(CefRefPtr<CefV8Value> value);
+    // Parses with JSON.parse in the current context; null if json is not JSON
     CefRefPtr<CefV8Value> JSONToV8Value(const std::string& json);
+    
+    // ArrayBuffer, TypedArray or DataView contents; false for anything else
+    bool GetV8BinaryData(CefRefPtr<CefV8Value> value, BinaryView& binary);
     std::string EscapeJSON(const std::string& str);
     std::string UnescapeJSON(const std::string& str);
 }
@@ -0,0 +1,207 @@
+#include "ipc.hpp"
+#include "../logger.hpp"
+#include <cstring>
+#include <string>
+
+namespace MikoView {
+namespace JSAPI {
+namespace IPC {
+
+namespace {
+
+// Shared memory layout: [u32 argsSize][encoded args][payload bytes]
+// Encoded args: per value a type byte followed by its data.
+enum ArgTag : uint8_t {
+    kTagNull = 0,
+    kTagBool = 1,
+    kTagInt = 2,
+    kTagDouble = 3,
+    kTagString = 4
+};
+
+const uint8_t kEmptyPayload[1] = {0};
+
+void AppendBytes(std::string& out, const void* data, size_t size) {
+    out.append(static_cast<const char*>(data), size);
+}
+
+std::string EncodeArgs(CefRefPtr<CefListValue> args) {
+    std::string out;
+    const size_t count = args ? args->GetSize() : 0;
+    for (size_t i = 0; i < count; ++i) {
+        switch (args->GetType(i)) {
+            case VTYPE_BOOL: {
+                uint8_t tag = kTagBool, value = args->GetBool(i) ? 1 : 0;
+                AppendBytes(out, &tag, 1);
+                AppendBytes(out, &value, 1);
+                break;
+            }
+            case VTYPE_INT: {
+                uint8_t tag = kTagInt;
+                int32_t value = args->GetInt(i);
+                AppendBytes(out, &tag, 1);
+                AppendBytes(out, &value, sizeof(value));
+                break;
+            }
+            case VTYPE_DOUBLE: {
+                uint8_t tag = kTagDouble;
+                double value = args->GetDouble(i);
+                AppendBytes(out, &tag, 1);
+                AppendBytes(out, &value, sizeof(value));
+                break;
+            }
+            case VTYPE_STRING: {
+                uint8_t tag = kTagString;
+                std::string value = args->GetString(i);
+                uint32_t size = static_cast<uint32_t>(value.size());
+                AppendBytes(out, &tag, 1);
+                AppendBytes(out, &size, sizeof(size));
+                AppendBytes(out, value.data(), value.size());
+                break;
+            }
+            default: {
+                // Lists, dictionaries and binaries are not used as invoke arguments
+                uint8_t tag = kTagNull;
+                AppendBytes(out, &tag, 1);
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+bool DecodeArgs(const uint8_t* data, size_t size, CefRefPtr<CefListValue> args) {
+    size_t pos = 0;
+    size_t index = 0;
+    auto read = [&](void* dst, size_t n) {
+        if (size - pos < n) return false;
+        std::memcpy(dst, data + pos, n);
+        pos += n;
+        return true;
+    };
+    
+    while (pos < size) {
+        uint8_t tag = 0;
+        if (!read(&tag, 1)) return false;
+        
+        switch (tag) {
+            case kTagNull:
+                args->SetNull(index);
+                break;
+            case kTagBool: {
+                uint8_t value = 0;
+                if (!read(&value, 1)) return false;
+                args->SetBool(index, value != 0);
+                break;
+            }
+            case kTagInt: {
+                int32_t value = 0;
+                if (!read(&value, sizeof(value))) return false;
+                args->SetInt(index, value);
+                break;
+            }
+            case kTagDouble: {
+                double value = 0;
+                if (!read(&value, sizeof(value))) return false;
+                args->SetDouble(index, value);
+                break;
+            }
+            case kTagString: {
+                uint32_t length = 0;
+                if (!read(&length, sizeof(length)) || size - pos < length) return false;
+                args->SetString(index, std::string(reinterpret_cast<const char*>(data + pos), length));
+                pos += length;
+                break;
+            }
+            default:
+                return false;
+        }
+        index++;
+    }
+    return true;
+}
+
+} // namespace
+
+CefRefPtr<CefProcessMessage> AttachPayload(CefRefPtr<CefProcessMessage> message, BinaryView payload) {
+    if (payload.IsNull()) {
+        return message;
+    }
+    
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    
+    if (payload.size < kSharedMemoryThreshold) {
+        args->SetBinary(args->GetSize(), CefBinaryValue::Create(payload.data, payload.size));
+        return message;
+    }
+    
+    std::string header = EncodeArgs(args);
+    uint32_t headerSize = static_cast<uint32_t>(header.size());
+    size_t total = sizeof(headerSize) + header.size() + payload.size;
+    
+    CefRefPtr<CefSharedProcessMessageBuilder> builder =
+        CefSharedProcessMessageBuilder::Create(message->GetName(), total);
+    if (!builder || !builder->IsValid()) {
+        // Fall back to copying through the argument list
+        Logger::Warning("Shared memory unavailable for " + std::to_string(payload.size) + " byte payload");
+        args->SetBinary(args->GetSize(), CefBinaryValue::Create(payload.data, payload.size));
+        return message;
+    }
+    
+    uint8_t* memory = static_cast<uint8_t*>(builder->Memory());
+    std::memcpy(memory, &headerSize, sizeof(headerSize));
+    std::memcpy(memory + sizeof(headerSize), header.data(), header.size());
+    std::memcpy(memory + sizeof(headerSize) + header.size(), payload.data, payload.size);
+    
+    return builder->Build();
+}
+
+bool ReadMessage(CefRefPtr<CefProcessMessage> message, size_t argCount, ReceivedMessage& out) {
+    out = ReceivedMessage();
+    
+    CefRefPtr<CefSharedMemoryRegion> region = message->GetSharedMemoryRegion();
+    if (region && region->IsValid()) {
+        const uint8_t* memory = static_cast<const uint8_t*>(region->Memory());
+        const size_t size = region->Size();
+        
+        uint32_t headerSize = 0;
+        if (size < sizeof(headerSize)) return false;
+        std::memcpy(&headerSize, memory, sizeof(headerSize));
+        if (size - sizeof(headerSize) < headerSize) return false;
+        
+        out.args = CefListValue::Create();
+        if (!DecodeArgs(memory + sizeof(headerSize), headerSize, out.args)) return false;
+        
+        out.payload.data = memory + sizeof(headerSize) + headerSize;
+        out.payload.size = size - sizeof(headerSize) - headerSize;
+        out.owner = std::make_shared<CefRefPtr<CefSharedMemoryRegion>>(region);
+        return out.args->GetSize() >= argCount;
+    }
+    
+    out.args = message->GetArgumentList();
+    if (!out.args || out.args->GetSize() < argCount) {
+        return false;
+    }
+    
+    if (out.args->GetSize() > argCount && out.args->GetType(argCount) == VTYPE_BINARY) {
+        // The argument list, and the binary value's bytes with it, is freed
+        // once OnProcessMessageReceived returns, while the request may still
+        // be on a worker pool, so the bytes are copied out. They are usually
+        // under kSharedMemoryThreshold; a larger one means AttachPayload
+        // found no shared memory and inlined it, and it is copied here on
+        // the UI thread all the same.
+        CefRefPtr<CefBinaryValue> binary = out.args->GetBinary(argCount);
+        auto bytes = std::make_shared<std::string>(binary->GetSize(), '\0');
+        if (!bytes->empty()) {
+            binary->GetData(&(*bytes)[0], bytes->size(), 0);
+        }
+        out.payload.data = bytes->empty() ? kEmptyPayload : reinterpret_cast<const uint8_t*>(bytes->data());
+        out.payload.size = bytes->size();
+        out.owner = std::move(bytes);
+    }
+    return true;
+}
+
+} // namespace IPC
+} // namespace JSAPI
+} // namespace MikoView
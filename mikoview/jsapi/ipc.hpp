@@ -0,0 +1,36 @@
+#pragma once
+
+#include "request.hpp"
+#include "cef_process_message.h"
+#include "cef_values.h"
+#include <memory>
+
+namespace MikoView {
+namespace JSAPI {
+namespace IPC {
+
+// Payloads at or above this size travel in a CefSharedMemoryRegion instead
+// of being copied into the message's argument list
+constexpr size_t kSharedMemoryThreshold = 64 * 1024;
+
+// Appends `payload` to a message whose arguments are already filled in.
+// Small payloads become a trailing CefBinaryValue argument; large ones are
+// moved, together with the arguments, into a shared memory message built
+// with CefSharedProcessMessageBuilder. Returns the message to send.
+CefRefPtr<CefProcessMessage> AttachPayload(CefRefPtr<CefProcessMessage> message, BinaryView payload);
+
+// Arguments and payload of a received message. `payload` points into
+// memory kept alive by `owner`.
+struct ReceivedMessage {
+    CefRefPtr<CefListValue> args;
+    BinaryView payload;
+    std::shared_ptr<const void> owner;
+};
+
+// Reads a message built by AttachPayload. `argCount` is the number of
+// arguments that precede the optional payload.
+bool ReadMessage(CefRefPtr<CefProcessMessage> message, size_t argCount, ReceivedMessage& out);
+
+} // namespace IPC
+} // namespace JSAPI
+} // namespace MikoView
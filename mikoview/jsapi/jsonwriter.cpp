@@ -0,0 +1,238 @@
+#include "jsonwriter.hpp"
+#include <charconv>
+#include <cmath>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define MIKO_JSON_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define MIKO_JSON_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+inline bool NeedsEscape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+inline unsigned CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Offset of the first byte in [p, end) that needs escaping, or end - p
+size_t FindEscape(const char* p, const char* end) {
+    const char* start = p;
+
+#if defined(MIKO_JSON_AVX2)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        // max_epu8(c, 0x1F) == 0x1F exactly when c <= 0x1F (unsigned)
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return (p - start) + CountTrailingZeros(mask);
+        }
+        p += 32;
+    }
+#endif
+
+#if defined(MIKO_JSON_AVX2) || defined(MIKO_JSON_SSE2)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i control16 = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote16), _mm_cmpeq_epi8(chunk, backslash16)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control16), control16));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return (p - start) + CountTrailingZeros(mask);
+        }
+        p += 16;
+    }
+#endif
+
+    while (p < end && !NeedsEscape(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    return p - start;
+}
+
+} // namespace
+
+void JsonWriter::AppendEscaped(std::string& out, std::string_view str) {
+    static const char kHex[] = "0123456789abcdef";
+
+    const char* p = str.data();
+    const char* end = p + str.size();
+    while (p < end) {
+        size_t clean = FindEscape(p, end);
+        out.append(p, clean);
+        p += clean;
+        if (p >= end) {
+            break;
+        }
+
+        unsigned char c = static_cast<unsigned char>(*p++);
+        switch (c) {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\b': out.append("\\b", 2); break;
+            case '\f': out.append("\\f", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                out.append(escape, 6);
+                break;
+            }
+        }
+    }
+}
+
+void JsonWriter::AppendDouble(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        // JSON has no NaN/Infinity; match JSON.stringify
+        out.append("null", 4);
+        return;
+    }
+
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
+
+void JsonWriter::BeforeValue() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+
+    const uint64_t bit = uint64_t(1) << depth_;
+    if (first_ & bit) {
+        first_ &= ~bit;
+    } else {
+        buffer_ += ',';
+    }
+}
+
+JsonWriter& JsonWriter::BeginObject() {
+    BeforeValue();
+    buffer_ += '{';
+    ++depth_;
+    first_ |= uint64_t(1) << depth_;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+    buffer_ += '}';
+    --depth_;
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray() {
+    BeforeValue();
+    buffer_ += '[';
+    ++depth_;
+    first_ |= uint64_t(1) << depth_;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray() {
+    buffer_ += ']';
+    --depth_;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key) {
+    BeforeValue();
+    buffer_ += '"';
+    AppendEscaped(buffer_, key);
+    buffer_.append("\":", 2);
+    afterKey_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(std::string_view value) {
+    BeforeValue();
+    buffer_.reserve(buffer_.size() + value.size() + 2);
+    buffer_ += '"';
+    AppendEscaped(buffer_, value);
+    buffer_ += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::Int(int64_t value) {
+    BeforeValue();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    buffer_.append(buffer, result.ptr - buffer);
+    return *this;
+}
+
+JsonWriter& JsonWriter::UInt(uint64_t value) {
+    BeforeValue();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    buffer_.append(buffer, result.ptr - buffer);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Double(double value) {
+    BeforeValue();
+    AppendDouble(buffer_, value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Bool(bool value) {
+    BeforeValue();
+    if (value) {
+        buffer_.append("true", 4);
+    } else {
+        buffer_.append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::Null() {
+    BeforeValue();
+    buffer_.append("null", 4);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Raw(std::string_view json) {
+    BeforeValue();
+    buffer_.append(json.data(), json.size());
+    return *this;
+}
+
+void JsonWriter::Clear() {
+    buffer_.clear();
+    depth_ = 0;
+    first_ = 1;
+    afterKey_ = false;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
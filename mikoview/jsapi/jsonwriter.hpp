@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Streaming JSON writer that appends into a single growable buffer.
+// Commas and colons are inserted automatically:
+//
+//   JsonWriter writer;
+//   writer.BeginObject().Key("path").String(path).Key("size").UInt(size).EndObject();
+//   std::string json = writer.Release();
+class JsonWriter {
+public:
+    JsonWriter() = default;
+    explicit JsonWriter(size_t reserve) { buffer_.reserve(reserve); }
+    // Writes after what buffer already holds; Release() hands it back
+    explicit JsonWriter(std::string&& buffer) : buffer_(std::move(buffer)) {}
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+    JsonWriter& Key(std::string_view key);
+
+    JsonWriter& String(std::string_view value);
+    JsonWriter& Int(int64_t value);
+    JsonWriter& UInt(uint64_t value);
+    JsonWriter& Double(double value);
+    JsonWriter& Bool(bool value);
+    JsonWriter& Null();
+
+    // Already-serialized JSON, spliced in as a value
+    JsonWriter& Raw(std::string_view json);
+
+    const std::string& GetString() const { return buffer_; }
+    std::string Release() { return std::move(buffer_); }
+    void Clear();
+
+    // Appends str with JSON escaping (no surrounding quotes). Clean runs are
+    // found 16/32 bytes at a time with SSE2/AVX2 and copied in bulk.
+    static void AppendEscaped(std::string& out, std::string_view str);
+
+    // Shortest representation that round-trips; non-finite values become null
+    static void AppendDouble(std::string& out, double value);
+
+private:
+    void BeforeValue();
+
+    std::string buffer_;
+    int depth_ = 0;
+    uint64_t first_ = 1;  // bit per nesting level: no element written yet
+    bool afterKey_ = false;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
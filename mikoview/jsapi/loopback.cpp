@@ -0,0 +1,227 @@
+#include "loopback.hpp"
+#include "executor.hpp"
+#include <future>
+#include <map>
+#include <mutex>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Callbacks are registered on the caller's thread and taken on the UI thread
+class LoopbackTransport::Channel : public InvokeChannel {
+public:
+    Channel()
+        : sessionId_(InvokeDispatcher::NewSessionId()),
+          clientKey_("loopback:" + std::to_string(sessionId_)) {
+    }
+    
+    int GetSessionId() const override { return sessionId_; }
+    const std::string& GetClientKey() const override { return clientKey_; }
+    
+    void AddCall(int requestId, ResponseCallback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        calls_[requestId] = std::move(callback);
+    }
+    
+    void AddStream(int streamId, StreamCallback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_[streamId] = std::move(callback);
+    }
+    
+    void AddSubscription(int subscriptionId, EventCallback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_[subscriptionId] = std::move(callback);
+    }
+    
+    void RemoveSubscription(int subscriptionId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscriptions_.erase(subscriptionId);
+    }
+    
+    void Detach() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        calls_.clear();
+        streams_.clear();
+        subscriptions_.clear();
+    }
+    
+    void SendResponse(const InvokeResponse& response) override {
+        ResponseCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = calls_.find(response.GetRequestId());
+            if (it == calls_.end()) {
+                return;
+            }
+            callback = std::move(it->second);
+            calls_.erase(it);
+        }
+        
+        if (callback) {
+            callback(response);
+        }
+    }
+    
+    void SendStreamMessage(int streamId, StreamEvent event, const std::string* data,
+                           bool binary, const std::string& error, int code) override {
+        StreamCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = streams_.find(streamId);
+            if (it == streams_.end()) {
+                return;
+            }
+            // The last message for a stream takes its callback with it
+            if (event == StreamEvent::Chunk) {
+                callback = it->second;
+            } else {
+                callback = std::move(it->second);
+                streams_.erase(it);
+            }
+        }
+        
+        if (callback) {
+            callback(event, data, binary, error, code);
+        }
+    }
+    
+    void SendEvents(const std::vector<EventDelivery>& deliveries) override {
+        for (const EventDelivery& delivery : deliveries) {
+            EventCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = subscriptions_.find(delivery.subscriptionId);
+                if (it == subscriptions_.end()) {
+                    continue;
+                }
+                callback = it->second;
+            }
+            
+            if (callback) {
+                callback(delivery.events, delivery.dropped);
+            }
+        }
+    }
+    
+private:
+    const int sessionId_;
+    const std::string clientKey_;
+    std::mutex mutex_;
+    std::map<int, ResponseCallback, std::less<int>, PoolAllocator<std::pair<const int, ResponseCallback>>> calls_;
+    std::map<int, StreamCallback> streams_;
+    std::map<int, EventCallback> subscriptions_;
+};
+
+namespace {
+
+// A call on its way to the UI thread. Posted by pointer, which fits in
+// std::function's inline storage.
+struct PendingCall {
+    static void* operator new(size_t size) { return BlockPool::Allocate(size); }
+    static void operator delete(void* block, size_t size) noexcept { BlockPool::Deallocate(block, size); }
+    
+    std::shared_ptr<InvokeChannel> channel;
+    InvokeRequest request;
+};
+
+} // namespace
+
+LoopbackTransport::LoopbackTransport() : channel_(std::make_shared<Channel>()) {
+}
+
+LoopbackTransport::~LoopbackTransport() {
+    channel_->Detach();
+    const int sessionId = channel_->GetSessionId();
+    Executor::PostToUI([sessionId]() {
+        InvokeDispatcher::GetInstance()->CloseSession(sessionId);
+    });
+}
+
+int LoopbackTransport::Call(std::string_view method, std::string_view data, ResponseCallback callback,
+                            InvokePriority priority) {
+    const int requestId = nextRequestId_.fetch_add(1, std::memory_order_relaxed);
+    channel_->AddCall(requestId, std::move(callback));
+    
+    auto* call = new PendingCall{channel_, InvokeRequest(method, data, requestId)};
+    call->request.SetPriority(priority);
+    Executor::PostToUI([call]() {
+        std::unique_ptr<PendingCall> posted(call);
+        InvokeDispatcher::GetInstance()->Dispatch(std::move(posted->channel), std::move(posted->request));
+    });
+    return requestId;
+}
+
+InvokeResponse LoopbackTransport::CallSync(std::string_view method, std::string_view data,
+                                           InvokePriority priority) {
+    auto promise = std::make_shared<std::promise<InvokeResponse>>();
+    std::future<InvokeResponse> future = promise->get_future();
+    Call(method, data, [promise](const InvokeResponse& response) {
+        promise->set_value(response);
+    }, priority);
+    return future.get();
+}
+
+int LoopbackTransport::Stream(std::string_view method, std::string_view data, StreamCallback callback,
+                              size_t chunkSize, int credits) {
+    const int streamId = nextRequestId_.fetch_add(1, std::memory_order_relaxed);
+    channel_->AddStream(streamId, std::move(callback));
+    
+    auto request = std::make_shared<InvokeRequest>(method, data, streamId);
+    std::shared_ptr<InvokeChannel> channel = channel_;
+    Executor::PostToUI([channel, request, chunkSize, credits]() {
+        InvokeDispatcher::GetInstance()->OpenStream(channel, std::move(*request), chunkSize, credits);
+    });
+    return streamId;
+}
+
+void LoopbackTransport::AckStream(int streamId, int credits) {
+    std::shared_ptr<Channel> channel = channel_;
+    Executor::PostToUI([channel, streamId, credits]() {
+        InvokeDispatcher::GetInstance()->AckStream(channel->GetSessionId(), channel->GetClientKey(), streamId, credits);
+    });
+}
+
+void LoopbackTransport::CancelStream(int streamId) {
+    std::shared_ptr<Channel> channel = channel_;
+    Executor::PostToUI([channel, streamId]() {
+        InvokeDispatcher::GetInstance()->CancelStream(channel->GetSessionId(), channel->GetClientKey(), streamId);
+    });
+}
+
+void LoopbackTransport::Cancel(int requestId) {
+    // Answers with a 499 unless the real response got there first
+    std::shared_ptr<Channel> channel = channel_;
+    Executor::PostToUI([channel, requestId]() {
+        InvokeDispatcher::GetInstance()->Cancel(channel->GetSessionId(), channel->GetClientKey(), requestId);
+        InvokeResponse response(requestId);
+        response.SetCancelled(CancelReason::Cancelled);
+        channel->SendResponse(response);
+    });
+}
+
+int LoopbackTransport::Subscribe(const std::string& topic, EventPolicy policy, EventCallback callback,
+                                 size_t cap) {
+    const int subscriptionId = nextRequestId_.fetch_add(1, std::memory_order_relaxed);
+    channel_->AddSubscription(subscriptionId, std::move(callback));
+    
+    std::shared_ptr<InvokeChannel> channel = channel_;
+    Executor::PostToUI([channel, subscriptionId, topic, policy, cap]() {
+        EventHub::GetInstance()->Subscribe(channel, subscriptionId, topic, policy, cap);
+    });
+    return subscriptionId;
+}
+
+void LoopbackTransport::Unsubscribe(int subscriptionId) {
+    channel_->RemoveSubscription(subscriptionId);
+    std::shared_ptr<InvokeChannel> channel = channel_;
+    Executor::PostToUI([channel, subscriptionId]() {
+        EventHub::GetInstance()->Unsubscribe(channel->GetSessionId(), channel->GetClientKey(), subscriptionId);
+    });
+}
+
+int LoopbackTransport::GetSessionId() const {
+    return channel_->GetSessionId();
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "dispatcher.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// In-process transport: calls go through the same dispatcher, priority lanes
+// and handlers as renderer calls, minus serialization and IPC. For
+// benchmarks and headless tests. Each transport is one session.
+class LoopbackTransport {
+public:
+    // Run on the UI thread
+    using ResponseCallback = std::function<void(const InvokeResponse& response)>;
+    using StreamCallback = std::function<void(StreamEvent event, const std::string* data, bool binary,
+                                              const std::string& error, int code)>;
+    // One call per flush: the subscription's events, oldest first
+    using EventCallback = std::function<void(const std::vector<std::string>& events, uint64_t dropped)>;
+    
+    LoopbackTransport();
+    
+    // Cancels whatever is still outstanding; pending callbacks never run
+    ~LoopbackTransport();
+    
+    // Callable from any thread; method and data are copied. Returns the
+    // request id.
+    int Call(std::string_view method, std::string_view data, ResponseCallback callback,
+             InvokePriority priority = InvokePriority::Normal);
+    
+    // Blocks until the response arrives; never call it on the UI thread
+    InvokeResponse CallSync(std::string_view method, std::string_view data,
+                            InvokePriority priority = InvokePriority::Normal);
+    
+    // Opens a stream with `credits` initial credits; grant more with AckStream
+    // as chunks are consumed. Returns the stream id.
+    int Stream(std::string_view method, std::string_view data, StreamCallback callback,
+               size_t chunkSize = 0, int credits = 16);
+    void AckStream(int streamId, int credits);
+    void CancelStream(int streamId);
+    
+    // The callback gets a 499 unless the response already arrived
+    void Cancel(int requestId);
+    
+    // Subscribes to an EventHub topic. Returns the subscription id.
+    int Subscribe(const std::string& topic, EventPolicy policy, EventCallback callback,
+                  size_t cap = 0);
+    void Unsubscribe(int subscriptionId);
+    
+    int GetSessionId() const;
+    
+private:
+    class Channel;
+    
+    std::shared_ptr<Channel> channel_;
+    std::atomic<int> nextRequestId_{1};
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Interned method name. Ids are dense, start at 1 and are never reused, so a
+// peer may cache them for the life of the process.
+using MethodId = uint32_t;
+constexpr MethodId kNoMethodId = 0;
+
+// Method name -> T, interned into MethodIds. Lookups go through an immutable
+// snapshot: an array indexed by id plus a flat open-addressing index by name
+// (linear probing, load <= 1/2). Updates copy the snapshot and publish the
+// copy, so they may come from any thread while one reader thread looks up
+// without a lock.
+//
+// Replaced snapshots are freed by Reclaim(), which must run on the reader
+// thread between lookups; nothing can still point into them then.
+template<typename T>
+class MethodTable {
+public:
+    class Snapshot {
+    public:
+        // kNoMethodId if the name was never interned
+        MethodId Find(std::string_view name) const;
+
+        // Null for ids this table never handed out
+        const T* Get(MethodId id) const {
+            return id != kNoMethodId && id <= values_.size() ? &values_[id - 1] : nullptr;
+        }
+
+        // Interned names live as long as the table; empty for unknown ids
+        const std::string& GetName(MethodId id) const;
+
+        size_t GetSize() const { return values_.size(); }
+
+    private:
+        friend class MethodTable;
+
+        struct Slot {
+            uint32_t hash;
+            MethodId id;  // kNoMethodId marks an empty slot
+        };
+
+        void Insert(uint32_t hash, MethodId id);
+        void Rehash(size_t slotCount);
+
+        std::vector<Slot> slots_;
+        std::vector<const std::string*> names_;
+        std::vector<T> values_;
+    };
+
+    MethodTable();
+    ~MethodTable();
+
+    MethodTable(const MethodTable&) = delete;
+    MethodTable& operator=(const MethodTable&) = delete;
+
+    // Reader thread only; valid until its next Reclaim()
+    const Snapshot& Read() const { return *current_.load(std::memory_order_acquire); }
+
+    // Applies update to name's value in a new snapshot and publishes it.
+    // Unknown names are interned unless intern is false, in which case
+    // nothing changes and kNoMethodId is returned. Any thread.
+    template<typename F>
+    MethodId Update(std::string_view name, F&& update, bool intern = true);
+
+    // Frees snapshots replaced since the last call. Reader thread only.
+    void Reclaim();
+
+    static uint32_t Hash(std::string_view name);
+
+private:
+    std::atomic<const Snapshot*> current_;
+    std::atomic<bool> hasRetired_{false};
+    std::mutex mutex_;
+    std::deque<std::string> names_;          // stable addresses
+    std::vector<const Snapshot*> retired_;   // mutex_
+};
+
+template<typename T>
+MethodId MethodTable<T>::Snapshot::Find(std::string_view name) const {
+    const uint32_t hash = Hash(name);
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.id == kNoMethodId) {
+            return kNoMethodId;
+        }
+        if (slot.hash == hash && *names_[slot.id - 1] == name) {
+            return slot.id;
+        }
+    }
+}
+
+template<typename T>
+const std::string& MethodTable<T>::Snapshot::GetName(MethodId id) const {
+    static const std::string empty;
+    return id != kNoMethodId && id <= names_.size() ? *names_[id - 1] : empty;
+}
+
+template<typename T>
+void MethodTable<T>::Snapshot::Insert(uint32_t hash, MethodId id) {
+    if ((values_.size() + 1) * 2 > slots_.size()) {
+        Rehash(slots_.size() * 2);
+    }
+
+    const size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i].id != kNoMethodId) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = Slot{hash, id};
+}
+
+template<typename T>
+void MethodTable<T>::Snapshot::Rehash(size_t slotCount) {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(slotCount, Slot{0, kNoMethodId});
+
+    const size_t mask = slotCount - 1;
+    for (const Slot& slot : old) {
+        if (slot.id == kNoMethodId) {
+            continue;
+        }
+        size_t i = slot.hash & mask;
+        while (slots_[i].id != kNoMethodId) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = slot;
+    }
+}
+
+template<typename T>
+MethodTable<T>::MethodTable() {
+    auto initial = new Snapshot();
+    initial->slots_.assign(16, typename Snapshot::Slot{0, kNoMethodId});
+    current_.store(initial, std::memory_order_release);
+}
+
+template<typename T>
+MethodTable<T>::~MethodTable() {
+    delete current_.load(std::memory_order_acquire);
+    for (const Snapshot* snapshot : retired_) {
+        delete snapshot;
+    }
+}
+
+template<typename T>
+template<typename F>
+MethodId MethodTable<T>::Update(std::string_view name, F&& update, bool intern) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Snapshot* current = current_.load(std::memory_order_relaxed);
+
+    MethodId id = current->Find(name);
+    if (id == kNoMethodId && !intern) {
+        return kNoMethodId;
+    }
+
+    auto next = std::make_unique<Snapshot>(*current);
+    if (id == kNoMethodId) {
+        names_.emplace_back(name);
+        next->names_.push_back(&names_.back());
+        next->values_.emplace_back();
+        id = static_cast<MethodId>(next->values_.size());
+        next->Insert(Hash(name), id);
+    }
+    update(next->values_[id - 1]);
+
+    current_.store(next.release(), std::memory_order_release);
+    retired_.push_back(current);
+    hasRetired_.store(true, std::memory_order_release);
+    return id;
+}
+
+template<typename T>
+void MethodTable<T>::Reclaim() {
+    if (!hasRetired_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::vector<const Snapshot*> retired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired.swap(retired_);
+        hasRetired_.store(false, std::memory_order_relaxed);
+    }
+    for (const Snapshot* snapshot : retired) {
+        delete snapshot;
+    }
+}
+
+template<typename T>
+uint32_t MethodTable<T>::Hash(std::string_view name) {
+    // FNV-1a; method names are short
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
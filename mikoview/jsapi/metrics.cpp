@@ -0,0 +1,292 @@
+#include "metrics.hpp"
+#include "executor.hpp"
+#include "jsonwriter.hpp"
+#include "../logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+inline int MostSignificantBit(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+} // namespace
+
+// LatencyHistogram implementation
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    if (value < kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    
+    const int msb = MostSignificantBit(value);
+    if (msb > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    
+    // Top kSubBucketBits + 1 bits pick the bucket: exponent, then mantissa
+    const int shift = msb - kSubBucketBits;
+    const size_t sub = static_cast<size_t>(value >> shift) - kSubBuckets;
+    return (static_cast<size_t>(msb - kSubBucketBits + 1) << kSubBucketBits) + sub;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    if (index < kSubBuckets) {
+        return index;
+    }
+    
+    const int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    const uint64_t sub = (index & (kSubBuckets - 1)) + kSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t valueUs) {
+    buckets_[BucketIndex(valueUs)]++;
+    count_++;
+    sum_ += valueUs;
+    max_ = (std::max)(max_, valueUs);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = (std::max)(max_, other.max_);
+}
+
+void LatencyHistogram::Clear() {
+    buckets_.fill(0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double q) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    
+    const uint64_t target = (std::max<uint64_t>)(1, static_cast<uint64_t>(std::ceil(q * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i];
+        if (seen >= target) {
+            // Never report more than was actually recorded
+            return (std::min)(BucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+void LatencyHistogram::Write(JsonWriter& writer) const {
+    writer.BeginObject();
+    writer.Key("count").UInt(count_);
+    writer.Key("mean").Double(std::round(GetMean() * 10.0) / 10.0);
+    writer.Key("p50").UInt(GetPercentile(0.50));
+    writer.Key("p90").UInt(GetPercentile(0.90));
+    writer.Key("p99").UInt(GetPercentile(0.99));
+    writer.Key("max").UInt(max_);
+    writer.EndObject();
+}
+
+// MethodMetrics implementation
+void MethodMetrics::Merge(const MethodMetrics& other) {
+    calls += other.calls;
+    errors += other.errors;
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    cacheHits += other.cacheHits;
+    coalesced += other.coalesced;
+    queue.Merge(other.queue);
+    exec.Merge(other.exec);
+}
+
+// Metrics implementation
+Metrics* Metrics::GetInstance() {
+    static Metrics instance;
+    return &instance;
+}
+
+Metrics::Metrics()
+    : startUs_(NowUs()) {
+}
+
+uint64_t Metrics::NowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Metrics::Shard& Metrics::GetShard() {
+    // Shards outlive their threads so nothing recorded is lost
+    thread_local std::shared_ptr<Shard> shard;
+    if (!shard) {
+        shard = std::make_shared<Shard>();
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        shards_.push_back(shard);
+    }
+    return *shard;
+}
+
+void Metrics::Record(const std::string& method, const CallSample& sample) {
+    Shard& shard = GetShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    MethodMetrics& metrics = shard.methods[method];
+    metrics.calls++;
+    if (!sample.success) {
+        metrics.errors++;
+    }
+    metrics.bytesIn += sample.bytesIn;
+    metrics.bytesOut += sample.bytesOut;
+    metrics.queue.Record(sample.queueUs);
+    metrics.exec.Record(sample.execUs);
+}
+
+void Metrics::RecordReused(const std::string& method, bool cached) {
+    Shard& shard = GetShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    
+    MethodMetrics& metrics = shard.methods[method];
+    if (cached) {
+        metrics.cacheHits++;
+    } else {
+        metrics.coalesced++;
+    }
+}
+
+std::unordered_map<std::string, MethodMetrics> Metrics::Snapshot() const {
+    std::vector<std::shared_ptr<Shard>> shards;
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        shards = shards_;
+    }
+    
+    std::unordered_map<std::string, MethodMetrics> merged;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& entry : shard->methods) {
+            merged[entry.first].Merge(entry.second);
+        }
+    }
+    return merged;
+}
+
+std::string Metrics::ToJSON() const {
+    auto snapshot = Snapshot();
+    
+    // Sorted so successive dumps diff cleanly
+    std::vector<const std::pair<const std::string, MethodMetrics>*> methods;
+    methods.reserve(snapshot.size());
+    for (const auto& entry : snapshot) {
+        methods.push_back(&entry);
+    }
+    std::sort(methods.begin(), methods.end(), [](const auto* a, const auto* b) {
+        return a->first < b->first;
+    });
+    
+    JsonWriter writer(256 + methods.size() * 384);
+    writer.BeginObject();
+    writer.Key("uptimeMs").UInt((NowUs() - startUs_) / 1000);
+    writer.Key("methods").BeginObject();
+    for (const auto* entry : methods) {
+        const MethodMetrics& metrics = entry->second;
+        writer.Key(entry->first).BeginObject();
+        writer.Key("calls").UInt(metrics.calls);
+        writer.Key("errors").UInt(metrics.errors);
+        writer.Key("bytesIn").UInt(metrics.bytesIn);
+        writer.Key("bytesOut").UInt(metrics.bytesOut);
+        writer.Key("cacheHits").UInt(metrics.cacheHits);
+        writer.Key("coalesced").UInt(metrics.coalesced);
+        writer.Key("queueUs");
+        metrics.queue.Write(writer);
+        writer.Key("execUs");
+        metrics.exec.Write(writer);
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+    return writer.Release();
+}
+
+void Metrics::Reset() {
+    std::lock_guard<std::mutex> lock(shardsMutex_);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> shardLock(shard->mutex);
+        shard->methods.clear();
+    }
+}
+
+void Metrics::StartPeriodicDump(const std::string& path, int intervalMs) {
+    if (path.empty() || intervalMs <= 0 || dumping_.exchange(true)) {
+        return;
+    }
+    
+    dumpPath_ = path;
+    dumpIntervalMs_ = intervalMs;
+    ScheduleDump();
+    Logger::Info("Writing invoke metrics to " + path + " every " + std::to_string(intervalMs) + " ms");
+}
+
+void Metrics::StopPeriodicDump() {
+    if (dumping_.exchange(false)) {
+        WriteDump();
+    }
+}
+
+void Metrics::ScheduleDump() {
+    Executor::PostDelayedToUI([this]() {
+        if (!dumping_.load()) {
+            return;
+        }
+        // The write itself stays off the UI thread
+        Executor::GetInstance()->Post(HandlerAffinity::IO, [this]() { WriteDump(); },
+                                      InvokePriority::Background);
+        ScheduleDump();
+    }, dumpIntervalMs_);
+}
+
+bool Metrics::WriteDump() const {
+    // Write then rename, so collectors never read a half-written file
+    std::lock_guard<std::mutex> lock(dumpMutex_);
+    const std::string temp = dumpPath_ + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            Logger::Warning("Failed to write metrics dump: " + temp);
+            return false;
+        }
+        const std::string json = ToJSON();
+        file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    }
+    
+    std::error_code error;
+    std::filesystem::rename(temp, dumpPath_, error);
+    if (error) {
+        Logger::Warning("Failed to write metrics dump: " + error.message());
+        return false;
+    }
+    return true;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+class JsonWriter;
+
+// Log-linear latency histogram in microseconds, HDR style: 16 linear
+// sub-buckets per power of two, so any recorded value is reported within
+// ~6%. Fixed size, no allocation after construction.
+class LatencyHistogram {
+public:
+    void Record(uint64_t valueUs);
+    void Merge(const LatencyHistogram& other);
+    void Clear();
+    
+    uint64_t GetCount() const { return count_; }
+    uint64_t GetMax() const { return max_; }
+    double GetMean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+    
+    // Upper bound of the bucket holding the q-th quantile (0 < q <= 1)
+    uint64_t GetPercentile(double q) const;
+    
+    // {"count":..,"mean":..,"p50":..,"p90":..,"p99":..,"max":..}
+    void Write(JsonWriter& writer) const;
+    
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kMaxExponent = 40;  // ~12 days in microseconds
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) << kSubBucketBits;
+    
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+    
+    std::array<uint64_t, kBucketCount> buckets_ = {};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+};
+
+// One finished invoke call
+struct CallSample {
+    uint64_t queueUs = 0;   // received on TID_UI -> handler started
+    uint64_t execUs = 0;    // handler running
+    uint64_t bytesIn = 0;   // request data + binary payload
+    uint64_t bytesOut = 0;  // response data or binary body
+    bool success = true;
+};
+
+struct MethodMetrics {
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t cacheHits = 0;   // answered from the result cache
+    uint64_t coalesced = 0;   // shared an identical call's execution
+    LatencyHistogram queue;
+    LatencyHistogram exec;
+    
+    void Merge(const MethodMetrics& other);
+};
+
+// Always-on per-method invoke metrics. Each thread records into its own
+// shard, so the hot path takes only an uncontended lock; shards are merged
+// when a snapshot is requested.
+class Metrics {
+public:
+    static Metrics* GetInstance();
+    
+    void Record(const std::string& method, const CallSample& sample);
+    
+    // A call of an idempotent method answered without running its handler
+    void RecordReused(const std::string& method, bool cached);
+    
+    // Merged view of every shard
+    std::unordered_map<std::string, MethodMetrics> Snapshot() const;
+    
+    // {"uptimeMs":..,"methods":{"fs.readFile":{"calls":..,"queueUs":{..},"execUs":{..}},..}}
+    std::string ToJSON() const;
+    void Reset();
+    
+    // Writes ToJSON() to path every intervalMs from the IO pool. Scheduled
+    // on TID_UI; StopPeriodicDump() writes one last snapshot.
+    void StartPeriodicDump(const std::string& path, int intervalMs);
+    void StopPeriodicDump();
+    
+    static uint64_t NowUs();
+    
+private:
+    Metrics();
+    
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, MethodMetrics> methods;
+    };
+    
+    Shard& GetShard();
+    void ScheduleDump();
+    bool WriteDump() const;
+    
+    const uint64_t startUs_;
+    mutable std::mutex shardsMutex_;
+    std::vector<std::shared_ptr<Shard>> shards_;
+    
+    mutable std::mutex dumpMutex_;
+    std::string dumpPath_;
+    int dumpIntervalMs_ = 0;
+    std::atomic<bool> dumping_{false};
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include "recorder.hpp"
+#include "../logger.hpp"
+#include <algorithm>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+constexpr char kLogMagic[] = "MIKOINV1";
+constexpr size_t kLogMagicSize = sizeof(kLogMagic) - 1;
+constexpr size_t kMaxLogFieldBytes = size_t(1) << 30;
+
+void AppendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void AppendSigned(std::string& out, int64_t value) {
+    AppendVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void AppendBytes(std::string& out, const void* data, size_t size) {
+    AppendVarint(out, size);
+    out.append(static_cast<const char*>(data), size);
+}
+
+} // namespace
+
+InvokeRecorder::~InvokeRecorder() {
+    Stop();
+}
+
+bool InvokeRecorder::Start(const std::string& path, uint64_t maxBytes, std::string* error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Close();
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        if (error) {
+            *error = "Cannot open " + path;
+        }
+        return false;
+    }
+
+    buffer_.assign(kLogMagic, kLogMagicSize);
+    strings_.clear();
+    lastUs_ = 0;
+    written_ = 0;
+    maxBytes_ = maxBytes;
+    recording_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void InvokeRecorder::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Close();
+}
+
+void InvokeRecorder::RecordCall(int sessionId, const std::string& clientKey, const InvokeRequest& request) {
+    if (!IsRecording()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return;
+    }
+    BeginRecord(RecordKind::Call, request.GetReceivedAt(), sessionId, clientKey);
+    AppendCall(request);
+    EndRecord();
+}
+
+void InvokeRecorder::RecordBatch(int sessionId, const std::string& clientKey,
+                                 const std::vector<InvokeRequest>& requests) {
+    if (!IsRecording() || requests.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return;
+    }
+    BeginRecord(RecordKind::Batch, requests.front().GetReceivedAt(), sessionId, clientKey);
+    AppendVarint(buffer_, requests.size());
+    for (const InvokeRequest& request : requests) {
+        AppendCall(request);
+    }
+    EndRecord();
+}
+
+void InvokeRecorder::RecordStream(int sessionId, const std::string& clientKey, const InvokeRequest& request,
+                                  size_t chunkSize, int credits) {
+    if (!IsRecording()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return;
+    }
+    BeginRecord(RecordKind::Stream, request.GetReceivedAt(), sessionId, clientKey);
+    AppendVarint(buffer_, chunkSize);
+    AppendSigned(buffer_, credits);
+    AppendCall(request);
+    EndRecord();
+}
+
+void InvokeRecorder::BeginRecord(RecordKind kind, uint64_t receivedAt, int sessionId,
+                                 const std::string& clientKey) {
+    // The first record starts the clock. Requests can be dispatched out of
+    // the order they were received in; those keep the previous timestamp.
+    if (lastUs_ == 0) {
+        lastUs_ = receivedAt;
+    }
+    const uint64_t now = std::max(receivedAt, lastUs_);
+
+    buffer_ += static_cast<char>(kind);
+    AppendVarint(buffer_, now - lastUs_);
+    AppendSigned(buffer_, sessionId);
+    AppendString(clientKey);
+    lastUs_ = now;
+}
+
+void InvokeRecorder::AppendCall(const InvokeRequest& request) {
+    // Requests sent by id record the id when it did not resolve
+    if (request.GetMethod().empty() && request.GetMethodId() != kNoMethodId) {
+        std::string name = "#";
+        name += std::to_string(request.GetMethodId());
+        AppendString(name);
+    } else {
+        AppendString(request.GetMethod());
+    }
+    AppendSigned(buffer_, request.GetRequestId());
+    buffer_ += static_cast<char>(request.GetPriority());
+
+    const std::string_view data = request.GetData();
+    AppendBytes(buffer_, data.data(), data.size());
+    if (request.HasBinary()) {
+        AppendVarint(buffer_, request.GetBinary().size + 1);
+        buffer_.append(reinterpret_cast<const char*>(request.GetBinary().data), request.GetBinary().size);
+    } else {
+        AppendVarint(buffer_, 0);
+    }
+}
+
+void InvokeRecorder::AppendString(const std::string& value) {
+    auto it = strings_.find(value);
+    if (it != strings_.end()) {
+        AppendVarint(buffer_, it->second);
+        return;
+    }
+
+    const uint64_t index = strings_.size();
+    strings_.emplace(value, index);
+    AppendVarint(buffer_, index);
+    AppendBytes(buffer_, value.data(), value.size());
+}
+
+void InvokeRecorder::EndRecord() {
+    if (maxBytes_ && written_ + buffer_.size() >= maxBytes_) {
+        Logger::Warning("Invoke recording reached its size limit and stopped");
+        Close();
+        return;
+    }
+    // Writes land in the page cache; the UI thread pays for a copy every
+    // few hundred kilobytes, not for the disk
+    if (buffer_.size() >= kRecordFlushBytes) {
+        FlushBuffer();
+    }
+}
+
+void InvokeRecorder::FlushBuffer() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    written_ += buffer_.size();
+    buffer_.clear();
+    if (!file_) {
+        Logger::Warning("Invoke recording failed to write and stopped");
+        Close();
+    }
+}
+
+void InvokeRecorder::Close() {
+    recording_.store(false, std::memory_order_relaxed);
+    if (!file_.is_open()) {
+        return;
+    }
+    if (!buffer_.empty()) {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+    file_.close();
+}
+
+bool InvokeLogReader::Open(const std::string& path, std::string* error) {
+    file_.open(path, std::ios::binary);
+    std::string magic;
+    if (!file_ || !ReadBytes(kLogMagicSize, magic) || magic != kLogMagic) {
+        if (error) {
+            *error = path + " is not an invoke log";
+        }
+        return false;
+    }
+    return true;
+}
+
+bool InvokeLogReader::Next(RecordedRequest& request) {
+    const int kind = file_.get();
+    if (kind == std::char_traits<char>::eof()) {
+        return false;
+    }
+    if (kind < static_cast<int>(RecordKind::Call) || kind > static_cast<int>(RecordKind::Stream)) {
+        return Fail("Unknown record kind");
+    }
+
+    uint64_t deltaUs = 0;
+    int64_t sessionId = 0;
+    if (!ReadVarint(deltaUs) || !ReadSigned(sessionId) || !ReadString(request.clientKey)) {
+        return Fail("Truncated record");
+    }
+    timeUs_ += deltaUs;
+    request.kind = static_cast<RecordKind>(kind);
+    request.timeUs = timeUs_;
+    request.sessionId = static_cast<int>(sessionId);
+    request.chunkSize = 0;
+    request.credits = 0;
+
+    uint64_t count = 1;
+    if (request.kind == RecordKind::Batch && (!ReadVarint(count) || count > kMaxLogFieldBytes / 8)) {
+        return Fail("Truncated record");
+    }
+    if (request.kind == RecordKind::Stream) {
+        uint64_t chunkSize = 0;
+        int64_t credits = 0;
+        if (!ReadVarint(chunkSize) || !ReadSigned(credits)) {
+            return Fail("Truncated record");
+        }
+        request.chunkSize = static_cast<size_t>(chunkSize);
+        request.credits = static_cast<int>(credits);
+    }
+
+    request.calls.resize(static_cast<size_t>(count));
+    for (RecordedCall& call : request.calls) {
+        if (!ReadCall(call)) {
+            return Fail("Truncated record");
+        }
+    }
+    return true;
+}
+
+bool InvokeLogReader::ReadVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int byte = file_.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InvokeLogReader::ReadSigned(int64_t& value) {
+    uint64_t encoded = 0;
+    if (!ReadVarint(encoded)) {
+        return false;
+    }
+    value = static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+    return true;
+}
+
+bool InvokeLogReader::ReadBytes(size_t size, std::string& out) {
+    // A damaged length must not turn into a huge allocation
+    if (size > kMaxLogFieldBytes) {
+        return false;
+    }
+    out.resize(size);
+    return size == 0 || file_.read(&out[0], static_cast<std::streamsize>(size));
+}
+
+bool InvokeLogReader::ReadString(std::string& value) {
+    uint64_t index = 0;
+    if (!ReadVarint(index) || index > strings_.size()) {
+        return false;
+    }
+    if (index < strings_.size()) {
+        value = strings_[index];
+        return true;
+    }
+
+    uint64_t size = 0;
+    if (!ReadVarint(size) || !ReadBytes(static_cast<size_t>(size), value)) {
+        return false;
+    }
+    strings_.push_back(value);
+    return true;
+}
+
+bool InvokeLogReader::ReadCall(RecordedCall& call) {
+    int64_t requestId = 0;
+    uint64_t size = 0;
+    if (!ReadString(call.method) || !ReadSigned(requestId)) {
+        return false;
+    }
+    const int priority = file_.get();
+    if (priority < 0 || priority >= static_cast<int>(kInvokePriorityCount)) {
+        return false;
+    }
+    call.requestId = static_cast<int>(requestId);
+    call.priority = static_cast<InvokePriority>(priority);
+
+    if (!ReadVarint(size) || !ReadBytes(static_cast<size_t>(size), call.data) || !ReadVarint(size)) {
+        return false;
+    }
+    call.hasBinary = size > 0;
+    return ReadBytes(call.hasBinary ? static_cast<size_t>(size - 1) : 0, call.binary);
+}
+
+bool InvokeLogReader::Fail(const std::string& error) {
+    error_ = error;
+    return false;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
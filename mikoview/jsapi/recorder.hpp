@@ -0,0 +1,118 @@
+#pragma once
+
+#include "request.hpp"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Invoke traffic log, written by InvokeRecorder and read back by
+// InvokeLogReader (invokehost replay).
+//
+// "MIKOINV1", then one record per dispatched request. Integers are LEB128
+// varints, signed ones zigzag encoded. Method names and client keys are
+// strings: an index into the strings seen so far, where index == count
+// introduces a new one as length + bytes. A record is
+//   kind, microseconds since the previous record, session id, client key
+// followed by one entry (Call), a count and that many entries (Batch), or
+// chunk size, credits and one entry (Stream). An entry is
+//   method, request id, priority, data length + data,
+//   binary length + 1 (0 = no binary) + binary.
+enum class RecordKind {
+    Call = 1,
+    Batch = 2,
+    Stream = 3
+};
+
+struct RecordedCall {
+    std::string method;
+    int requestId = 0;
+    InvokePriority priority = InvokePriority::Normal;
+    std::string data;
+    bool hasBinary = false;
+    std::string binary;
+};
+
+struct RecordedRequest {
+    RecordKind kind = RecordKind::Call;
+    uint64_t timeUs = 0;              // since the first record
+    int sessionId = 0;
+    std::string clientKey;            // the originating frame, for CEF
+    std::vector<RecordedCall> calls;  // one unless kind is Batch
+    size_t chunkSize = 0;             // streams only
+    int credits = 0;
+};
+
+// Appends dispatched requests to a log. Start and Stop are safe from any
+// thread; the Record calls come from the dispatcher on the UI thread and cost
+// one relaxed load while no recording runs. Records are encoded into a
+// buffer that is written out every kRecordFlushBytes and on Stop, so a
+// recording is only complete once stopped.
+class InvokeRecorder {
+public:
+    ~InvokeRecorder();
+
+    // Truncates path. Recording stops by itself once maxBytes have been
+    // written; 0 means no limit.
+    bool Start(const std::string& path, uint64_t maxBytes = 0, std::string* error = nullptr);
+    void Stop();
+    bool IsRecording() const { return recording_.load(std::memory_order_relaxed); }
+
+    void RecordCall(int sessionId, const std::string& clientKey, const InvokeRequest& request);
+    void RecordBatch(int sessionId, const std::string& clientKey, const std::vector<InvokeRequest>& requests);
+    void RecordStream(int sessionId, const std::string& clientKey, const InvokeRequest& request,
+                      size_t chunkSize, int credits);
+
+private:
+    static constexpr size_t kRecordFlushBytes = 256 * 1024;
+
+    std::atomic<bool> recording_{false};
+    std::mutex mutex_;
+    std::ofstream file_;
+    std::string buffer_;
+    std::unordered_map<std::string, uint64_t> strings_;
+    uint64_t lastUs_ = 0;
+    uint64_t written_ = 0;
+    uint64_t maxBytes_ = 0;
+
+    // Callers hold mutex_
+    void BeginRecord(RecordKind kind, uint64_t receivedAt, int sessionId, const std::string& clientKey);
+    void AppendCall(const InvokeRequest& request);
+    void AppendString(const std::string& value);
+    void EndRecord();
+    void FlushBuffer();
+    void Close();
+};
+
+class InvokeLogReader {
+public:
+    bool Open(const std::string& path, std::string* error = nullptr);
+
+    // False at the end of the log, or with GetError() set if a record is
+    // damaged or cut short
+    bool Next(RecordedRequest& request);
+
+    const std::string& GetError() const { return error_; }
+
+private:
+    std::ifstream file_;
+    std::vector<std::string> strings_;
+    uint64_t timeUs_ = 0;
+    std::string error_;
+
+    bool ReadVarint(uint64_t& value);
+    bool ReadSigned(int64_t& value);
+    bool ReadBytes(size_t size, std::string& out);
+    bool ReadString(std::string& value);
+    bool ReadCall(RecordedCall& call);
+    bool Fail(const std::string& error);
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
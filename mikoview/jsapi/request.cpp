@@ -0,0 +1,162 @@
+#include "request.hpp"
+#include "jsonwriter.hpp"
+#include "metrics.hpp"
+#include <json/json.h>
+
+namespace MikoView {
+namespace JSAPI {
+
+// InvokeRequest implementation
+InvokeRequest::InvokeRequest(std::string_view method, std::string_view data, int requestId)
+    : method_(method),
+      storage_(std::allocate_shared<Storage>(PoolAllocator<Storage>())),
+      requestId_(requestId),
+      receivedAt_(Metrics::NowUs()) {
+    data_ = storage_->arena.Copy(data);
+}
+
+void InvokeRequest::SetData(std::string_view data, std::shared_ptr<const void> owner) {
+    data_ = data;
+    dataOwner_ = std::move(owner);
+    storage_->json.reset();
+}
+
+void InvokeRequest::SetBinary(BinaryView binary, std::shared_ptr<const void> owner) {
+    binary_ = binary;
+    binaryOwner_ = std::move(owner);
+}
+
+const Json::Value& InvokeRequest::GetJSON() const {
+    if (!storage_->json) {
+        auto root = std::make_shared<Json::Value>();
+        Json::Reader reader;
+        if (!reader.parse(data_.data(), data_.data() + data_.size(), *root)) {
+            *root = Json::Value();
+        }
+        storage_->json = std::move(root);
+    }
+    return *storage_->json;
+}
+
+template<typename T>
+bool InvokeRequest::GetParam(const std::string& key, T& value) const {
+    // Scans the data in place rather than building a tree for one value
+    JsonCursor cursor(data_.data(), data_.data() + data_.size());
+    if (!cursor.BeginObject()) {
+        return false;
+    }
+    
+    std::string name;
+    while (cursor.NextKey(name)) {
+        if (name != key) {
+            if (!cursor.Skip()) {
+                return false;
+            }
+            continue;
+        }
+        
+        // value is left alone unless the type matches
+        T parsed;
+        if (!detail::ReadValue(cursor, parsed)) {
+            return false;
+        }
+        value = std::move(parsed);
+        return true;
+    }
+    
+    return false;
+}
+
+template bool InvokeRequest::GetParam<std::string>(const std::string&, std::string&) const;
+template bool InvokeRequest::GetParam<int>(const std::string&, int&) const;
+template bool InvokeRequest::GetParam<bool>(const std::string&, bool&) const;
+template bool InvokeRequest::GetParam<double>(const std::string&, double&) const;
+
+// InvokeResponse implementation
+InvokeResponse::InvokeResponse(int requestId)
+    : requestId_(requestId), success_(false), dataIsJSON_(false), errorCode_(0) {
+}
+
+void InvokeResponse::SetSuccess(std::string data) {
+    success_ = true;
+    dataIsJSON_ = false;
+    data_ = std::move(data);
+    error_.clear();
+    errorCode_ = 0;
+    binary_ = BinaryView();
+    binaryOwner_.reset();
+}
+
+void InvokeResponse::SetSuccessJSON(std::string json) {
+    SetSuccess(std::move(json));
+    dataIsJSON_ = true;
+}
+
+void InvokeResponse::SetError(const std::string& error, int code) {
+    success_ = false;
+    dataIsJSON_ = false;
+    error_ = error;
+    errorCode_ = code;
+    data_.clear();
+    binary_ = BinaryView();
+    binaryOwner_.reset();
+}
+
+void InvokeResponse::SetCancelled(CancelReason reason) {
+    if (reason == CancelReason::DeadlineExceeded) {
+        SetError("Request timed out", 408);
+    } else {
+        SetError("Request cancelled", 499);
+    }
+}
+
+void InvokeResponse::SetBinary(std::string bytes) {
+    auto owner = std::make_shared<std::string>(std::move(bytes));
+    BinaryView binary;
+    binary.data = reinterpret_cast<const uint8_t*>(owner->data());
+    binary.size = owner->size();
+    SetBinary(binary, owner);
+}
+
+void InvokeResponse::SetBinary(BinaryView binary, std::shared_ptr<const void> owner) {
+    success_ = true;
+    dataIsJSON_ = false;
+    data_.clear();
+    error_.clear();
+    errorCode_ = 0;
+    binary_ = binary;
+    binaryOwner_ = std::move(owner);
+}
+
+std::string InvokeResponse::ToJSON() const {
+    std::string json;
+    json.reserve(data_.size() + error_.size() + 64);
+    AppendJSON(json);
+    return json;
+}
+
+void InvokeResponse::AppendJSON(std::string& out) const {
+    JsonWriter writer(std::move(out));
+    writer.BeginObject();
+    writer.Key("requestId").Int(requestId_);
+    writer.Key("success").Bool(success_);
+    
+    if (success_) {
+        // JSON data is spliced in as-is; anything else becomes a string
+        writer.Key("data");
+        if (dataIsJSON_ || JsonCursor::IsValid(data_.data(), data_.data() + data_.size())) {
+            writer.Raw(data_);
+        } else {
+            writer.String(data_);
+        }
+    } else {
+        writer.Key("error").String(error_);
+        writer.Key("errorCode").Int(errorCode_);
+    }
+    
+    writer.EndObject();
+    out = writer.Release();
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "executor.hpp"
+#include "arena.hpp"
+#include "binding.hpp"
+#include "cancellation.hpp"
+#include "methodtable.hpp"
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace Json {
+class Value;
+}
+
+namespace MikoView {
+namespace JSAPI {
+
+class InvokeRequest;
+class InvokeResponse;
+
+// Raw bytes owned by someone else (a process message, a response buffer)
+struct BinaryView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    
+    bool IsNull() const { return data == nullptr; }
+};
+
+// What the payload attached to an invoke message contains
+enum class PayloadKind {
+    None = 0,    // data travels as a string argument
+    Json = 1,    // data is the payload, UTF-8 JSON text
+    Binary = 2   // payload is raw bytes (ArrayBuffer / TypedArray)
+};
+
+// Callback types
+using InvokeCallback = std::function<void(const std::string& result, bool success)>;
+using NativeHandler = std::function<void(const InvokeRequest& request, InvokeResponse& response)>;
+
+// Thrown by a typed or async handler to answer with an error instead of a
+// result
+class InvokeError : public std::runtime_error {
+public:
+    explicit InvokeError(const std::string& message, int code = -1)
+        : std::runtime_error(message), code_(code) {}
+    
+    int GetCode() const { return code_; }
+    
+private:
+    int code_;
+};
+
+// Registration options for a native handler
+struct HandlerOptions {
+    HandlerOptions() = default;
+    HandlerOptions(HandlerAffinity affinity, int timeoutMs = 0)
+        : affinity(affinity), timeoutMs(timeoutMs) {}
+    
+    // Where the handler runs; the response is always sent from the UI thread
+    HandlerAffinity affinity = HandlerAffinity::UI;
+    
+    // Deadline for worker-pool handlers: the caller gets a 408 once it
+    // passes and the request's token reports DeadlineExceeded. 0 uses the
+    // dispatcher-wide default, < 0 disables it. UI handlers have no deadline.
+    int timeoutMs = 0;
+    
+    // The handler only reads: identical calls (same method, same arguments
+    // up to key order) may share one execution, and with cacheTtlMs > 0 a
+    // successful answer is reused until it expires. Calls with a binary
+    // payload always run.
+    bool idempotent = false;
+    int cacheTtlMs = 0;
+    
+    // Cached answers of these methods are dropped when this one succeeds
+    std::vector<std::string> invalidates;
+    
+    HandlerOptions& Idempotent(int ttlMs = 0) {
+        idempotent = true;
+        cacheTtlMs = ttlMs;
+        return *this;
+    }
+    HandlerOptions& Invalidates(std::vector<std::string> methods) {
+        invalidates = std::move(methods);
+        return *this;
+    }
+};
+
+// Request/Response structures
+class InvokeRequest {
+public:
+    // data is copied into the request's arena
+    InvokeRequest(std::string_view method, std::string_view data, int requestId);
+    
+    const std::string& GetMethod() const { return interned_ ? *interned_ : method_; }
+    // Valid for the request's lifetime
+    std::string_view GetData() const { return data_; }
+    int GetRequestId() const { return requestId_; }
+    
+    // Replaces data without copying it. It must live in GetArena() or be
+    // kept alive by owner (e.g. a shared memory mapping).
+    void SetData(std::string_view data, std::shared_ptr<const void> owner = nullptr);
+    
+    // Scratch memory for the call's temporary parse and serialize state,
+    // freed at once with the last copy of the request, after the response
+    // has gone out. Shared by copies; use it from the thread handling the
+    // call.
+    Arena& GetArena() const { return storage_->arena; }
+    
+    // Interned id the caller sent instead of a name, or the id the name
+    // resolved to once dispatched; kNoMethodId otherwise
+    MethodId GetMethodId() const { return methodId_; }
+    // name, if given, is the interned name (see MethodTable) and replaces
+    // the one the request was constructed with
+    void SetMethodId(MethodId methodId, const std::string* name = nullptr) {
+        methodId_ = methodId;
+        if (name) {
+            interned_ = name;
+        }
+    }
+    
+    // Browser id or transport connection the call came from; set by the
+    // dispatcher
+    int GetSessionId() const { return sessionId_; }
+    void SetSessionId(int sessionId) { sessionId_ = sessionId; }
+    
+    // Metrics::NowUs() when the call was received
+    uint64_t GetReceivedAt() const { return receivedAt_; }
+    
+    // Lane the call waits in when the worker pools are saturated
+    InvokePriority GetPriority() const { return priority_; }
+    void SetPriority(InvokePriority priority) { priority_ = priority; }
+    
+    // Raw bytes sent as an ArrayBuffer/TypedArray; valid for the request's lifetime
+    bool HasBinary() const { return !binary_.IsNull(); }
+    const BinaryView& GetBinary() const { return binary_; }
+    void SetBinary(BinaryView binary, std::shared_ptr<const void> owner);
+    
+    // Decode data into an argument struct in one pass (see binding.hpp)
+    template<typename T>
+    bool Bind(T& args, std::string* error = nullptr) const {
+        return JSAPI::Bind(data_.data(), data_.data() + data_.size(), args, error);
+    }
+    
+    // Parsed data, parsed on first use and shared by copies of the request.
+    // Builds a Json::Value tree; Bind and GetParam read the data in place.
+    const Json::Value& GetJSON() const;
+    
+    // Set when the caller aborts the call, its session closes or the
+    // method's deadline passes. Shared by copies of the request.
+    const CancellationToken& GetCancellation() const { return cancellation_; }
+    bool IsCancelled() const { return cancellation_.IsCancelled(); }
+    
+    // Single top-level value of the data (std::string, int, bool or double)
+    template<typename T>
+    bool GetParam(const std::string& key, T& value) const;
+    
+private:
+    // One pooled block per request, shared by its copies. Small data and
+    // scratch fit in buffer; the arena takes more blocks as needed.
+    struct Storage {
+        Storage() : arena(buffer, sizeof(buffer)) {}
+        
+        std::shared_ptr<const Json::Value> json;
+        Arena arena;
+        char buffer[256];
+    };
+    
+    std::string method_;
+    const std::string* interned_ = nullptr;
+    MethodId methodId_ = kNoMethodId;
+    std::shared_ptr<Storage> storage_;
+    std::string_view data_;
+    std::shared_ptr<const void> dataOwner_;
+    int requestId_;
+    int sessionId_ = 0;
+    InvokePriority priority_ = InvokePriority::Normal;
+    uint64_t receivedAt_;
+    BinaryView binary_;
+    std::shared_ptr<const void> binaryOwner_;
+    CancellationToken cancellation_;
+};
+
+class InvokeResponse {
+public:
+    InvokeResponse(int requestId);
+    
+    // data is sent as JSON if it parses as JSON, otherwise as a string
+    void SetSuccess(std::string data);
+    // json is trusted to be one well-formed JSON value (e.g. JsonWriter output)
+    // and is spliced into the response as-is
+    void SetSuccessJSON(std::string json);
+    void SetError(const std::string& error, int code = -1);
+    // 499 for an aborted call, 408 for an expired deadline
+    void SetCancelled(CancelReason reason);
+    
+    // Successful response delivered to the caller as raw bytes (an ArrayBuffer
+    // in the renderer)
+    void SetBinary(std::string bytes);
+    void SetBinary(BinaryView binary, std::shared_ptr<const void> owner);
+    
+    bool IsSuccess() const { return success_; }
+    bool IsJSON() const { return dataIsJSON_; }
+    bool IsBinary() const { return !binary_.IsNull(); }
+    const BinaryView& GetBinary() const { return binary_; }
+    const std::string& GetData() const { return data_; }
+    const std::string& GetError() const { return error_; }
+    int GetErrorCode() const { return errorCode_; }
+    int GetRequestId() const { return requestId_; }
+    
+    // Shared and cached answers are re-addressed to each caller
+    void SetRequestId(int requestId) { requestId_ = requestId; }
+    
+    std::string ToJSON() const;
+    // Same, appended to out, so callers can wrap it without another copy
+    void AppendJSON(std::string& out) const;
+    
+private:
+    int requestId_;
+    bool success_;
+    bool dataIsJSON_;
+    std::string data_;
+    std::string error_;
+    int errorCode_;
+    BinaryView binary_;
+    std::shared_ptr<const void> binaryOwner_;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
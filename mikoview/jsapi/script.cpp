@@ -0,0 +1,358 @@
+#include "script.hpp"
+#include "cancellation.hpp"
+#include "executor.hpp"
+#include "invoke.hpp"
+#include "cef_v8.h"
+#include "wrapper/cef_helpers.h"
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+// Shown in DevTools stack traces
+constexpr char kScriptURL[] = "mikoview://script";
+
+// Appends script as entry `index` of the batch function: r[index] becomes
+// [true, returned value] or [false, error text]
+void AppendWrapped(std::string& source, size_t index, const std::string& script) {
+    const std::string slot = "r[" + std::to_string(index) + "]";
+    source += "try{" + slot + "=[true,(function(){\n";
+    source += script;
+    source += "\n}).call(this)]}catch(e){" + slot + "=[false,String(e)]}\n";
+}
+
+CefRefPtr<CefV8Value> EvalScripts(CefRefPtr<CefV8Context> context, const std::string& body,
+                                  std::string& error) {
+    const std::string source = "(function(){var r=[];\n" + body + "return r;}).call(this)";
+    CefRefPtr<CefV8Value> result;
+    CefRefPtr<CefV8Exception> exception;
+    if (!context->Eval(source, kScriptURL, 1, result, exception) || !result || !result->IsArray()) {
+        error = exception ? exception->GetMessage().ToString() : "Script did not run";
+        return nullptr;
+    }
+    return result;
+}
+
+} // namespace
+
+ScriptService* ScriptService::GetInstance() {
+    static ScriptService instance;
+    return &instance;
+}
+
+void ScriptService::Execute(CefRefPtr<CefBrowser> browser, const std::string& frameId, std::string script,
+                            InvokeCallback callback) {
+    // Queues and pending results belong to the UI thread
+    if (!CefCurrentlyOn(TID_UI)) {
+        auto posted = std::make_shared<QueuedScript>(QueuedScript{std::move(script), std::move(callback)});
+        Executor::PostToUI([this, browser, frameId, posted]() {
+            Enqueue(browser, frameId, std::move(posted->script), std::move(posted->callback));
+        });
+        return;
+    }
+    Enqueue(browser, frameId, std::move(script), std::move(callback));
+}
+
+void ScriptService::Execute(CefRefPtr<CefFrame> frame, std::string script, InvokeCallback callback) {
+    if (!frame) {
+        if (callback) {
+            callback("Frame not found", false);
+        }
+        return;
+    }
+    Execute(frame->GetBrowser(), frame->GetIdentifier().ToString(), std::move(script), std::move(callback));
+}
+
+void ScriptService::Enqueue(CefRefPtr<CefBrowser> browser, const std::string& frameId, std::string script,
+                            InvokeCallback callback) {
+    if (!browser) {
+        stats_.failed++;
+        if (callback) {
+            callback("Browser not found", false);
+        }
+        return;
+    }
+    stats_.scripts++;
+
+    const int browserId = browser->GetIdentifier();
+    FrameQueue* queue = nullptr;
+    for (FrameQueue& candidate : queues_) {
+        if (candidate.browser->GetIdentifier() == browserId && candidate.frameId == frameId) {
+            queue = &candidate;
+            break;
+        }
+    }
+    if (!queue) {
+        queues_.push_back(FrameQueue{browser, frameId, {}});
+        queue = &queues_.back();
+    }
+    queue->scripts.push_back(QueuedScript{std::move(script), std::move(callback)});
+
+    // Whatever else this turn queues goes out with it
+    if (!flushScheduled_) {
+        flushScheduled_ = true;
+        Executor::PostToUI([this]() { Flush(); });
+    }
+}
+
+void ScriptService::Flush() {
+    flushScheduled_ = false;
+
+    // Callbacks failed below may queue more; those go out in the next flush
+    std::vector<FrameQueue> queues;
+    queues.swap(queues_);
+    for (FrameQueue& queue : queues) {
+        Send(queue);
+    }
+}
+
+void ScriptService::Send(FrameQueue& queue) {
+    CefRefPtr<CefFrame> frame = queue.frameId.empty()
+        ? queue.browser->GetMainFrame() : queue.browser->GetFrameByIdentifier(queue.frameId);
+    if (!frame || !frame->IsValid()) {
+        for (QueuedScript& script : queue.scripts) {
+            stats_.failed++;
+            if (script.callback) {
+                script.callback("Frame not found", false);
+            }
+        }
+        return;
+    }
+
+    const int batchId = nextBatchId_++;
+    PendingBatch batch{queue.browser->GetIdentifier(), {}};
+
+    // [batchId, [script...], [wantsResult...]]
+    CefRefPtr<CefListValue> scripts = CefListValue::Create();
+    CefRefPtr<CefListValue> wantsResult = CefListValue::Create();
+    for (size_t i = 0; i < queue.scripts.size(); ++i) {
+        QueuedScript& script = queue.scripts[i];
+        scripts->SetString(i, script.script);
+        wantsResult->SetBool(i, script.callback != nullptr);
+        if (script.callback) {
+            batch.callbacks.emplace_back(static_cast<int>(i), std::move(script.callback));
+        }
+    }
+
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kScriptBatchMessage);
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    args->SetInt(0, batchId);
+    args->SetList(1, scripts);
+    args->SetList(2, wantsResult);
+    frame->SendProcessMessage(PID_RENDERER, message);
+    stats_.batches++;
+
+    // Fire-and-forget batches are not answered
+    if (batch.callbacks.empty()) {
+        return;
+    }
+    pending_.emplace(batchId, std::move(batch));
+    if (timeoutMs_ > 0) {
+        timeouts_.Schedule(static_cast<uint64_t>(batchId), CancellationToken::NowMs() + timeoutMs_);
+        ScheduleTick();
+    }
+}
+
+bool ScriptService::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                             CefRefPtr<CefFrame> /*frame*/,
+                                             CefRefPtr<CefProcessMessage> message) {
+    if (message->GetName() != kScriptResultMessage) {
+        return false;
+    }
+
+    // [batchId, [[index, success, result]...]]
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    auto it = pending_.find(args->GetInt(0));
+    if (it == pending_.end() || it->second.browserId != browser->GetIdentifier()) {
+        return true;
+    }
+
+    PendingBatch batch = std::move(it->second);
+    pending_.erase(it);
+
+    CefRefPtr<CefListValue> results = args->GetList(1);
+    const size_t count = results ? results->GetSize() : 0;
+    size_t next = 0;
+    for (size_t i = 0; i < count; ++i) {
+        CefRefPtr<CefListValue> result = results->GetList(i);
+        if (!result || result->GetSize() < 3) {
+            continue;
+        }
+
+        // Both lists are in script order
+        const int index = result->GetInt(0);
+        while (next < batch.callbacks.size() && batch.callbacks[next].first < index) {
+            stats_.failed++;
+            batch.callbacks[next++].second("Script result missing", false);
+        }
+        if (next < batch.callbacks.size() && batch.callbacks[next].first == index) {
+            const bool success = result->GetBool(1);
+            if (!success) {
+                stats_.failed++;
+            }
+            batch.callbacks[next++].second(result->GetString(2), success);
+        }
+    }
+    while (next < batch.callbacks.size()) {
+        stats_.failed++;
+        batch.callbacks[next++].second("Script result missing", false);
+    }
+    return true;
+}
+
+void ScriptService::OnBrowserClosed(CefRefPtr<CefBrowser> browser) {
+    CEF_REQUIRE_UI_THREAD();
+
+    // Collect first: callbacks may queue or complete other scripts
+    const int browserId = browser->GetIdentifier();
+    std::vector<InvokeCallback> closed;
+    for (auto it = queues_.begin(); it != queues_.end();) {
+        if (it->browser->GetIdentifier() != browserId) {
+            ++it;
+            continue;
+        }
+        for (QueuedScript& script : it->scripts) {
+            if (script.callback) {
+                closed.push_back(std::move(script.callback));
+            }
+        }
+        it = queues_.erase(it);
+    }
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->second.browserId != browserId) {
+            ++it;
+            continue;
+        }
+        for (auto& callback : it->second.callbacks) {
+            closed.push_back(std::move(callback.second));
+        }
+        it = pending_.erase(it);
+    }
+
+    for (const InvokeCallback& callback : closed) {
+        stats_.failed++;
+        callback("Browser closed", false);
+    }
+}
+
+ScriptServiceStats ScriptService::GetStats() const {
+    ScriptServiceStats stats = stats_;
+    stats.pending = pending_.size();
+    return stats;
+}
+
+void ScriptService::FailPending(std::map<int, PendingBatch>::iterator it, const std::string& error) {
+    PendingBatch batch = std::move(it->second);
+    pending_.erase(it);
+    for (auto& callback : batch.callbacks) {
+        stats_.failed++;
+        callback.second(error, false);
+    }
+}
+
+void ScriptService::ScheduleTick() {
+    // Ticks only while a batch can expire
+    if (tickScheduled_ || pending_.empty()) {
+        return;
+    }
+
+    tickScheduled_ = true;
+    Executor::PostDelayedToUI([this]() { OnTick(); }, timeouts_.GetTickMs());
+}
+
+void ScriptService::OnTick() {
+    tickScheduled_ = false;
+
+    std::vector<uint64_t> expired;
+    timeouts_.Advance(CancellationToken::NowMs(), expired);
+    for (uint64_t id : expired) {
+        // Batches that already answered are skipped here
+        auto it = pending_.find(static_cast<int>(id));
+        if (it != pending_.end()) {
+            stats_.timedOut++;
+            FailPending(it, "Script timed out");
+        }
+    }
+
+    ScheduleTick();
+}
+
+void ScriptService::RunBatch(CefRefPtr<CefFrame> frame, CefRefPtr<CefListValue> args) {
+    CefRefPtr<CefListValue> scripts = args->GetList(1);
+    CefRefPtr<CefListValue> wantsResult = args->GetList(2);
+    if (!scripts || !wantsResult) {
+        return;
+    }
+
+    const size_t count = scripts->GetSize();
+    CefRefPtr<CefListValue> results = CefListValue::Create();
+    size_t answered = 0;
+    auto answer = [&](size_t index, bool success, const std::string& result) {
+        CefRefPtr<CefListValue> entry = CefListValue::Create();
+        entry->SetInt(0, static_cast<int>(index));
+        entry->SetBool(1, success);
+        entry->SetString(2, result);
+        results->SetList(answered++, entry);
+    };
+
+    CefRefPtr<CefV8Context> context = frame->GetV8Context();
+    if (!context || !context->IsValid() || !context->Enter()) {
+        for (size_t i = 0; i < count; ++i) {
+            if (wantsResult->GetBool(i)) {
+                answer(i, false, "Frame has no script context");
+            }
+        }
+    } else {
+        std::string body;
+        for (size_t i = 0; i < count; ++i) {
+            AppendWrapped(body, i, scripts->GetString(i));
+        }
+
+        // Runtime errors are caught per script, so only a syntax error fails
+        // the batch, before any of it ran. Then each script runs on its own
+        // and only the broken one fails.
+        std::string error;
+        CefRefPtr<CefV8Value> ran = EvalScripts(context, body, error);
+        std::vector<std::string> errors;
+        if (!ran) {
+            ran = CefV8Value::CreateArray(static_cast<int>(count));
+            errors.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                std::string single;
+                AppendWrapped(single, 0, scripts->GetString(i));
+                CefRefPtr<CefV8Value> one = EvalScripts(context, single, errors[i]);
+                if (one) {
+                    ran->SetValue(static_cast<int>(i), one->GetValue(0));
+                }
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (!wantsResult->GetBool(i)) {
+                continue;
+            }
+            CefRefPtr<CefV8Value> entry = ran->GetValue(static_cast<int>(i));
+            if (!entry || !entry->IsArray()) {
+                answer(i, false, i < errors.size() && !errors[i].empty() ? errors[i] : "Script did not run");
+            } else if (entry->GetValue(0)->GetBoolValue()) {
+                answer(i, true, Utils::V8ValueToJSON(entry->GetValue(1)));
+            } else {
+                answer(i, false, entry->GetValue(1)->GetStringValue());
+            }
+        }
+        context->Exit();
+    }
+
+    if (answered == 0) {
+        return;
+    }
+
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(kScriptResultMessage);
+    message->GetArgumentList()->SetInt(0, args->GetInt(0));
+    message->GetArgumentList()->SetList(1, results);
+    frame->SendProcessMessage(PID_BROWSER, message);
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
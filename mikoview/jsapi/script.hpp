@@ -0,0 +1,110 @@
+#pragma once
+
+#include "cef_browser.h"
+#include "cef_frame.h"
+#include "cef_process_message.h"
+#include "request.hpp"
+#include "timerwheel.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Process message names for ScriptService
+constexpr char kScriptBatchMessage[] = "scriptBatch";    // browser -> renderer: [batchId, [script...], [wantsResult...]]
+constexpr char kScriptResultMessage[] = "scriptResult";  // renderer -> browser: [batchId, [[index, success, result]...]]
+
+constexpr int kDefaultScriptTimeoutMs = 5000;
+
+struct ScriptServiceStats {
+    size_t pending = 0;       // batches waiting for their results
+    uint64_t scripts = 0;
+    uint64_t batches = 0;     // scriptBatch messages sent
+    uint64_t timedOut = 0;    // batches whose results never came
+    uint64_t failed = 0;      // scripts that threw or could not run
+};
+
+// Runs host scripts in renderer frames. Scripts queued for a frame during
+// one UI message-loop turn are flushed together on the next: one process
+// message, evaluated by the renderer as a single script, so host code that
+// updates the page dozens of times per frame pays for one V8 compile.
+//
+// Each script is the body of a function. What it returns, as JSON, is
+// passed to its callback along with success = true; if it throws, the
+// callback gets the error text and success = false. Because of the function
+// wrapper, `var` declares a local; assign to window for globals. A syntax
+// error fails only the script that contains it.
+class ScriptService {
+public:
+    static ScriptService* GetInstance();
+
+    // Callable from any thread. frameId is a CefFrame identifier; an empty
+    // one means the main frame. The callback runs on TID_UI exactly once,
+    // with success = false if the frame is gone, the browser closes or no
+    // result arrives within the timeout.
+    void Execute(CefRefPtr<CefBrowser> browser, const std::string& frameId, std::string script,
+                 InvokeCallback callback = nullptr);
+    void Execute(CefRefPtr<CefFrame> frame, std::string script, InvokeCallback callback = nullptr);
+
+    // Browser process, from InvokeHandler::OnProcessMessageReceived
+    bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefProcessMessage> message);
+
+    // Fails the browser's queued and pending scripts; from OnBeforeClose
+    void OnBrowserClosed(CefRefPtr<CefBrowser> browser);
+
+    // 0 waits until the browser closes
+    void SetTimeout(int timeoutMs) { timeoutMs_ = timeoutMs; }
+
+    // UI thread only
+    ScriptServiceStats GetStats() const;
+
+    // Renderer process, from RendererInvokeRouter: runs a scriptBatch in
+    // the frame and answers with its results if any were asked for
+    static void RunBatch(CefRefPtr<CefFrame> frame, CefRefPtr<CefListValue> args);
+
+private:
+    ScriptService() = default;
+
+    struct QueuedScript {
+        std::string script;
+        InvokeCallback callback;
+    };
+
+    // Scripts for one frame, in the order they were queued
+    struct FrameQueue {
+        CefRefPtr<CefBrowser> browser;
+        std::string frameId;
+        std::vector<QueuedScript> scripts;
+    };
+
+    // A sent batch whose results are due; callbacks by script index
+    struct PendingBatch {
+        int browserId;
+        std::vector<std::pair<int, InvokeCallback>> callbacks;
+    };
+
+    std::vector<FrameQueue> queues_;
+    bool flushScheduled_ = false;
+    std::map<int, PendingBatch> pending_;
+    int nextBatchId_ = 1;
+    int timeoutMs_ = kDefaultScriptTimeoutMs;
+    TimerWheel timeouts_{50, 256};
+    bool tickScheduled_ = false;
+    ScriptServiceStats stats_;
+
+    void Enqueue(CefRefPtr<CefBrowser> browser, const std::string& frameId, std::string script,
+                 InvokeCallback callback);
+    void Flush();
+    void Send(FrameQueue& queue);
+    void FailPending(std::map<int, PendingBatch>::iterator it, const std::string& error);
+    void ScheduleTick();
+    void OnTick();
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
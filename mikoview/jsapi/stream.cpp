@@ -0,0 +1,137 @@
+#include "stream.hpp"
+#include "dispatcher.hpp"
+#include "executor.hpp"
+#include <chrono>
+
+namespace MikoView {
+namespace JSAPI {
+
+StreamWriter::StreamWriter(std::shared_ptr<InvokeChannel> channel, int streamId,
+                           size_t chunkSize, int credits)
+    : channel_(std::move(channel)),
+      streamId_(streamId),
+      chunkSize_(chunkSize),
+      credits_(credits > 0 ? credits : 1),
+      bytesWritten_(0),
+      cancelled_(false),
+      finished_(false) {
+}
+
+bool StreamWriter::WriteJSON(std::string json) {
+    if (!WaitForCredit()) {
+        return false;
+    }
+    AddBytes(json.size());
+    Send(StreamEvent::Chunk, std::make_shared<std::string>(std::move(json)), false, std::string(), 0);
+    return true;
+}
+
+bool StreamWriter::WriteBinary(std::string bytes) {
+    if (!WaitForCredit()) {
+        return false;
+    }
+    AddBytes(bytes.size());
+    Send(StreamEvent::Chunk, std::make_shared<std::string>(std::move(bytes)), true, std::string(), 0);
+    return true;
+}
+
+void StreamWriter::AddBytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytesWritten_ += bytes;
+}
+
+void StreamWriter::End() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+    }
+    Send(StreamEvent::End, nullptr, false, std::string(), 0);
+}
+
+void StreamWriter::Fail(const std::string& error, int code) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+    }
+    Send(StreamEvent::Error, nullptr, false, error, code);
+}
+
+bool StreamWriter::IsCancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+bool StreamWriter::IsFinished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return finished_;
+}
+
+void StreamWriter::AddCredits(int credits) {
+    if (credits <= 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        credits_ += credits;
+    }
+    creditAvailable_.notify_one();
+}
+
+void StreamWriter::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    cancellation_.Cancel();
+    creditAvailable_.notify_all();
+}
+
+uint64_t StreamWriter::GetBytesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytesWritten_;
+}
+
+bool StreamWriter::WaitForCredit() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool ready = creditAvailable_.wait_for(lock, std::chrono::milliseconds(kStallTimeoutMs), [this]() {
+            return cancelled_ || finished_ || credits_ > 0;
+        });
+        if (ready) {
+            if (cancelled_ || finished_) {
+                return false;
+            }
+            --credits_;
+            return true;
+        }
+    }
+
+    // The consumer stopped pulling without cancelling
+    Fail("Stream consumer stalled", 408);
+    return false;
+}
+
+void StreamWriter::Send(StreamEvent event, std::shared_ptr<std::string> data, bool binary,
+                        const std::string& error, int code) {
+    std::shared_ptr<InvokeChannel> channel = channel_;
+    const int streamId = streamId_;
+    std::function<void()> onFinished = event == StreamEvent::Chunk ? nullptr : onFinished_;
+    
+    // Chunks are posted in order and sent from the UI thread like every other response
+    Executor::PostToUI([channel, streamId, event, data, binary, error, code, onFinished]() {
+        channel->SendStreamMessage(streamId, event, data.get(), binary, error, code);
+        
+        if (onFinished) {
+            onFinished();
+        }
+    });
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
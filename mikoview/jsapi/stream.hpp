@@ -0,0 +1,87 @@
+#pragma once
+
+#include "cancellation.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace MikoView {
+namespace JSAPI {
+
+class InvokeRequest;
+class InvokeChannel;
+
+enum class StreamEvent {
+    Chunk = 0,
+    End = 1,
+    Error = 2
+};
+
+// Handed to a stream handler. Each chunk costs one credit; the consumer grants
+// credits as it pulls, so at most `credits` chunks are ever in flight. Write
+// calls block the (worker) thread while no credit is left.
+class StreamWriter {
+public:
+    StreamWriter(std::shared_ptr<InvokeChannel> channel, int streamId,
+                 size_t chunkSize, int credits);
+
+    int GetStreamId() const { return streamId_; }
+
+    // Preferred chunk size requested by the consumer (entries or bytes,
+    // depending on the method); 0 means the handler's default
+    size_t GetChunkSize(size_t fallback) const { return chunkSize_ ? chunkSize_ : fallback; }
+
+    // Send one chunk. Return false once the stream is cancelled, closed or
+    // stalled; the handler should stop producing.
+    bool WriteJSON(std::string json);
+    bool WriteBinary(std::string bytes);
+
+    // Finish the stream; later calls are ignored
+    void End();
+    void Fail(const std::string& error, int code = -1);
+
+    bool IsCancelled() const;
+    bool IsFinished() const;
+    uint64_t GetBytesWritten() const;
+
+    // Called from the UI thread when the consumer acks or cancels
+    void AddCredits(int credits);
+    void Cancel();
+
+    // Cancel() also cancels this token, so stream handlers can poll the
+    // request like any other handler
+    void SetCancellation(CancellationToken token) { cancellation_ = std::move(token); }
+    
+    // Runs on the UI thread after the final message has been sent
+    void SetOnFinished(std::function<void()> onFinished) { onFinished_ = std::move(onFinished); }
+
+    // How long a writer waits for credit before giving up
+    static constexpr int kStallTimeoutMs = 30000;
+
+private:
+    bool WaitForCredit();
+    void AddBytes(size_t bytes);
+    void Send(StreamEvent event, std::shared_ptr<std::string> data, bool binary,
+              const std::string& error, int code);
+
+    std::shared_ptr<InvokeChannel> channel_;
+    const int streamId_;
+    const size_t chunkSize_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable creditAvailable_;
+    int credits_;
+    uint64_t bytesWritten_;
+    bool cancelled_;
+    bool finished_;
+    std::function<void()> onFinished_;
+    CancellationToken cancellation_;
+};
+
+using StreamHandler = std::function<void(const InvokeRequest& request, StreamWriter& writer)>;
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
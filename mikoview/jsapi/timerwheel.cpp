@@ -0,0 +1,53 @@
+#include "timerwheel.hpp"
+#include <algorithm>
+
+namespace MikoView {
+namespace JSAPI {
+
+TimerWheel::TimerWheel(int64_t tickMs, size_t slotCount)
+    : slots_((std::max<size_t>)(slotCount, 1)),
+      tickMs_((std::max<int64_t>)(tickMs, 1)),
+      currentTick_(-1),
+      size_(0) {
+}
+
+void TimerWheel::Schedule(uint64_t id, int64_t deadlineMs) {
+    // Never land in a slot Advance() has already passed
+    int64_t tick = (std::max)(deadlineMs / tickMs_, currentTick_ + 1);
+    slots_[static_cast<size_t>(tick) % slots_.size()].push_back(Entry{id, deadlineMs});
+    ++size_;
+}
+
+void TimerWheel::Advance(int64_t nowMs, std::vector<uint64_t>& expired) {
+    const int64_t nowTick = nowMs / tickMs_;
+    if (currentTick_ < 0) {
+        currentTick_ = nowTick - 1;
+    }
+    if (nowTick <= currentTick_) {
+        return;
+    }
+    
+    // After a long gap every slot is visited once; entries further out than
+    // one revolution simply stay where they are
+    const int64_t slotCount = static_cast<int64_t>(slots_.size());
+    const int64_t first = (std::max)(currentTick_ + 1, nowTick - slotCount + 1);
+    
+    for (int64_t tick = first; tick <= nowTick; ++tick) {
+        std::vector<Entry>& slot = slots_[static_cast<size_t>(tick) % slots_.size()];
+        auto keep = slot.begin();
+        for (auto it = slot.begin(); it != slot.end(); ++it) {
+            if (it->deadlineMs <= nowMs) {
+                expired.push_back(it->id);
+                --size_;
+            } else {
+                *keep++ = *it;
+            }
+        }
+        slot.erase(keep, slot.end());
+    }
+    
+    currentTick_ = nowTick;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
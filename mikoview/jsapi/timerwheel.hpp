@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Hashed timer wheel for many short deadlines. Scheduling is O(1) and one
+// periodic Advance() replaces a timer per deadline. Cancellation is lazy:
+// the owner ignores expired ids it no longer tracks.
+class TimerWheel {
+public:
+    TimerWheel(int64_t tickMs, size_t slotCount);
+    
+    // deadlineMs is absolute, in the same clock as Advance()
+    void Schedule(uint64_t id, int64_t deadlineMs);
+    
+    // Appends ids whose deadline is <= nowMs
+    void Advance(int64_t nowMs, std::vector<uint64_t>& expired);
+    
+    int64_t GetTickMs() const { return tickMs_; }
+    size_t GetSize() const { return size_; }
+    
+private:
+    struct Entry {
+        uint64_t id;
+        int64_t deadlineMs;
+    };
+    
+    std::vector<std::vector<Entry>> slots_;
+    int64_t tickMs_;
+    int64_t currentTick_;  // last tick processed by Advance()
+    size_t size_;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
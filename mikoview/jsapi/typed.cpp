@@ -0,0 +1,93 @@
+#include "typed.hpp"
+#include <cctype>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+bool IsIdentifier(const std::string& name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    for (char c : name) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '$') {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TypedSchema* TypedSchema::GetInstance() {
+    static TypedSchema instance;
+    return &instance;
+}
+
+bool TypedSchema::HasInterface(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return interfaces_.count(name) != 0;
+}
+
+void TypedSchema::AddInterface(const std::string& name, std::string body) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interfaces_.emplace(name, std::move(body));
+}
+
+void TypedSchema::AddMethod(const std::string& method, std::string argsType, std::string resultType) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    methods_[method] = MethodSignature{std::move(argsType), std::move(resultType)};
+}
+
+std::string TypedSchema::ToTypeScript() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string out =
+        "// Generated by `invokehost typescript` from the handlers registered with\n"
+        "// RegisterTyped(). Do not edit; build the mikoview_typescript target instead.\n"
+        "\n"
+        "import { invokeNative } from '../core/invoke';\n"
+        "import type { InvokeOptions } from '../core/invoke';\n";
+
+    for (const auto& entry : interfaces_) {
+        out += "\nexport interface " + entry.first + " {\n" + entry.second + "}\n";
+    }
+
+    // "fs.getFileInfo" becomes fs.getFileInfo(); methods without a namespace
+    // go into `native`
+    struct Stub {
+        std::string member;
+        const std::string* method;
+        const MethodSignature* signature;
+    };
+    std::map<std::string, std::vector<Stub>> groups;
+    for (const auto& entry : methods_) {
+        const size_t dot = entry.first.find('.');
+        if (dot == std::string::npos) {
+            groups["native"].push_back(Stub{entry.first, &entry.first, &entry.second});
+        } else {
+            groups[entry.first.substr(0, dot)].push_back(Stub{entry.first.substr(dot + 1), &entry.first, &entry.second});
+        }
+    }
+
+    for (const auto& group : groups) {
+        out += "\nexport const " + group.first + " = {\n";
+        for (const Stub& stub : group.second) {
+            const MethodSignature& signature = *stub.signature;
+            out += "  " + (IsIdentifier(stub.member) ? stub.member : "'" + stub.member + "'") + ": (";
+            if (!signature.argsType.empty()) {
+                out += "args: " + signature.argsType + ", ";
+            }
+            out += "options?: InvokeOptions): Promise<" + signature.resultType + "> =>\n";
+            out += "    invokeNative<" + signature.resultType + ">('" + *stub.method + "', " +
+                   (signature.argsType.empty() ? "{}" : "args") + ", options),\n";
+        }
+        out += "};\n";
+    }
+
+    return out;
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "binding.hpp"
+#include "dispatcher.hpp"
+#include "jsonwriter.hpp"
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// TypeScript view of every RegisterTyped() method: an interface per bound
+// struct and a call stub per method. `invokehost typescript` writes it to
+// renderer/api/src/generated/native.ts.
+class TypedSchema {
+public:
+    static TypedSchema* GetInstance();
+
+    bool HasInterface(const std::string& name) const;
+    void AddInterface(const std::string& name, std::string body);
+
+    // argsType is empty for methods that take no arguments
+    void AddMethod(const std::string& method, std::string argsType, std::string resultType);
+
+    // Sorted by name, so the output only changes when a signature does
+    std::string ToTypeScript() const;
+
+private:
+    TypedSchema() = default;
+
+    struct MethodSignature {
+        std::string argsType;
+        std::string resultType;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::string> interfaces_;
+    std::map<std::string, MethodSignature> methods_;
+};
+
+namespace detail {
+
+template<typename T, typename = void>
+struct HasBinding : std::false_type {};
+template<typename T>
+struct HasBinding<T, std::void_t<decltype(Binding<T>::Fields())>> : std::true_type {};
+
+template<typename T, typename = void>
+struct HasBindingName : std::false_type {};
+template<typename T>
+struct HasBindingName<T, std::void_t<decltype(Binding<T>::Name)>> : std::true_type {};
+
+template<typename T>
+struct IsVector : std::false_type {};
+template<typename T>
+struct IsVector<std::vector<T>> : std::true_type {};
+
+// Result encoding, driven by the same Binding<T>::Fields() as decoding
+inline void WriteValue(JsonWriter& writer, const std::string& value) { writer.String(value); }
+inline void WriteValue(JsonWriter& writer, bool value) { writer.Bool(value); }
+inline void WriteValue(JsonWriter& writer, double value) { writer.Double(value); }
+
+template<typename T>
+std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>
+WriteValue(JsonWriter& writer, T value);
+template<typename T>
+void WriteValue(JsonWriter& writer, const std::vector<T>& values);
+template<typename T>
+std::enable_if_t<HasBinding<T>::value> WriteValue(JsonWriter& writer, const T& value);
+
+template<typename T>
+std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>
+WriteValue(JsonWriter& writer, T value) {
+    if constexpr (std::is_signed_v<T>) {
+        writer.Int(static_cast<int64_t>(value));
+    } else {
+        writer.UInt(static_cast<uint64_t>(value));
+    }
+}
+
+template<typename T>
+void WriteValue(JsonWriter& writer, const std::vector<T>& values) {
+    writer.BeginArray();
+    for (const T& value : values) {
+        WriteValue(writer, value);
+    }
+    writer.EndArray();
+}
+
+template<typename T>
+std::enable_if_t<HasBinding<T>::value> WriteValue(JsonWriter& writer, const T& value) {
+    constexpr auto fields = Binding<T>::Fields();
+    writer.BeginObject();
+    std::apply([&writer, &value](const auto&... field) {
+        ((writer.Key(field.name), WriteValue(writer, value.*(field.member))), ...);
+    }, fields);
+    writer.EndObject();
+}
+
+// TypeScript type of T; bound structs are added to the schema as interfaces
+template<typename T>
+std::string DescribeType(TypedSchema& schema) {
+    if constexpr (std::is_void_v<T>) {
+        return "null";
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return "string";
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return "boolean";
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return "number";
+    } else if constexpr (IsVector<T>::value) {
+        return DescribeType<typename T::value_type>(schema) + "[]";
+    } else {
+        static_assert(HasBinding<T>::value, "Typed handler arguments and results need a Binding<T>");
+        static_assert(HasBindingName<T>::value, "Binding<T> needs a Name to appear in TypeScript");
+
+        const std::string name(Binding<T>::Name);
+        if (!schema.HasInterface(name)) {
+            std::string body;
+            std::apply([&schema, &body](const auto&... field) {
+                using Struct = T;
+                ((body += "  " + std::string(field.name) + (field.required ? ": " : "?: ") +
+                    DescribeType<std::decay_t<decltype(std::declval<Struct&>().*(field.member))>>(schema) +
+                    ";\n"), ...);
+            }, Binding<T>::Fields());
+            schema.AddInterface(name, std::move(body));
+        }
+        return name;
+    }
+}
+
+template<typename F>
+struct TypedSignature;
+
+template<typename R>
+struct TypedSignature<R (*)()> {
+    using Result = R;
+    using Args = void;
+    static constexpr bool kTakesRequest = false;
+};
+
+template<typename R, typename A>
+struct TypedSignature<R (*)(A)> {
+    using Result = R;
+    using Args = std::decay_t<A>;
+    static constexpr bool kTakesRequest = false;
+};
+
+template<typename R, typename A>
+struct TypedSignature<R (*)(A, const InvokeRequest&)> {
+    using Result = R;
+    using Args = std::decay_t<A>;
+    static constexpr bool kTakesRequest = true;
+};
+
+template<auto Fn, typename... Params>
+void CallTyped(InvokeResponse& response, Params&&... params) {
+    using Result = typename TypedSignature<decltype(Fn)>::Result;
+
+    if constexpr (std::is_void_v<Result>) {
+        Fn(std::forward<Params>(params)...);
+        response.SetSuccessJSON("null");
+    } else {
+        const Result result = Fn(std::forward<Params>(params)...);
+        JsonWriter writer;
+        WriteValue(writer, result);
+        response.SetSuccessJSON(writer.Release());
+    }
+}
+
+} // namespace detail
+
+// NativeHandler for Fn: binds the request data into Fn's argument struct,
+// calls it and encodes what it returns. Everything is resolved at compile
+// time; the only indirection left is the dispatcher's call through the
+// function pointer.
+template<auto Fn>
+void InvokeTyped(const InvokeRequest& request, InvokeResponse& response) {
+    using Signature = detail::TypedSignature<decltype(Fn)>;
+    using Args = typename Signature::Args;
+
+    try {
+        if constexpr (std::is_void_v<Args>) {
+            detail::CallTyped<Fn>(response);
+        } else {
+            Args args;
+            std::string error;
+            if (!request.Bind(args, &error)) {
+                response.SetError(error, 400);
+                return;
+            }
+
+            if constexpr (Signature::kTakesRequest) {
+                detail::CallTyped<Fn>(response, args, request);
+            } else {
+                detail::CallTyped<Fn>(response, args);
+            }
+        }
+    } catch (const InvokeError& e) {
+        response.SetError(e.what(), e.GetCode());
+    }
+}
+
+// Registers a plain function as an invoke handler. Fn is one of
+//
+//   Result Fn();
+//   Result Fn(const Args& args);
+//   Result Fn(const Args& args, const InvokeRequest& request);  // cancellation, binary
+//
+// where Args and Result are bound structs (see binding.hpp, with a Name),
+// strings, numbers, bools or vectors of those; Result may be void. Throw
+// InvokeError to fail the call with a code.
+//
+//   RegisterTyped<&GetFileInfo>("fs.getFileInfo", HandlerAffinity::IO);
+template<auto Fn>
+void RegisterTyped(const std::string& method, HandlerOptions options = HandlerOptions()) {
+    using Signature = detail::TypedSignature<decltype(Fn)>;
+    using Args = typename Signature::Args;
+
+    TypedSchema& schema = *TypedSchema::GetInstance();
+    std::string argsType;
+    if constexpr (!std::is_void_v<Args>) {
+        argsType = detail::DescribeType<Args>(schema);
+    }
+    schema.AddMethod(method, std::move(argsType), detail::DescribeType<typename Signature::Result>(schema));
+
+    InvokeDispatcher::GetInstance()->RegisterHandler(method, InvokeTyped<Fn>, options);
+}
+
+} // namespace JSAPI
+} // namespace MikoView
\ No newline at end of file
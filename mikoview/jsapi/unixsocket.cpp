@@ -0,0 +1,496 @@
+#include "unixsocket.hpp"
+
+#if !defined(_WIN32)
+
+#include "executor.hpp"
+#include "jsonwriter.hpp"
+#include "../logger.hpp"
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace MikoView {
+namespace JSAPI {
+
+namespace {
+
+// Anything larger is a corrupt stream, not a big request
+constexpr uint32_t kMaxHeaderSize = 64 * 1024;
+constexpr uint32_t kMaxBodySize = 256 * 1024 * 1024;
+
+void PutU32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t GetU32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+std::string BuildFrame(const std::string& header, const char* body, size_t size) {
+    std::string frame(8, '\0');
+    PutU32(&frame[0], static_cast<uint32_t>(header.size()));
+    PutU32(&frame[4], static_cast<uint32_t>(size));
+    frame.reserve(8 + header.size() + size);
+    frame.append(header);
+    frame.append(body, size);
+    return frame;
+}
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool ReadAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = ::recv(fd, data, size, 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+bool ReadFrame(int fd, std::string& header, std::string& body) {
+    char sizes[8];
+    if (!ReadAll(fd, sizes, sizeof(sizes))) {
+        return false;
+    }
+    
+    const uint32_t headerSize = GetU32(sizes);
+    const uint32_t bodySize = GetU32(sizes + 4);
+    if (headerSize > kMaxHeaderSize || bodySize > kMaxBodySize) {
+        Logger::Warning("Invoke socket: oversized frame");
+        return false;
+    }
+    
+    header.resize(headerSize);
+    body.resize(bodySize);
+    return ReadAll(fd, &header[0], headerSize) && ReadAll(fd, &body[0], bodySize);
+}
+
+// Header for a response or stream message
+std::string ReplyHeader(const char* type, int id, bool success, bool binary,
+                        const std::string& error, int errorCode) {
+    JsonWriter writer(64 + error.size());
+    writer.BeginObject();
+    writer.Key("type").String(type);
+    writer.Key("id").Int(id);
+    writer.Key("success").Bool(success);
+    writer.Key("binary").Bool(binary);
+    if (!error.empty()) {
+        writer.Key("error").String(error);
+        writer.Key("errorCode").Int(errorCode);
+    }
+    writer.EndObject();
+    return writer.Release();
+}
+
+InvokePriority PriorityFromInt(int value) {
+    if (value < 0 || value >= static_cast<int>(kInvokePriorityCount)) {
+        return InvokePriority::Normal;
+    }
+    return static_cast<InvokePriority>(value);
+}
+
+} // namespace
+
+// One accepted peer. The reader thread decodes frames and posts them to the
+// dispatcher; replies are queued from the UI thread and written by the
+// writer thread.
+class UnixSocketServer::Connection : public InvokeChannel,
+                                     public std::enable_shared_from_this<Connection> {
+public:
+    explicit Connection(int fd)
+        : fd_(fd),
+          sessionId_(InvokeDispatcher::NewSessionId()),
+          clientKey_("socket:" + std::to_string(sessionId_)),
+          closed_(false),
+          finished_(false) {
+    }
+    
+    ~Connection() override {
+        ::close(fd_);
+    }
+    
+    int GetSessionId() const override { return sessionId_; }
+    const std::string& GetClientKey() const override { return clientKey_; }
+    
+    void Start() {
+        reader_ = std::thread(&Connection::ReadLoop, this);
+        writer_ = std::thread(&Connection::WriteLoop, this);
+    }
+    
+    // Unblocks both threads; Join() waits for them
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ::shutdown(fd_, SHUT_RDWR);
+        outboxReady_.notify_one();
+    }
+    
+    void Join() {
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+    }
+    
+    bool IsFinished() const { return finished_.load(std::memory_order_acquire); }
+    
+    void SendResponse(const InvokeResponse& response) override {
+        const bool binary = response.IsBinary();
+        const char* body = binary ? reinterpret_cast<const char*>(response.GetBinary().data) : response.GetData().data();
+        const size_t size = binary ? response.GetBinary().size : response.GetData().size();
+        Enqueue(BuildFrame(ReplyHeader("response", response.GetRequestId(), response.IsSuccess(), binary,
+                                       response.GetError(), response.GetErrorCode()), body, size));
+    }
+    
+    void SendStreamMessage(int streamId, StreamEvent event, const std::string* data,
+                           bool binary, const std::string& error, int code) override {
+        static const char* const kTypes[] = {"chunk", "end", "error"};
+        const char* body = data ? data->data() : "";
+        const size_t size = data ? data->size() : 0;
+        Enqueue(BuildFrame(ReplyHeader(kTypes[static_cast<int>(event)], streamId, event != StreamEvent::Error,
+                                       binary, error, code), body, size));
+    }
+    
+private:
+    void Enqueue(std::string frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) {
+                return;
+            }
+            outbox_.push_back(std::move(frame));
+        }
+        outboxReady_.notify_one();
+    }
+    
+    void ReadLoop() {
+        std::shared_ptr<Connection> self = shared_from_this();
+        std::string headerText;
+        std::string body;
+        while (ReadFrame(fd_, headerText, body)) {
+            SocketHeader header;
+            std::string error;
+            if (!Bind(headerText, header, &error)) {
+                Logger::Warning("Invoke socket: bad header: " + error);
+                break;
+            }
+            Post(self, header, std::move(body));
+            body = std::string();
+        }
+        
+        // Peer gone: whatever it still had running is cancelled
+        const int sessionId = sessionId_;
+        Executor::PostToUI([sessionId]() {
+            InvokeDispatcher::GetInstance()->CloseSession(sessionId);
+        });
+        Close();
+    }
+    
+    static void Post(const std::shared_ptr<Connection>& self, const SocketHeader& header, std::string body) {
+        const int id = header.id;
+        
+        if (header.type == "invoke") {
+            std::shared_ptr<InvokeRequest> request;
+            if (header.binary) {
+                auto bytes = std::make_shared<std::string>(std::move(body));
+                BinaryView view;
+                view.data = reinterpret_cast<const uint8_t*>(bytes->data());
+                view.size = bytes->size();
+                request = std::make_shared<InvokeRequest>(header.method, header.data, id);
+                request->SetBinary(view, bytes);
+            } else {
+                request = std::make_shared<InvokeRequest>(header.method, body, id);
+            }
+            request->SetPriority(PriorityFromInt(header.priority));
+            Executor::PostToUI([self, request]() {
+                InvokeDispatcher::GetInstance()->Dispatch(self, std::move(*request));
+            });
+        } else if (header.type == "stream") {
+            auto request = std::make_shared<InvokeRequest>(header.method, body, id);
+            request->SetPriority(PriorityFromInt(header.priority));
+            const size_t chunkSize = static_cast<size_t>((std::max)(header.chunkSize, 0));
+            const int credits = header.credits;
+            Executor::PostToUI([self, request, chunkSize, credits]() {
+                InvokeDispatcher::GetInstance()->OpenStream(self, std::move(*request), chunkSize, credits);
+            });
+        } else if (header.type == "cancel") {
+            Executor::PostToUI([self, id]() {
+                InvokeDispatcher::GetInstance()->Cancel(self->sessionId_, self->clientKey_, id);
+            });
+        } else if (header.type == "ack") {
+            const int credits = header.credits;
+            Executor::PostToUI([self, id, credits]() {
+                InvokeDispatcher::GetInstance()->AckStream(self->sessionId_, self->clientKey_, id, credits);
+            });
+        } else if (header.type == "streamCancel") {
+            Executor::PostToUI([self, id]() {
+                InvokeDispatcher::GetInstance()->CancelStream(self->sessionId_, self->clientKey_, id);
+            });
+        } else {
+            Logger::Warning("Invoke socket: unknown frame type: " + header.type);
+        }
+    }
+    
+    void WriteLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            outboxReady_.wait(lock, [this]() { return closed_ || !outbox_.empty(); });
+            if (closed_) {
+                break;
+            }
+            
+            std::string frame = std::move(outbox_.front());
+            outbox_.pop_front();
+            lock.unlock();
+            const bool written = WriteAll(fd_, frame.data(), frame.size());
+            lock.lock();
+            if (!written) {
+                break;
+            }
+        }
+        outbox_.clear();
+        lock.unlock();
+        
+        Close();
+        finished_.store(true, std::memory_order_release);
+    }
+    
+    const int fd_;
+    const int sessionId_;
+    const std::string clientKey_;
+    std::thread reader_;
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable outboxReady_;
+    std::deque<std::string> outbox_;
+    bool closed_;
+    std::atomic<bool> finished_;
+};
+
+UnixSocketServer::UnixSocketServer(std::string path)
+    : path_(std::move(path)), listenFd_(-1), running_(false) {
+}
+
+UnixSocketServer::~UnixSocketServer() {
+    Stop();
+}
+
+bool UnixSocketServer::Start(std::string* error) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path_.size() >= sizeof(address.sun_path)) {
+        if (error) *error = "Socket path too long: " + path_;
+        return false;
+    }
+    std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+    
+    listenFd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        if (error) *error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    
+    // A previous run that crashed leaves its socket file behind
+    ::unlink(path_.c_str());
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listenFd_, 64) < 0) {
+        if (error) *error = std::string("bind/listen: ") + std::strerror(errno);
+        ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    
+    running_ = true;
+    acceptThread_ = std::thread(&UnixSocketServer::AcceptLoop, this);
+    Logger::Info("Invoke socket listening on " + path_);
+    return true;
+}
+
+void UnixSocketServer::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    
+    // shutdown() wakes the blocked accept(); close() alone does not on Linux
+    ::shutdown(listenFd_, SHUT_RDWR);
+    if (acceptThread_.joinable()) {
+        acceptThread_.join();
+    }
+    ::close(listenFd_);
+    listenFd_ = -1;
+    ::unlink(path_.c_str());
+    
+    std::vector<std::shared_ptr<Connection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections.swap(connections_);
+    }
+    for (auto& connection : connections) {
+        connection->Close();
+    }
+    for (auto& connection : connections) {
+        connection->Join();
+    }
+}
+
+void UnixSocketServer::AcceptLoop() {
+    while (running_) {
+        int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        
+        auto connection = std::make_shared<Connection>(fd);
+        std::lock_guard<std::mutex> lock(mutex_);
+        ReapFinished();
+        connections_.push_back(connection);
+        connection->Start();
+    }
+}
+
+void UnixSocketServer::ReapFinished() {
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if ((*it)->IsFinished()) {
+            (*it)->Join();
+            it = connections_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// UnixSocketClient implementation
+UnixSocketClient::UnixSocketClient() : fd_(-1) {
+}
+
+UnixSocketClient::~UnixSocketClient() {
+    Close();
+}
+
+bool UnixSocketClient::Connect(const std::string& path, std::string* error) {
+    Close();
+    
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        if (error) *error = "Socket path too long: " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        if (error) *error = std::string("connect: ") + std::strerror(errno);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void UnixSocketClient::Close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool UnixSocketClient::SendInvoke(int id, const std::string& method, const std::string& data,
+                                  InvokePriority priority) {
+    JsonWriter header(64 + method.size());
+    header.BeginObject();
+    header.Key("type").String("invoke");
+    header.Key("id").Int(id);
+    header.Key("method").String(method);
+    header.Key("priority").Int(static_cast<int>(priority));
+    header.EndObject();
+    return Send(header.GetString(), data);
+}
+
+bool UnixSocketClient::SendCancel(int id) {
+    JsonWriter header;
+    header.BeginObject().Key("type").String("cancel").Key("id").Int(id).EndObject();
+    return Send(header.GetString(), std::string());
+}
+
+bool UnixSocketClient::SendStream(int id, const std::string& method, const std::string& data,
+                                  size_t chunkSize, int credits) {
+    JsonWriter header(96 + method.size());
+    header.BeginObject();
+    header.Key("type").String("stream");
+    header.Key("id").Int(id);
+    header.Key("method").String(method);
+    header.Key("chunkSize").UInt(chunkSize);
+    header.Key("credits").Int(credits);
+    header.EndObject();
+    return Send(header.GetString(), data);
+}
+
+bool UnixSocketClient::SendAck(int id, int credits) {
+    JsonWriter header;
+    header.BeginObject().Key("type").String("ack").Key("id").Int(id).Key("credits").Int(credits).EndObject();
+    return Send(header.GetString(), std::string());
+}
+
+bool UnixSocketClient::SendStreamCancel(int id) {
+    JsonWriter header;
+    header.BeginObject().Key("type").String("streamCancel").Key("id").Int(id).EndObject();
+    return Send(header.GetString(), std::string());
+}
+
+bool UnixSocketClient::Receive(SocketHeader& header, std::string& body) {
+    std::string headerText;
+    if (fd_ < 0 || !ReadFrame(fd_, headerText, body)) {
+        return false;
+    }
+    header = SocketHeader();
+    return Bind(headerText, header);
+}
+
+bool UnixSocketClient::Send(const std::string& header, const std::string& body) {
+    if (fd_ < 0) {
+        return false;
+    }
+    std::string frame = BuildFrame(header, body.data(), body.size());
+    return WriteAll(fd_, frame.data(), frame.size());
+}
+
+} // namespace JSAPI
+} // namespace MikoView
+
+#endif // !_WIN32
\ No newline at end of file
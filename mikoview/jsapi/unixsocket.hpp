@@ -0,0 +1,122 @@
+#pragma once
+
+#if !defined(_WIN32)
+
+#include "dispatcher.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MikoView {
+namespace JSAPI {
+
+// Header of one frame on the invoke socket. Every frame, in both
+// directions, is
+//
+//   [u32 header size][u32 body size][header: JSON object][body]
+//
+// with sizes little-endian. Requests, by "type":
+//   invoke        { id, method, priority?, binary?, data? } body: JSON data,
+//                 or raw bytes when binary (the JSON args then go in "data")
+//   cancel        { id }
+//   stream        { id, method, chunkSize?, credits? } body: JSON data
+//   ack           { id, credits }
+//   streamCancel  { id }
+// Replies:
+//   response      { id, success, binary, error?, errorCode? } body: data or bytes
+//   chunk | end | error   { id, binary, error?, errorCode? } body: the chunk
+struct SocketHeader {
+    std::string type;
+    int id = 0;
+    std::string method;
+    int priority = static_cast<int>(InvokePriority::Normal);
+    int chunkSize = 0;
+    int credits = 0;
+    bool binary = false;
+    std::string data;
+    bool success = false;
+    std::string error;
+    int errorCode = 0;
+};
+
+template<> struct Binding<SocketHeader> {
+    static constexpr auto Fields() {
+        return std::make_tuple(Required("type", &SocketHeader::type),
+                               Required("id", &SocketHeader::id),
+                               Optional("method", &SocketHeader::method),
+                               Optional("priority", &SocketHeader::priority),
+                               Optional("chunkSize", &SocketHeader::chunkSize),
+                               Optional("credits", &SocketHeader::credits),
+                               Optional("binary", &SocketHeader::binary),
+                               Optional("data", &SocketHeader::data),
+                               Optional("success", &SocketHeader::success),
+                               Optional("error", &SocketHeader::error),
+                               Optional("errorCode", &SocketHeader::errorCode));
+    }
+};
+
+// Serves InvokeDispatcher on a Unix domain socket, so a local driver can
+// load-test the production handlers without a browser. Each connection is
+// one session with its own reader and writer thread; a slow peer never
+// blocks the UI thread.
+class UnixSocketServer {
+public:
+    explicit UnixSocketServer(std::string path);
+    ~UnixSocketServer();
+    
+    // Binds (replacing a stale socket file) and starts accepting
+    bool Start(std::string* error = nullptr);
+    
+    // Closes every connection and removes the socket file
+    void Stop();
+    
+    const std::string& GetPath() const { return path_; }
+    
+private:
+    class Connection;
+    
+    void AcceptLoop();
+    void ReapFinished();  // mutex_ held
+    
+    const std::string path_;
+    int listenFd_;
+    std::atomic<bool> running_;
+    std::thread acceptThread_;
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Connection>> connections_;
+};
+
+// Blocking client for test drivers. Sending and receiving may happen on two
+// different threads; neither side is safe to share further.
+class UnixSocketClient {
+public:
+    UnixSocketClient();
+    ~UnixSocketClient();
+    
+    bool Connect(const std::string& path, std::string* error = nullptr);
+    void Close();
+    
+    bool SendInvoke(int id, const std::string& method, const std::string& data,
+                    InvokePriority priority = InvokePriority::Normal);
+    bool SendCancel(int id);
+    bool SendStream(int id, const std::string& method, const std::string& data,
+                    size_t chunkSize = 0, int credits = 16);
+    bool SendAck(int id, int credits);
+    bool SendStreamCancel(int id);
+    
+    // Blocks for the next frame; false once the connection is closed
+    bool Receive(SocketHeader& header, std::string& body);
+    
+private:
+    bool Send(const std::string& header, const std::string& body);
+    
+    int fd_;
+};
+
+} // namespace JSAPI
+} // namespace MikoView
+
+#endif // !_WIN32
\ No newline at end of file
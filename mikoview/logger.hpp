@@ -4,4 +4,8 @@
 class Logger {
 public:
     static void LogMessage(const std::string& message);
-};
\ No newline at end of file
+    
+    static void Info(const std::string& message) { LogMessage("[INFO] " + message); }
+    static void Warning(const std::string& message) { LogMessage("[WARNING] " + message); }
+    static void Error(const std::string& message) { LogMessage("[ERROR] " + message); }
+};
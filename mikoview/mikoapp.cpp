@@ -1,4 +1,6 @@
 #include "mikoapp.hpp"
+#include "mikopump.hpp"
+#include "jsapi/invoke.hpp"
 #include "cef_scheme.h"
 #include "wrapper/cef_helpers.h"
 #include <fstream>
@@ -115,6 +117,33 @@ void SimpleApp::OnContextInitialized() {
     CefRegisterSchemeHandlerFactory("app", "", new AppSchemeHandlerFactory());
 }
 
+void SimpleApp::OnScheduleMessagePumpWork(int64_t delay_ms) {
+    // Only called when CefSettings::external_message_pump is enabled
+    MessagePump::GetInstance()->ScheduleWork(delay_ms);
+}
+
+void SimpleApp::OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                 CefRefPtr<CefFrame> frame,
+                                 CefRefPtr<CefV8Context> context) {
+    CEF_REQUIRE_RENDERER_THREAD();
+    MikoView::JSAPI::RendererInvokeRouter::GetInstance()->OnContextCreated(browser, frame, context);
+}
+
+void SimpleApp::OnContextReleased(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefV8Context> context) {
+    CEF_REQUIRE_RENDERER_THREAD();
+    MikoView::JSAPI::RendererInvokeRouter::GetInstance()->OnContextReleased(browser, frame, context);
+}
+
+bool SimpleApp::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                         CefRefPtr<CefFrame> frame,
+                                         CefProcessId source_process,
+                                         CefRefPtr<CefProcessMessage> message) {
+    CEF_REQUIRE_RENDERER_THREAD();
+    return MikoView::JSAPI::RendererInvokeRouter::GetInstance()->OnProcessMessageReceived(browser, frame, message);
+}
+
 void SimpleApp::OnBeforeCommandLineProcessing(const CefString& process_type, CefRefPtr<CefCommandLine> command_line) {
     // Add command-line switches to enable file access and disable web security
     command_line->AppendSwitch("--allow-file-access-from-files");
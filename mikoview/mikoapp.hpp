@@ -1,8 +1,9 @@
 #pragma once
 #include "cef_app.h"
+#include "cef_render_process_handler.h"
 #include "cef_scheme.h"
 
-class SimpleApp : public CefApp, public CefBrowserProcessHandler {
+class SimpleApp : public CefApp, public CefBrowserProcessHandler, public CefRenderProcessHandler {
 public:
     SimpleApp();
 
@@ -10,12 +11,28 @@ public:
     virtual CefRefPtr<CefBrowserProcessHandler> GetBrowserProcessHandler() override {
         return this;
     }
+    virtual CefRefPtr<CefRenderProcessHandler> GetRenderProcessHandler() override {
+        return this;
+    }
 
     // CefBrowserProcessHandler methods
     virtual void OnBeforeCommandLineProcessing(const CefString& process_type, CefRefPtr<CefCommandLine> command_line) override;
     virtual void OnRegisterCustomSchemes(CefRawPtr<CefSchemeRegistrar> registrar) override;
     virtual CefRefPtr<CefResourceBundleHandler> GetResourceBundleHandler() override { return nullptr; }
     virtual void OnContextInitialized() override;
+    virtual void OnScheduleMessagePumpWork(int64_t delay_ms) override;
+
+    // CefRenderProcessHandler methods
+    virtual void OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefV8Context> context) override;
+    virtual void OnContextReleased(CefRefPtr<CefBrowser> browser,
+                                   CefRefPtr<CefFrame> frame,
+                                   CefRefPtr<CefV8Context> context) override;
+    virtual bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                          CefRefPtr<CefFrame> frame,
+                                          CefProcessId source_process,
+                                          CefRefPtr<CefProcessMessage> message) override;
 
 private:
     IMPLEMENT_REFCOUNTING(SimpleApp);
@@ -1,13 +1,18 @@
 #include "mikoclient.hpp"
 #include "app_config.hpp"
 #include "logger.hpp"
+#include "mikotask.hpp"
+#include "jsapi/invoke.hpp"
 #include "wrapper/cef_helpers.h"
 #include "cef_app.h"
 #include <SDL.h>
+#include <chrono>
 #include <functional>
+#include <thread>
 
 // Global variables (declared in main.cpp)
 extern SDL_Window* g_sdl_window;
+extern bool g_running;
 
 // CloseBrowserTask implementation
 CloseBrowserTask::CloseBrowserTask(CefRefPtr<SimpleClient> client, bool force_close)
@@ -34,6 +39,14 @@ CefRefPtr<CefLoadHandler> SimpleClient::GetLoadHandler() {
     return this;
 }
 
+bool SimpleClient::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                            CefRefPtr<CefFrame> frame,
+                                            CefProcessId source_process,
+                                            CefRefPtr<CefProcessMessage> message) {
+    CEF_REQUIRE_UI_THREAD();
+    return MikoView::JSAPI::InvokeHandler::GetInstance()->OnProcessMessageReceived(browser, frame, message);
+}
+
 void SimpleClient::OnTitleChange(CefRefPtr<CefBrowser> browser,
                                 const CefString& title) {
     CEF_REQUIRE_UI_THREAD();
@@ -45,14 +58,21 @@ void SimpleClient::OnTitleChange(CefRefPtr<CefBrowser> browser,
         windowTitle += " [RELEASE]";
     }
     
-    if (g_sdl_window) {
-        SDL_SetWindowTitle(g_sdl_window, windowTitle.c_str());
-    }
+    // SDL window calls belong on the SDL thread, which is not the CEF UI
+    // thread when multi_threaded_message_loop is enabled
+    UITaskQueue::GetInstance()->Post([windowTitle]() {
+        if (g_sdl_window) {
+            SDL_SetWindowTitle(g_sdl_window, windowTitle.c_str());
+        }
+    });
 }
 
 void SimpleClient::OnAfterCreated(CefRefPtr<CefBrowser> browser) {
     CEF_REQUIRE_UI_THREAD();
-    browser_list_.push_back(browser);
+    {
+        std::lock_guard<std::mutex> lock(browser_lock_);
+        browser_list_.push_back(browser);
+    }
     
     std::string mode = AppConfig::IsDebugMode() ? "DEBUG" : "RELEASE";
     std::string url = AppConfig::GetStartupUrl();
@@ -71,7 +91,7 @@ void SimpleClient::OnLoadEnd(CefRefPtr<CefBrowser> browser,
         
         // Call the ready callback to show the window
         if (ready_callback_) {
-            ready_callback_();
+            UITaskQueue::GetInstance()->Post(ready_callback_);
         }
     }
 }
@@ -84,18 +104,31 @@ bool SimpleClient::DoClose(CefRefPtr<CefBrowser> browser) {
 void SimpleClient::OnBeforeClose(CefRefPtr<CefBrowser> browser) {
     CEF_REQUIRE_UI_THREAD();
     
-    BrowserList::iterator bit = browser_list_.begin();
-    for (; bit != browser_list_.end(); ++bit) {
-        if ((*bit)->IsSame(browser)) {
-            browser_list_.erase(bit);
-            break;
+    // Pending native-to-renderer calls can no longer be answered; the
+    // browser's own calls, streams and open files are released
+    MikoView::JSAPI::InvokeHandler::GetInstance()->OnBrowserClosed(browser);
+    
+    bool empty = false;
+    {
+        std::lock_guard<std::mutex> lock(browser_lock_);
+        BrowserList::iterator bit = browser_list_.begin();
+        for (; bit != browser_list_.end(); ++bit) {
+            if ((*bit)->IsSame(browser)) {
+                browser_list_.erase(bit);
+                break;
+            }
         }
+        empty = browser_list_.empty();
     }
 
-    if (browser_list_.empty()) {
-        extern bool g_running;
-        g_running = false;
-        CefQuitMessageLoop();
+    if (empty) {
+        browsers_closed_.notify_all();
+        UITaskQueue::GetInstance()->Post([]() {
+            g_running = false;
+        });
+        if (quit_message_loop_) {
+            CefQuitMessageLoop();
+        }
     }
 }
 
@@ -115,7 +148,7 @@ void SimpleClient::OnLoadError(CefRefPtr<CefBrowser> browser,
         Logger::LogMessage("⚠️ Load error occurred, showing window anyway...");
         
         if (ready_callback_) {
-            ready_callback_();
+            UITaskQueue::GetInstance()->Post(ready_callback_);
         }
     }
 
@@ -173,30 +206,50 @@ void SimpleClient::CloseAllBrowsers(bool force_close) {
         return;
     }
 
-    if (browser_list_.empty())
-        return;
-
-    BrowserList::const_iterator it = browser_list_.begin();
-    for (; it != browser_list_.end(); ++it)
-        (*it)->GetHost()->CloseBrowser(force_close);
+    DoCloseAllBrowsers(force_close);
 }
 
 void SimpleClient::DoCloseAllBrowsers(bool force_close) {
-    if (browser_list_.empty())
-        return;
+    // Copy first: CloseBrowser may synchronously re-enter OnBeforeClose
+    BrowserList browsers;
+    {
+        std::lock_guard<std::mutex> lock(browser_lock_);
+        browsers = browser_list_;
+    }
 
-    BrowserList::const_iterator it = browser_list_.begin();
-    for (; it != browser_list_.end(); ++it)
+    BrowserList::const_iterator it = browsers.begin();
+    for (; it != browsers.end(); ++it)
         (*it)->GetHost()->CloseBrowser(force_close);
 }
 
 CefRefPtr<CefBrowser> SimpleClient::GetFirstBrowser() {
+    std::lock_guard<std::mutex> lock(browser_lock_);
     if (!browser_list_.empty()) {
         return browser_list_.front();
     }
     return nullptr;
 }
 
+bool SimpleClient::WaitForAllBrowsersClosed(int timeout_ms) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    
+    // OnBeforeClose runs on this thread, so it has to be driven from here
+    if (CefCurrentlyOn(TID_UI)) {
+        while (HasBrowsers()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            CefDoMessageLoopWork();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+    
+    std::unique_lock<std::mutex> lock(browser_lock_);
+    return browsers_closed_.wait_until(lock, deadline, [this]() { return browser_list_.empty(); });
+}
+
 bool SimpleClient::HasBrowsers() {
+    std::lock_guard<std::mutex> lock(browser_lock_);
     return !browser_list_.empty();
 }
\ No newline at end of file
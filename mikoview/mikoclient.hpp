@@ -4,7 +4,9 @@
 #include "cef_life_span_handler.h"
 #include "cef_load_handler.h"
 #include "cef_task.h"
+#include <condition_variable>
 #include <list>
+#include <mutex>
 #include <functional>  // Add this for std::function
 
 class SimpleClient;
@@ -33,6 +35,10 @@ public:
     virtual CefRefPtr<CefDisplayHandler> GetDisplayHandler() override;
     virtual CefRefPtr<CefLifeSpanHandler> GetLifeSpanHandler() override;
     virtual CefRefPtr<CefLoadHandler> GetLoadHandler() override;
+    virtual bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                          CefRefPtr<CefFrame> frame,
+                                          CefProcessId source_process,
+                                          CefRefPtr<CefProcessMessage> message) override;
 
     // CefDisplayHandler methods
     virtual void OnTitleChange(CefRefPtr<CefBrowser> browser,
@@ -62,13 +68,28 @@ public:
     CefRefPtr<CefBrowser> GetFirstBrowser();
     bool HasBrowsers();
     
+    // Blocks until OnBeforeClose has run for every browser, or timeout_ms
+    // passes; false on timeout. CefShutdown must not run before. On the CEF
+    // UI thread (single-threaded loop) CEF work is pumped meanwhile; with
+    // multi_threaded_message_loop the caller just waits.
+    bool WaitForAllBrowsersClosed(int timeout_ms);
+    
+    // Set when the app drives CEF with CefRunMessageLoop; the last browser
+    // to close then quits it. Other loops stop on their own.
+    void SetQuitMessageLoopOnClose(bool quit) { quit_message_loop_ = quit; }
+    
     // Preload status
     bool IsContentReady() const { return content_ready_; }
+    // The callback is posted to UITaskQueue and runs on the SDL thread
     void SetReadyCallback(std::function<void()> callback) { ready_callback_ = callback; }
 
 private:
     typedef std::list<CefRefPtr<CefBrowser>> BrowserList;
     BrowserList browser_list_;
+    // Guards browser_list_; the SDL thread reads it when CEF runs on its own thread
+    std::mutex browser_lock_;
+    std::condition_variable browsers_closed_;
+    bool quit_message_loop_ = false;
     bool content_ready_;
     std::function<void()> ready_callback_; // Callback when content is ready
 
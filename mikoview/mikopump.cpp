@@ -0,0 +1,245 @@
+#include "mikopump.hpp"
+#include "logger.hpp"
+#include "cef_app.h"
+#include <algorithm>
+#include <string>
+#include <limits>
+
+namespace {
+    constexpr int64_t kNoDeadline = std::numeric_limits<int64_t>::max();
+}
+
+// MessagePump implementation
+MessagePump* MessagePump::GetInstance() {
+    static MessagePump instance;
+    return &instance;
+}
+
+MessagePump::MessagePump()
+    : work_deadline_ms_(kNoDeadline),
+      wake_pending_(false),
+      wake_event_type_(static_cast<Uint32>(-1)),
+      max_idle_ms_(kDefaultMaxIdleMs),
+      last_work_ms_(NowMs()),
+      last_lateness_ms_(0),
+      in_work_(false) {
+}
+
+int64_t MessagePump::NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool MessagePump::Initialize() {
+    if (wake_event_type_ != static_cast<Uint32>(-1)) {
+        return true;
+    }
+
+    wake_event_type_ = SDL_RegisterEvents(1);
+    if (wake_event_type_ == static_cast<Uint32>(-1)) {
+        Logger::LogMessage("Failed to register message pump wakeup event: " + std::string(SDL_GetError()));
+        return false;
+    }
+    return true;
+}
+
+void MessagePump::ScheduleWork(int64_t delay_ms) {
+    const int64_t deadline = NowMs() + (std::max<int64_t>)(delay_ms, 0);
+
+    // Keep the earliest request; running CEF work early is harmless.
+    int64_t current = work_deadline_ms_.load(std::memory_order_relaxed);
+    while (deadline < current) {
+        if (work_deadline_ms_.compare_exchange_weak(current, deadline, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+            // The main loop may be sleeping towards a later deadline.
+            Wakeup();
+            return;
+        }
+    }
+}
+
+void MessagePump::Wakeup() {
+    if (wake_event_type_ == static_cast<Uint32>(-1)) {
+        return;
+    }
+
+    // One wakeup event in the SDL queue is enough.
+    if (wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = wake_event_type_;
+    if (SDL_PushEvent(&event) <= 0) {
+        wake_pending_.store(false, std::memory_order_release);
+    }
+}
+
+bool MessagePump::IsWakeEvent(const SDL_Event& event) const {
+    return event.type == wake_event_type_;
+}
+
+void MessagePump::OnWakeEvent() {
+    wake_pending_.store(false, std::memory_order_release);
+}
+
+int MessagePump::GetWaitTimeout(int max_wait_ms) const {
+    const int64_t now = NowMs();
+    const int64_t deadline = (std::min)(work_deadline_ms_.load(std::memory_order_acquire),
+                                        last_work_ms_ + max_idle_ms_);
+    const int64_t wait = (std::max<int64_t>)(deadline - now, 0);
+    return static_cast<int>((std::min<int64_t>)(wait, max_wait_ms));
+}
+
+bool MessagePump::IsWorkDue() const {
+    const int64_t now = NowMs();
+    return work_deadline_ms_.load(std::memory_order_acquire) <= now ||
+           now - last_work_ms_ >= max_idle_ms_;
+}
+
+bool MessagePump::DoWorkIfDue() {
+    if (!IsWorkDue()) {
+        return false;
+    }
+    DoWork();
+    return true;
+}
+
+void MessagePump::DoWork() {
+    // CefDoMessageLoopWork() must not be re-entered from nested callbacks.
+    if (in_work_) {
+        return;
+    }
+    in_work_ = true;
+
+    // Clear the deadline first so work scheduled during this pass is kept.
+    const int64_t now = NowMs();
+    const int64_t deadline = work_deadline_ms_.exchange(kNoDeadline, std::memory_order_acq_rel);
+    last_lateness_ms_ = deadline == kNoDeadline ? 0 : (std::max<int64_t>)(now - deadline, 0);
+    last_work_ms_ = now;
+
+    CefDoMessageLoopWork();
+
+    in_work_ = false;
+}
+
+// LoopStats implementation
+LoopStats::LoopStats()
+    : enabled_(false),
+      window_start_(Clock::now()),
+      iteration_start_(Clock::now()),
+      wakeups_(0),
+      iteration_total_us_(0),
+      iteration_max_us_(0),
+      input_events_(0),
+      input_total_ms_(0),
+      input_max_ms_(0),
+      pump_runs_(0),
+      pump_late_total_ms_(0),
+      pump_late_max_ms_(0),
+      tasks_(0),
+      task_handoff_total_us_(0),
+      task_handoff_max_us_(0),
+      task_run_max_us_(0) {
+}
+
+void LoopStats::BeginIteration() {
+    if (!enabled_) return;
+    iteration_start_ = Clock::now();
+    wakeups_++;
+}
+
+void LoopStats::EndIteration() {
+    if (!enabled_) return;
+
+    const auto now = Clock::now();
+    const uint64_t elapsed_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - iteration_start_).count());
+    iteration_total_us_ += elapsed_us;
+    iteration_max_us_ = (std::max)(iteration_max_us_, elapsed_us);
+
+    if (now - window_start_ >= std::chrono::seconds(1)) {
+        Report(now);
+    }
+}
+
+void LoopStats::OnEvent(const SDL_Event& event) {
+    if (!enabled_) return;
+
+    switch (event.type) {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        case SDL_TEXTINPUT:
+        case SDL_MOUSEMOTION:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION: {
+            const Uint32 now = SDL_GetTicks();
+            const uint64_t latency_ms = now >= event.common.timestamp ? now - event.common.timestamp : 0;
+            input_events_++;
+            input_total_ms_ += latency_ms;
+            input_max_ms_ = (std::max)(input_max_ms_, latency_ms);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LoopStats::OnPumpWork(int64_t lateness_ms) {
+    if (!enabled_) return;
+
+    const uint64_t late = static_cast<uint64_t>((std::max<int64_t>)(lateness_ms, 0));
+    pump_runs_++;
+    pump_late_total_ms_ += late;
+    pump_late_max_ms_ = (std::max)(pump_late_max_ms_, late);
+}
+
+void LoopStats::OnTaskRun(int64_t handoff_us, int64_t run_us) {
+    if (!enabled_) return;
+
+    const uint64_t handoff = static_cast<uint64_t>((std::max<int64_t>)(handoff_us, 0));
+    tasks_++;
+    task_handoff_total_us_ += handoff;
+    task_handoff_max_us_ = (std::max)(task_handoff_max_us_, handoff);
+    task_run_max_us_ = (std::max)(task_run_max_us_, static_cast<uint64_t>((std::max<int64_t>)(run_us, 0)));
+}
+
+void LoopStats::Report(Clock::time_point now) {
+    const double seconds = std::chrono::duration<double>(now - window_start_).count();
+    const double wakeups_per_sec = seconds > 0.0 ? wakeups_ / seconds : 0.0;
+
+    std::string line = "[LOOP] wakeups/s=" + std::to_string(static_cast<int>(wakeups_per_sec + 0.5)) +
+                       " iteration_avg_us=" + std::to_string(wakeups_ ? iteration_total_us_ / wakeups_ : 0) +
+                       " iteration_max_us=" + std::to_string(iteration_max_us_) +
+                       " cef_work=" + std::to_string(pump_runs_) +
+                       " cef_late_avg_ms=" + std::to_string(pump_runs_ ? pump_late_total_ms_ / pump_runs_ : 0) +
+                       " cef_late_max_ms=" + std::to_string(pump_late_max_ms_) +
+                       " tasks/s=" + std::to_string(static_cast<int>(seconds > 0.0 ? tasks_ / seconds + 0.5 : 0.0)) +
+                       " task_handoff_avg_us=" + std::to_string(tasks_ ? task_handoff_total_us_ / tasks_ : 0) +
+                       " task_handoff_max_us=" + std::to_string(task_handoff_max_us_) +
+                       " task_run_max_us=" + std::to_string(task_run_max_us_) +
+                       " input_events=" + std::to_string(input_events_) +
+                       " input_avg_ms=" + std::to_string(input_events_ ? input_total_ms_ / input_events_ : 0) +
+                       " input_max_ms=" + std::to_string(input_max_ms_);
+    Logger::LogMessage(line);
+
+    window_start_ = now;
+    wakeups_ = 0;
+    iteration_total_us_ = 0;
+    iteration_max_us_ = 0;
+    input_events_ = 0;
+    input_total_ms_ = 0;
+    input_max_ms_ = 0;
+    pump_runs_ = 0;
+    pump_late_total_ms_ = 0;
+    pump_late_max_ms_ = 0;
+    tasks_ = 0;
+    task_handoff_total_us_ = 0;
+    task_handoff_max_us_ = 0;
+    task_run_max_us_ = 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <SDL.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Drives CefDoMessageLoopWork() from the SDL event loop when CEF runs with
+// CefSettings::external_message_pump enabled. CEF reports pending work through
+// SimpleApp::OnScheduleMessagePumpWork (on any thread); the pump turns that into
+// a deadline plus an SDL user event so the main loop can block in
+// SDL_WaitEventTimeout instead of polling.
+class MessagePump {
+public:
+    static MessagePump* GetInstance();
+
+    // Registers the wakeup event type. Call after SDL_Init and before CefInitialize.
+    bool Initialize();
+
+    // Thread-safe. delay_ms <= 0 means "as soon as possible".
+    void ScheduleWork(int64_t delay_ms);
+
+    // Thread-safe. Interrupts SDL_WaitEventTimeout on the main thread.
+    void Wakeup();
+
+    bool IsWakeEvent(const SDL_Event& event) const;
+    void OnWakeEvent();
+
+    // How long the main loop may block before CEF work is due, capped at max_wait_ms.
+    int GetWaitTimeout(int max_wait_ms) const;
+    bool IsWorkDue() const;
+
+    // Runs one CefDoMessageLoopWork() if CEF asked for it. Main thread only.
+    bool DoWorkIfDue();
+
+    // How late the last CefDoMessageLoopWork() ran relative to the requested time.
+    int64_t GetLastWorkLatenessMs() const { return last_lateness_ms_; }
+
+    // Upper bound on how long CEF is left without a pump when nothing is
+    // scheduled. Chromium's own X11 connection is not visible to SDL, so on
+    // Linux this also bounds input latency for the browser window.
+    void SetMaxIdleMs(int max_idle_ms) { max_idle_ms_ = max_idle_ms; }
+    static constexpr int kDefaultMaxIdleMs = 1000 / 30;
+
+private:
+    MessagePump();
+
+    static int64_t NowMs();
+    void DoWork();
+
+    std::atomic<int64_t> work_deadline_ms_;
+    std::atomic<bool> wake_pending_;
+    Uint32 wake_event_type_;
+    int max_idle_ms_;
+    int64_t last_work_ms_;
+    int64_t last_lateness_ms_;
+    bool in_work_;
+};
+
+// Measurement mode for the main loop. Reports wakeups/sec, loop iteration
+// latency, UI task handoff and input event latency once per second through
+// the logger.
+class LoopStats {
+public:
+    LoopStats();
+
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool IsEnabled() const { return enabled_; }
+
+    // Brackets one pass of the main loop after SDL_WaitEventTimeout returned.
+    void BeginIteration();
+    void EndIteration();
+
+    // Records dispatch latency for input events (keyboard, mouse, touch).
+    void OnEvent(const SDL_Event& event);
+
+    // Records how late a scheduled CefDoMessageLoopWork() ran.
+    void OnPumpWork(int64_t lateness_ms);
+
+    // Records a UITaskQueue task: time spent queued and time spent running.
+    void OnTaskRun(int64_t handoff_us, int64_t run_us);
+
+private:
+    void Report(std::chrono::steady_clock::time_point now);
+
+    using Clock = std::chrono::steady_clock;
+
+    bool enabled_;
+    Clock::time_point window_start_;
+    Clock::time_point iteration_start_;
+
+    uint64_t wakeups_;
+    uint64_t iteration_total_us_;
+    uint64_t iteration_max_us_;
+    uint64_t input_events_;
+    uint64_t input_total_ms_;
+    uint64_t input_max_ms_;
+    uint64_t pump_runs_;
+    uint64_t pump_late_total_ms_;
+    uint64_t pump_late_max_ms_;
+    uint64_t tasks_;
+    uint64_t task_handoff_total_us_;
+    uint64_t task_handoff_max_us_;
+    uint64_t task_run_max_us_;
+};
@@ -0,0 +1,35 @@
+#include "mikotask.hpp"
+#include "mikopump.hpp"
+
+UITaskQueue* UITaskQueue::GetInstance() {
+    static UITaskQueue instance;
+    return &instance;
+}
+
+void UITaskQueue::Post(Task task) {
+    if (!task) {
+        return;
+    }
+
+    queue_.Push(Item{std::move(task), std::chrono::steady_clock::now()});
+    posted_.fetch_add(1, std::memory_order_relaxed);
+    MessagePump::GetInstance()->Wakeup();
+}
+
+size_t UITaskQueue::RunPendingTasks(LoopStats* stats) {
+    size_t count = 0;
+    Item item;
+    while (queue_.Pop(item)) {
+        const auto started = std::chrono::steady_clock::now();
+        item.task();
+        count++;
+
+        if (stats) {
+            const auto finished = std::chrono::steady_clock::now();
+            stats->OnTaskRun(
+                std::chrono::duration_cast<std::chrono::microseconds>(started - item.posted_at).count(),
+                std::chrono::duration_cast<std::chrono::microseconds>(finished - started).count());
+        }
+    }
+    return count;
+}
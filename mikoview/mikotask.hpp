@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+class LoopStats;
+
+// Lock-free multi-producer / single-consumer queue (Vyukov). Push is a single
+// atomic exchange and never blocks; Pop must only be called from one thread.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)) {}
+
+    ~MpscQueue() {
+        T value;
+        while (Pop(value)) {
+        }
+        delete tail_;
+    }
+
+    void Push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool Pop(T& value) {
+        Node* next = tail_->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        value = std::move(next->value);
+        delete tail_;
+        tail_ = next;
+        return true;
+    }
+
+    bool IsEmpty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        Node() : next(nullptr) {}
+        explicit Node(T v) : next(nullptr), value(std::move(v)) {}
+
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    std::atomic<Node*> head_;  // producers
+    Node* tail_;               // consumer
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+};
+
+// Hands work from CEF threads to the SDL (main) thread. Posting wakes the
+// SDL loop through the MessagePump user event; the loop drains the queue
+// once per iteration with RunPendingTasks().
+class UITaskQueue {
+public:
+    using Task = std::function<void()>;
+
+    static UITaskQueue* GetInstance();
+
+    // Thread-safe, lock-free.
+    void Post(Task task);
+
+    // Main thread only. Returns the number of tasks run.
+    size_t RunPendingTasks(LoopStats* stats = nullptr);
+
+    uint64_t GetPostedCount() const { return posted_.load(std::memory_order_relaxed); }
+
+private:
+    UITaskQueue() : posted_(0) {}
+
+    struct Item {
+        Task task;
+        std::chrono::steady_clock::time_point posted_at;
+    };
+
+    MpscQueue<Item> queue_;
+    std::atomic<uint64_t> posted_;
+};
@@ -0,0 +1,269 @@
+// Native event subscriptions for MikoView
+
+import { invokeNative } from './invoke';
+import type { LatencySummary } from './invoke';
+
+/**
+ * How events are handed to a listener:
+ * - 'latest': only the newest event, at most once per animation frame
+ * - 'frame': every event since the previous frame, as an array, once per frame
+ * - 'queue': every event, one call each, as soon as it arrives
+ */
+export type EventPolicy = 'latest' | 'frame' | 'queue';
+
+export interface SubscribeOptions {
+  /** Defaults to 'latest' */
+  policy?: EventPolicy;
+  /**
+   * Events held for a 'frame' or 'queue' listener before more are dropped
+   * (default 1024). Drops are never silent; see onDropped.
+   */
+  cap?: number;
+  /** Called with the number of events dropped over the cap */
+  onDropped?: (count: number) => void;
+  /** Aborting unsubscribes */
+  signal?: AbortSignal;
+}
+
+export type Unsubscribe = () => void;
+
+// Matches the native default (kDefaultEventCap)
+const DEFAULT_CAP = 1024;
+
+interface Subscriber {
+  id: number;
+  policy: EventPolicy;
+  cap: number;
+  listener: (value: any) => void;
+  onDropped?: (count: number) => void;
+  // Waiting for the next frame: the newest event for 'latest', every event
+  // for 'frame'
+  pending: any[];
+  closed: boolean;
+}
+
+class EventManager {
+  private static instance: EventManager;
+  private waiting = new Set<Subscriber>();
+  private frameScheduled = false;
+
+  static getInstance(): EventManager {
+    if (!EventManager.instance) {
+      EventManager.instance = new EventManager();
+    }
+    return EventManager.instance;
+  }
+
+  /**
+   * Listen to a native topic (InvokeHandler::Publish). The browser process
+   * coalesces and batches events before they cross to the renderer, so a
+   * topic published thousands of times a second costs one message and one
+   * call per listener per flush.
+   */
+  subscribe(topic: string, listener: (value: any) => void, options: SubscribeOptions = {}): Unsubscribe {
+    const mikoview = (window as any).mikoview;
+    if (!mikoview || !mikoview.subscribe) {
+      throw new Error('Native events not available');
+    }
+
+    const signal = options.signal;
+    if (signal && signal.aborted) {
+      return () => {};
+    }
+
+    const subscriber: Subscriber = {
+      id: 0,
+      policy: options.policy || 'latest',
+      cap: options.cap && options.cap > 0 ? options.cap : DEFAULT_CAP,
+      listener,
+      onDropped: options.onDropped,
+      pending: [],
+      closed: false
+    };
+    subscriber.id = mikoview.subscribe(topic, subscriber.policy, options.cap || 0,
+      (events: any[], dropped: number) => this.receive(subscriber, events, dropped));
+
+    const unsubscribe = () => {
+      if (subscriber.closed) {
+        return;
+      }
+      subscriber.closed = true;
+      subscriber.pending = [];
+      this.waiting.delete(subscriber);
+      mikoview.unsubscribe(subscriber.id);
+    };
+
+    if (signal) {
+      signal.addEventListener('abort', unsubscribe, { once: true });
+    }
+    return unsubscribe;
+  }
+
+  private receive(subscriber: Subscriber, events: any[], dropped: number): void {
+    if (subscriber.closed) {
+      return;
+    }
+    if (dropped > 0 && subscriber.onDropped) {
+      subscriber.onDropped(dropped);
+    }
+
+    if (subscriber.policy === 'queue') {
+      for (const event of events) {
+        if (subscriber.closed) {
+          return;
+        }
+        subscriber.listener(event);
+      }
+      return;
+    }
+
+    if (events.length === 0) {
+      return;
+    }
+    if (subscriber.policy === 'latest') {
+      subscriber.pending = [events[events.length - 1]];
+    } else {
+      // Frames stop while the page is hidden; keep the newest cap events
+      subscriber.pending.push(...events);
+      const excess = subscriber.pending.length - subscriber.cap;
+      if (excess > 0) {
+        subscriber.pending.splice(0, excess);
+        if (subscriber.onDropped) {
+          subscriber.onDropped(excess);
+        }
+      }
+    }
+
+    this.waiting.add(subscriber);
+    if (!this.frameScheduled) {
+      this.frameScheduled = true;
+      requestAnimationFrame(() => this.deliver());
+    }
+  }
+
+  private deliver(): void {
+    this.frameScheduled = false;
+    const waiting = Array.from(this.waiting);
+    this.waiting.clear();
+
+    for (const subscriber of waiting) {
+      if (subscriber.closed) {
+        continue;
+      }
+      const pending = subscriber.pending;
+      subscriber.pending = [];
+      try {
+        subscriber.listener(subscriber.policy === 'latest' ? pending[0] : pending);
+      } catch (error) {
+        // One failing listener must not starve the rest of the frame
+        console.error('Event listener failed:', error);
+      }
+    }
+  }
+}
+
+export const events = EventManager.getInstance();
+
+/**
+ * Subscribe to a native topic; returns a function that unsubscribes.
+ *
+ *   const stop = subscribe<Progress>('build.progress', p => bar.update(p));
+ *   subscribe<LogLine>('log', lines => view.append(lines), { policy: 'frame' });
+ */
+export function subscribe<T = any>(topic: string, listener: (values: T[]) => void,
+                                   options: SubscribeOptions & { policy: 'frame' }): Unsubscribe;
+export function subscribe<T = any>(topic: string, listener: (value: T) => void,
+                                   options?: SubscribeOptions): Unsubscribe;
+export function subscribe(topic: string, listener: (value: any) => void,
+                          options: SubscribeOptions = {}): Unsubscribe {
+  return events.subscribe(topic, listener, options);
+}
+
+export interface EventStressOptions {
+  policy?: EventPolicy;
+  /** Events per second published natively (default 10000) */
+  rate?: number;
+  /** Default 2000; the native side stops after 10 s */
+  durationMs?: number;
+  cap?: number;
+}
+
+export interface EventStressResult {
+  published: number;
+  /** Events that reached the listener */
+  delivered: number;
+  dropped: number;
+  /** Listener calls */
+  calls: number;
+  /** Animation frames while the publisher ran */
+  frames: number;
+  /** Milliseconds between consecutive animation frames */
+  frameMs: LatencySummary;
+}
+
+function summarize(samples: number[]): LatencySummary {
+  const sorted = samples.slice().sort((a, b) => a - b);
+  const at = (q: number) => sorted.length ? sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))] : 0;
+  return {
+    count: sorted.length,
+    mean: sorted.length ? sorted.reduce((sum, value) => sum + value, 0) / sorted.length : 0,
+    p50: at(0.5),
+    p90: at(0.9),
+    p99: at(0.99),
+    max: sorted.length ? sorted[sorted.length - 1] : 0
+  };
+}
+
+/**
+ * Publish natively at `rate` events per second (mikoview.events.stress)
+ * while one listener consumes them, and report what arrived and how smooth
+ * the renderer's frames stayed. The host must have called
+ * EventHub::RegisterStressHandler(), which only debug builds should do.
+ */
+export async function runEventStress(options: EventStressOptions = {}): Promise<EventStressResult> {
+  const policy = options.policy || 'latest';
+  const durationMs = options.durationMs || 2000;
+  const topic = 'mikoview.stress.' + Math.random().toString(36).slice(2);
+
+  let delivered = 0;
+  let dropped = 0;
+  let calls = 0;
+  const stop = subscribe(topic, (value: any) => {
+    calls++;
+    delivered += Array.isArray(value) ? value.length : 1;
+  }, { policy, cap: options.cap, onDropped: count => { dropped += count; } });
+
+  const frameMs: number[] = [];
+  let running = true;
+  let last = performance.now();
+  const tick = (now: number) => {
+    frameMs.push(now - last);
+    last = now;
+    if (running) {
+      requestAnimationFrame(tick);
+    }
+  };
+  requestAnimationFrame(tick);
+
+  try {
+    const result = await invokeNative<{ published: number }>('mikoview.events.stress', {
+      topic,
+      rate: options.rate || 10000,
+      durationMs
+    });
+
+    // Let the last flush and frame land
+    await new Promise(resolve => setTimeout(resolve, 100));
+    return {
+      published: result.published,
+      delivered,
+      dropped,
+      calls,
+      frames: frameMs.length,
+      frameMs: summarize(frameMs)
+    };
+  } finally {
+    running = false;
+    stop();
+  }
+}
\ No newline at end of file
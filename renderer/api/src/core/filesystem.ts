@@ -1,18 +1,11 @@
 // Filesystem API for MikoView
 
-import { invokeNative } from './invoke';
+import { invoke, invokeNative, invokeNativeStream } from './invoke';
+import { fs } from '../generated/native';
+import type { FileInfo } from '../generated/native';
 
-export interface FileInfo {
-  name: string;
-  path: string;
-  extension: string;
-  size: number;
-  modified: number;
-  created: number;
-  isDirectory: boolean;
-  isFile: boolean;
-  isSymlink: boolean;
-}
+// Declared by the native handler; see generated/native.ts
+export type { FileInfo };
 
 export interface DirectoryEntry {
   name: string;
@@ -22,6 +15,7 @@ export interface DirectoryEntry {
 
 export interface ReadFileOptions {
   encoding?: 'utf8' | 'binary' | 'base64';
+  signal?: AbortSignal;
 }
 
 export interface WriteFileOptions {
@@ -31,6 +25,22 @@ export interface WriteFileOptions {
 
 export interface ReadDirOptions {
   recursive?: boolean;
+  signal?: AbortSignal;
+}
+
+export interface ReadStreamOptions {
+  /** Bytes per chunk (default 64 KiB) */
+  chunkSize?: number;
+  /** 'utf8' yields decoded strings, 'binary' yields ArrayBuffers */
+  encoding?: 'utf8' | 'binary';
+  highWaterMark?: number;
+  signal?: AbortSignal;
+}
+
+export interface ReadDirStreamOptions extends ReadDirOptions {
+  /** Entries per chunk (default 256) */
+  chunkSize?: number;
+  highWaterMark?: number;
 }
 
 export interface ReadResult {
@@ -46,19 +56,117 @@ export interface WriteResult {
   bytesWritten: number;
 }
 
+/** 'r' read, 'r+' read/write, 'w' write and 'w+' read/write; 'w' and 'w+' create or truncate */
+export type OpenFlags = 'r' | 'r+' | 'w' | 'w+';
+
+export interface FileReadOptions {
+  signal?: AbortSignal;
+}
+
+// Components re-check the same paths many times per render. Changes made
+// through fs.* drop the cached answers; outside changes show after the TTL.
+const INFO_CACHE_TTL_MS = 250;
+const FS_WRITES = [
+  'fs.open',
+  'fs.write',
+  'fs.writeFile',
+  'fs.appendFile',
+  'fs.deleteFile',
+  'fs.copyFile',
+  'fs.moveFile',
+  'fs.createDir',
+  'fs.deleteDir'
+];
+invoke.setCachePolicy('fs.exists', { ttl: INFO_CACHE_TTL_MS, invalidatedBy: FS_WRITES });
+invoke.setCachePolicy('fs.getFileInfo', { ttl: INFO_CACHE_TTL_MS, invalidatedBy: FS_WRITES });
+
+// fs.write with bytes: little-endian uint32 handle, offset low and high
+// words, then the data (FileSystem::kWriteHeaderSize)
+const WRITE_HEADER_SIZE = 12;
+
+/**
+ * An open file (FileSystem.open). Reads and writes name their offset and
+ * move no cursor, so calls on one handle may overlap. Handles belong to the
+ * page that opened them and are closed when it goes away; close them as
+ * soon as they are no longer needed.
+ */
+export class FileHandle {
+  private closed = false;
+
+  /** size is the file's size when it was opened */
+  constructor(readonly fd: number, readonly size: number) {}
+
+  /**
+   * Read up to length bytes at offset; fewer at the end of the file
+   */
+  read(offset: number, length: number, options: FileReadOptions = {}): Promise<ArrayBuffer> {
+    return invokeNative<ArrayBuffer>('fs.read', { fd: this.fd, offset, length }, { signal: options.signal });
+  }
+
+  /**
+   * Write data at offset; strings are written as UTF-8. Resolves with the
+   * bytes written.
+   */
+  async write(offset: number, data: string | ArrayBuffer | ArrayBufferView): Promise<number> {
+    let result: WriteResult;
+    if (typeof data === 'string') {
+      result = await invokeNative('fs.write', { fd: this.fd, offset, data });
+    } else {
+      // Raw bytes cannot travel next to JSON arguments; they go in a header
+      const bytes = data instanceof ArrayBuffer
+        ? new Uint8Array(data)
+        : new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+      const payload = new Uint8Array(WRITE_HEADER_SIZE + bytes.byteLength);
+      const header = new DataView(payload.buffer);
+      header.setUint32(0, this.fd, true);
+      header.setUint32(4, offset % 0x100000000, true);
+      header.setUint32(8, Math.floor(offset / 0x100000000), true);
+      payload.set(bytes, WRITE_HEADER_SIZE);
+      result = await invokeNative('fs.write', payload);
+    }
+    return result.bytesWritten;
+  }
+
+  /**
+   * Close the handle; closing it again does nothing
+   */
+  async close(): Promise<void> {
+    if (this.closed) {
+      return;
+    }
+    this.closed = true;
+    await fs.close({ fd: this.fd });
+  }
+}
+
 /**
  * Filesystem operations
  */
 export class FileSystem {
+  /**
+   * Open a file for ranged reads and writes instead of whole-file ones
+   */
+  static async open(path: string, flags: OpenFlags = 'r'): Promise<FileHandle> {
+    const result = await fs.open({ path, flags });
+    return new FileHandle(result.fd, result.size);
+  }
+
+
   /**
    * Read a file
    */
-  static async readFile(path: string, options: ReadFileOptions = {}): Promise<string> {
-    const result: ReadResult = await invokeNative('fs.readFile', {
+  static readFile(path: string, options: ReadFileOptions & { encoding: 'binary' }): Promise<ArrayBuffer>;
+  static readFile(path: string, options?: ReadFileOptions): Promise<string>;
+  static async readFile(path: string, options: ReadFileOptions = {}): Promise<string | ArrayBuffer> {
+    // 'binary' comes back as the file's raw bytes, not wrapped in JSON
+    const result: ReadResult | ArrayBuffer = await invokeNative('fs.readFile', {
       path,
       encoding: options.encoding || 'utf8'
-    });
-    
+    }, { signal: options.signal });
+
+    if (result instanceof ArrayBuffer) {
+      return result;
+    }
     if (!result.success) {
       throw new Error(result.error || 'Failed to read file');
     }
@@ -142,11 +250,51 @@ export class FileSystem {
     const entries: DirectoryEntry[] = await invokeNative('fs.readDir', {
       path,
       recursive: options.recursive || false
-    });
+    }, { signal: options.signal });
     
     return entries;
   }
 
+  /**
+   * Iterate directory entries as the native side lists them, without waiting
+   * for the whole (possibly recursive) listing
+   */
+  static async *readDirStream(path: string, options: ReadDirStreamOptions = {}): AsyncGenerator<DirectoryEntry> {
+    const chunks = invokeNativeStream<DirectoryEntry[]>('fs.readDir', {
+      path,
+      recursive: options.recursive || false
+    }, options);
+
+    for await (const entries of chunks) {
+      yield* entries;
+    }
+  }
+
+  /**
+   * Read a file in chunks; memory use is bounded by chunkSize * highWaterMark
+   */
+  static async *readFileStream(path: string, options: ReadStreamOptions = {}): AsyncGenerator<string | ArrayBuffer> {
+    const chunks = invokeNativeStream<ArrayBuffer>('fs.readFile', { path }, options);
+
+    if (options.encoding === 'binary') {
+      yield* chunks;
+      return;
+    }
+
+    // Multi-byte sequences may straddle chunk boundaries
+    const decoder = new TextDecoder('utf-8');
+    for await (const chunk of chunks) {
+      const text = decoder.decode(chunk, { stream: true });
+      if (text) {
+        yield text;
+      }
+    }
+    const tail = decoder.decode();
+    if (tail) {
+      yield tail;
+    }
+  }
+
   /**
    * Create a directory
    */
@@ -173,15 +321,14 @@ export class FileSystem {
    * Get file/directory information
    */
   static async getFileInfo(path: string): Promise<FileInfo> {
-    const info: FileInfo = await invokeNative('fs.getFileInfo', { path });
-    return info;
+    return fs.getFileInfo({ path });
   }
 
   /**
    * Check if a path exists
    */
   static async exists(path: string): Promise<boolean> {
-    const result = await invokeNative('fs.exists', { path });
+    const result = await fs.exists({ path });
     return result.exists;
   }
 
@@ -189,7 +336,7 @@ export class FileSystem {
    * Resolve a path
    */
   static async resolvePath(path: string): Promise<string> {
-    const result = await invokeNative('fs.resolvePath', { path });
+    const result = await fs.resolvePath({ path });
     return result.path;
   }
 
@@ -197,7 +344,7 @@ export class FileSystem {
    * Get basename of a path
    */
   static async basename(path: string, ext?: string): Promise<string> {
-    const result = await invokeNative('fs.basename', { path, ext });
+    const result = await fs.basename(ext === undefined ? { path } : { path, ext });
     return result.basename;
   }
 
@@ -205,7 +352,7 @@ export class FileSystem {
    * Get dirname of a path
    */
   static async dirname(path: string): Promise<string> {
-    const result = await invokeNative('fs.dirname', { path });
+    const result = await fs.dirname({ path });
     return result.dirname;
   }
 
@@ -213,7 +360,7 @@ export class FileSystem {
    * Get extension of a path
    */
   static async extname(path: string): Promise<string> {
-    const result = await invokeNative('fs.extname', { path });
+    const result = await fs.extname({ path });
     return result.extname;
   }
 
@@ -221,13 +368,14 @@ export class FileSystem {
    * Join path segments
    */
   static async joinPath(...segments: string[]): Promise<string> {
-    const result = await invokeNative('fs.joinPath', { segments });
+    const result = await fs.joinPath({ segments });
     return result.path;
   }
 }
 
 // Convenience exports
 export const {
+  open,
   readFile,
   writeFile,
   appendFile,
@@ -235,6 +383,8 @@ export const {
   copyFile,
   moveFile,
   readDir,
+  readDirStream,
+  readFileStream,
   createDir,
   deleteDir,
   getFileInfo,
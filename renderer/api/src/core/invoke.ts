@@ -17,11 +17,270 @@ export interface InvokeResponse {
 export type InvokeCallback = (result: any, success: boolean) => void;
 export type NativeInvokeHandler = (data: any) => Promise<any> | any;
 
+interface QueuedInvoke {
+  method: string;
+  data: any;
+  priority: InvokePriority;
+  signal?: AbortSignal;
+  resolve: (value: any) => void;
+  reject: (reason: any) => void;
+}
+
+export type InvokePriority = 'interactive' | 'normal' | 'background';
+
+export interface InvokeOptions {
+  /** Aborting rejects the call and asks the native handler to stop */
+  signal?: AbortSignal;
+  /**
+   * Lane the call waits in when native workers are saturated. Use
+   * 'interactive' for calls the user is waiting on and 'background' for
+   * prefetching and indexing. Defaults to 'normal'.
+   */
+  priority?: InvokePriority;
+}
+
+/**
+ * Caching for a method without side effects. Identical calls (same method,
+ * same data up to key order) made while one is in flight share its result,
+ * and successful results are reused for ttl milliseconds.
+ */
+export interface CachePolicy {
+  /** Milliseconds a result is reused; 0 only shares in-flight calls */
+  ttl?: number;
+  /** Methods whose calls drop this method's cached results when they settle */
+  invalidatedBy?: string[];
+}
+
+export interface InvokeCacheStats {
+  /** Answered from the cache */
+  hits: number;
+  /** Sent to the native side */
+  misses: number;
+  /** Joined an identical call already in flight */
+  coalesced: number;
+  entries: number;
+}
+
+export interface InvokeStreamOptions {
+  /** Preferred chunk size (entries or bytes, depending on the method) */
+  chunkSize?: number;
+  /** Chunks the native side may send ahead of the consumer */
+  highWaterMark?: number;
+  /** Aborting ends iteration and stops the native producer */
+  signal?: AbortSignal;
+}
+
+// Calls queued in one microtask are flushed together; larger bursts are split
+const MAX_BATCH_SIZE = 256;
+
+const DEFAULT_HIGH_WATER_MARK = 4;
+
+// Cached results kept before the oldest are dropped
+const MAX_CACHE_ENTRIES = 1024;
+
+function abortReason(signal: AbortSignal): any {
+  return signal.reason !== undefined ? signal.reason : new DOMException('Aborted', 'AbortError');
+}
+
+/**
+ * Settle a native invoke promise, cancelling the native call if signal aborts
+ * first. The native promise rejects as soon as it is cancelled; the caller
+ * sees the signal's reason instead of the native message.
+ */
+function withSignal<T>(promise: Promise<T>, signal?: AbortSignal): Promise<T> {
+  if (!signal) {
+    return promise;
+  }
+
+  const mikoview = (window as any).mikoview;
+  const onAbort = () => mikoview.cancelInvoke(promise, 'Aborted');
+  signal.addEventListener('abort', onAbort, { once: true });
+
+  return promise.then(
+    value => {
+      signal.removeEventListener('abort', onAbort);
+      return value;
+    },
+    error => {
+      signal.removeEventListener('abort', onAbort);
+      throw signal.aborted ? abortReason(signal) : error;
+    }
+  );
+}
+
+/**
+ * Like withSignal, for a promise other callers share: aborting rejects this
+ * caller only and leaves the native call running for the rest.
+ */
+function detachOnAbort<T>(promise: Promise<T>, signal?: AbortSignal): Promise<T> {
+  if (!signal) {
+    return promise;
+  }
+
+  return new Promise<T>((resolve, reject) => {
+    const onAbort = () => reject(abortReason(signal));
+    signal.addEventListener('abort', onAbort, { once: true });
+    promise.then(
+      value => {
+        signal.removeEventListener('abort', onAbort);
+        resolve(value);
+      },
+      error => {
+        signal.removeEventListener('abort', onAbort);
+        reject(error);
+      }
+    );
+  });
+}
+
+/**
+ * JSON.stringify with object keys sorted, so the same arguments built in any
+ * key order map to one cache entry
+ */
+function stableStringify(value: any): string {
+  if (value === null || typeof value !== 'object') {
+    const json = JSON.stringify(value);
+    return json === undefined ? 'null' : json;
+  }
+  if (Array.isArray(value)) {
+    return '[' + value.map(stableStringify).join(',') + ']';
+  }
+  return '{' + Object.keys(value)
+    .filter(key => value[key] !== undefined)
+    .sort()
+    .map(key => JSON.stringify(key) + ':' + stableStringify(value[key]))
+    .join(',') + '}';
+}
+
+function isBinary(data: any): boolean {
+  return data instanceof ArrayBuffer || ArrayBuffer.isView(data);
+}
+
+/**
+ * Async iterator over a streamed native response. Every chunk handed to the
+ * consumer grants the native side one more credit, so no more than
+ * highWaterMark chunks are ever buffered here.
+ */
+class InvokeStream<T> implements AsyncIterableIterator<T> {
+  private chunks: T[] = [];
+  private waiting: { resolve: (result: IteratorResult<T>) => void; reject: (reason: any) => void } | null = null;
+  private finished = false;
+  private error: Error | null = null;
+  private streamId = 0;
+
+  constructor(method: string, data: any, options: InvokeStreamOptions) {
+    const mikoview = (window as any).mikoview;
+    if (!mikoview || !mikoview.invokeStream) {
+      throw new Error('Native invoke stream not available');
+    }
+
+    this.streamId = mikoview.invokeStream(method, data || {}, {
+      chunk: (value: T) => this.push(value),
+      end: () => this.finish(null),
+      error: (message: string, code: number) => {
+        const error: any = new Error(message || 'Stream failed');
+        error.code = code;
+        this.finish(error);
+      }
+    }, options.chunkSize || 0, options.highWaterMark || DEFAULT_HIGH_WATER_MARK);
+
+    const signal = options.signal;
+    if (signal) {
+      signal.addEventListener('abort', () => {
+        if (!this.finished) {
+          mikoview.streamCancel(this.streamId);
+          this.finish(abortReason(signal));
+        }
+      }, { once: true });
+    }
+  }
+
+  [Symbol.asyncIterator](): AsyncIterableIterator<T> {
+    return this;
+  }
+
+  next(): Promise<IteratorResult<T>> {
+    if (this.chunks.length > 0) {
+      const value = this.chunks.shift() as T;
+      this.ack();
+      return Promise.resolve({ value, done: false });
+    }
+    if (this.error) {
+      return Promise.reject(this.error);
+    }
+    if (this.finished) {
+      return Promise.resolve({ value: undefined, done: true });
+    }
+    return new Promise((resolve, reject) => {
+      this.waiting = { resolve, reject };
+    });
+  }
+
+  /**
+   * Called by for-await on break/throw; stops the native producer
+   */
+  return(): Promise<IteratorResult<T>> {
+    if (!this.finished) {
+      this.finished = true;
+      (window as any).mikoview.streamCancel(this.streamId);
+    }
+    this.chunks = [];
+    return Promise.resolve({ value: undefined, done: true });
+  }
+
+  private push(value: T): void {
+    if (this.finished) {
+      return;
+    }
+    if (this.waiting) {
+      const waiting = this.waiting;
+      this.waiting = null;
+      this.ack();
+      waiting.resolve({ value, done: false });
+    } else {
+      this.chunks.push(value);
+    }
+  }
+
+  private finish(error: Error | null): void {
+    if (this.finished) {
+      return;
+    }
+    this.finished = true;
+    this.error = error;
+    if (this.waiting) {
+      const waiting = this.waiting;
+      this.waiting = null;
+      if (error) {
+        waiting.reject(error);
+      } else {
+        waiting.resolve({ value: undefined, done: true });
+      }
+    }
+  }
+
+  private ack(): void {
+    if (!this.finished) {
+      (window as any).mikoview.streamAck(this.streamId, 1);
+    }
+  }
+}
+
 class InvokeManager {
   private static instance: InvokeManager;
   private pendingRequests = new Map<number, InvokeCallback>();
   private nativeHandlers = new Map<string, NativeInvokeHandler>();
   private nextRequestId = 1;
+  private batching = true;
+  private queue: QueuedInvoke[] = [];
+  private flushScheduled = false;
+  private cachePolicies = new Map<string, CachePolicy>();
+  private invalidators = new Map<string, Set<string>>();
+  private cache = new Map<string, { value: any; expires: number }>();
+  private shared = new Map<string, Promise<any>>();
+  // Bumped by every invalidation; calls in flight across one are not cached
+  private cacheGeneration = 0;
+  private cacheStats = { hits: 0, misses: 0, coalesced: 0 };
 
   static getInstance(): InvokeManager {
     if (!InvokeManager.instance) {
@@ -39,8 +298,235 @@ class InvokeManager {
 
   /**
    * Invoke a native method
+   *
+   * The native binding returns a promise that the renderer process resolves
+   * directly from the browser's response message. ArrayBuffer and TypedArray
+   * data is sent as raw bytes, and binary responses resolve to an ArrayBuffer.
+   *
+   * Calls made in the same microtask are coalesced into one process message.
+   * Pass options.signal to cancel the call; the native handler is told to
+   * stop and the promise rejects with the signal's reason.
+   *
+   * When the native side is saturated the call rejects with a
+   * "Server busy: ..." error instead of queueing without bound.
+   *
+   * Methods with a cache policy (see setCachePolicy) may be answered without
+   * a round trip; their results are shared, so treat them as read-only.
    */
-  async invoke<T = any>(method: string, data?: any): Promise<T> {
+  async invoke<T = any>(method: string, data?: any, options: InvokeOptions = {}): Promise<T> {
+    const mikoview = (window as any).mikoview;
+    if (!mikoview || !mikoview.invoke) {
+      throw new Error('Native invoke not available');
+    }
+
+    const signal = options.signal;
+    if (signal && signal.aborted) {
+      throw abortReason(signal);
+    }
+
+    data = data || {};
+    const policy = this.cachePolicies.get(method);
+    if (policy && !isBinary(data)) {
+      return this.invokeCached<T>(method, data, policy, options);
+    }
+
+    const invalidates = this.invalidators.get(method);
+    if (!invalidates) {
+      return this.send<T>(method, data, options);
+    }
+
+    // Whatever the call changed is stale once it settles, even if it failed
+    const settle = () => invalidates.forEach(target => this.invalidate(target));
+    return this.send<T>(method, data, options).then(
+      value => {
+        settle();
+        return value;
+      },
+      error => {
+        settle();
+        throw error;
+      }
+    );
+  }
+
+  /**
+   * Cache and share identical calls of a method without side effects, or
+   * stop doing so with null. The native handler may cache as well; this
+   * saves the round trip.
+   */
+  setCachePolicy(method: string, policy: CachePolicy | null): void {
+    const previous = this.cachePolicies.get(method);
+    if (previous) {
+      (previous.invalidatedBy || []).forEach(source => {
+        const targets = this.invalidators.get(source);
+        if (targets) {
+          targets.delete(method);
+        }
+      });
+    }
+    this.invalidate(method);
+
+    if (!policy) {
+      this.cachePolicies.delete(method);
+      return;
+    }
+
+    this.cachePolicies.set(method, policy);
+    (policy.invalidatedBy || []).forEach(source => {
+      let targets = this.invalidators.get(source);
+      if (!targets) {
+        targets = new Set<string>();
+        this.invalidators.set(source, targets);
+      }
+      targets.add(method);
+    });
+  }
+
+  /**
+   * Drop cached results of one method, or of every method. Calls already in
+   * flight still answer their callers but are not cached, and later calls
+   * do not join them.
+   */
+  invalidate(method?: string): void {
+    this.cacheGeneration++;
+    if (method === undefined) {
+      this.cache.clear();
+      this.shared.clear();
+      return;
+    }
+
+    const prefix = method + '\u0000';
+    for (const key of Array.from(this.cache.keys())) {
+      if (key.startsWith(prefix)) {
+        this.cache.delete(key);
+      }
+    }
+    for (const key of Array.from(this.shared.keys())) {
+      if (key.startsWith(prefix)) {
+        this.shared.delete(key);
+      }
+    }
+  }
+
+  /**
+   * Renderer-side cache counters; see getInvokeMetrics() for the native ones
+   */
+  getCacheStats(reset: boolean = false): InvokeCacheStats {
+    const stats = { ...this.cacheStats, entries: this.cache.size };
+    if (reset) {
+      this.cacheStats = { hits: 0, misses: 0, coalesced: 0 };
+    }
+    return stats;
+  }
+
+  private invokeCached<T>(method: string, data: any, policy: CachePolicy, options: InvokeOptions): Promise<T> {
+    const key = method + '\u0000' + stableStringify(data);
+
+    const cached = this.cache.get(key);
+    if (cached) {
+      if (cached.expires > performance.now()) {
+        this.cacheStats.hits++;
+        return Promise.resolve(cached.value);
+      }
+      this.cache.delete(key);
+    }
+
+    const running = this.shared.get(key);
+    if (running) {
+      this.cacheStats.coalesced++;
+      return detachOnAbort(running, options.signal);
+    }
+
+    // Shared by every caller, so no single caller's signal may cancel it
+    this.cacheStats.misses++;
+    const generation = this.cacheGeneration;
+    const ttl = policy.ttl || 0;
+    const promise: Promise<T> = this.send<T>(method, data, { priority: options.priority }).then(
+      value => {
+        if (this.shared.get(key) === promise) {
+          this.shared.delete(key);
+        }
+        if (ttl > 0 && generation === this.cacheGeneration) {
+          this.store(key, value, ttl);
+        }
+        return value;
+      },
+      error => {
+        if (this.shared.get(key) === promise) {
+          this.shared.delete(key);
+        }
+        throw error;
+      }
+    );
+    this.shared.set(key, promise);
+    return detachOnAbort(promise, options.signal);
+  }
+
+  private store(key: string, value: any, ttl: number): void {
+    // Map iterates in insertion order, so the first key is the oldest
+    this.cache.delete(key);
+    if (this.cache.size >= MAX_CACHE_ENTRIES) {
+      this.cache.delete(this.cache.keys().next().value as string);
+    }
+    this.cache.set(key, { value, expires: performance.now() + ttl });
+  }
+
+  private send<T>(method: string, data: any, options: InvokeOptions): Promise<T> {
+    const mikoview = (window as any).mikoview;
+    const signal = options.signal;
+    const priority = options.priority || 'normal';
+    if (!this.batching || !mikoview.invokeBatch || isBinary(data)) {
+      return withSignal(mikoview.invoke(method, data, { priority }), signal);
+    }
+
+    return new Promise<T>((resolve, reject) => {
+      const call: QueuedInvoke = { method, data, priority, signal, resolve, reject };
+      this.queue.push(call);
+
+      // Aborted before the flush: never reaches the native side
+      if (signal) {
+        signal.addEventListener('abort', () => {
+          const index = this.queue.indexOf(call);
+          if (index >= 0) {
+            this.queue.splice(index, 1);
+            reject(abortReason(signal));
+          }
+        }, { once: true });
+      }
+
+      if (this.queue.length >= MAX_BATCH_SIZE) {
+        this.flush();
+      } else if (!this.flushScheduled) {
+        this.flushScheduled = true;
+        queueMicrotask(() => this.flush());
+      }
+    });
+  }
+
+  /**
+   * Invoke a native stream handler and iterate its chunks as they arrive
+   *
+   * Breaking out of a for-await loop cancels the stream on the native side.
+   */
+  invokeStream<T = any>(method: string, data?: any, options: InvokeStreamOptions = {}): AsyncIterableIterator<T> {
+    return new InvokeStream<T>(method, data, options);
+  }
+
+  /**
+   * Enable or disable microtask batching of invoke calls
+   */
+  setBatching(enabled: boolean): void {
+    this.batching = enabled;
+    if (!enabled) {
+      this.flush();
+    }
+  }
+
+  /**
+   * Invoke a native method using the legacy script transport, where the
+   * browser answers by evaluating window.mikoview._handleInvokeResponse(...)
+   */
+  async invokeViaScript<T = any>(method: string, data?: any): Promise<T> {
     return new Promise<T>((resolve, reject) => {
       const requestId = this.generateRequestId();
       
@@ -58,6 +544,7 @@ class InvokeManager {
       } else {
         // Fallback for development/testing
         setTimeout(() => {
+          this.pendingRequests.delete(requestId);
           reject(new Error('Native invoke not available'));
         }, 0);
       }
@@ -78,6 +565,31 @@ class InvokeManager {
     this.nativeHandlers.delete(method);
   }
 
+  private flush(): void {
+    this.flushScheduled = false;
+    const calls = this.queue;
+    if (calls.length === 0) {
+      return;
+    }
+    this.queue = [];
+
+    const mikoview = (window as any).mikoview;
+    try {
+      if (calls.length === 1) {
+        withSignal(mikoview.invoke(calls[0].method, calls[0].data, { priority: calls[0].priority }), calls[0].signal)
+          .then(calls[0].resolve, calls[0].reject);
+        return;
+      }
+
+      const promises: Promise<any>[] = mikoview.invokeBatch(
+        calls.map(call => ({ method: call.method, data: call.data, priority: call.priority }))
+      );
+      calls.forEach((call, i) => withSignal(promises[i], call.signal).then(call.resolve, call.reject));
+    } catch (error) {
+      calls.forEach(call => call.reject(error));
+    }
+  }
+
   private handleInvokeResponse(response: InvokeResponse): void {
     const callback = this.pendingRequests.get(response.requestId);
     if (callback) {
@@ -125,8 +637,48 @@ class InvokeManager {
 export const invoke = InvokeManager.getInstance();
 
 // Convenience function for direct invocation
-export async function invokeNative<T = any>(method: string, data?: any): Promise<T> {
-  return invoke.invoke<T>(method, data);
+export async function invokeNative<T = any>(method: string, data?: any, options?: InvokeOptions): Promise<T> {
+  return invoke.invoke<T>(method, data, options);
+}
+
+// Convenience function for streamed invocation
+export function invokeNativeStream<T = any>(method: string, data?: any, options?: InvokeStreamOptions): AsyncIterableIterator<T> {
+  return invoke.invokeStream<T>(method, data, options);
+}
+
+export interface LatencySummary {
+  count: number;
+  mean: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  max: number;
+}
+
+export interface MethodMetrics {
+  calls: number;
+  errors: number;
+  bytesIn: number;
+  bytesOut: number;
+  /** Answered from the native result cache (idempotent handlers) */
+  cacheHits: number;
+  /** Shared the execution of an identical call in flight */
+  coalesced: number;
+  /** Microseconds between the browser receiving the call and the handler starting */
+  queueUs: LatencySummary;
+  /** Microseconds spent in the handler */
+  execUs: LatencySummary;
+}
+
+export interface InvokeMetrics {
+  uptimeMs: number;
+  methods: Record<string, MethodMetrics>;
+}
+
+// Per-method metrics collected by the native invoke handler; see
+// invoke.getCacheStats() for the renderer-side cache
+export async function getInvokeMetrics(reset: boolean = false): Promise<InvokeMetrics> {
+  return invoke.invoke<InvokeMetrics>('mikoview.metrics', { reset });
 }
 
 // Register handler function
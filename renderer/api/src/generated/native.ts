@@ -0,0 +1,85 @@
+// Generated by `invokehost typescript` from the handlers registered with
+// RegisterTyped(). Do not edit; build the mikoview_typescript target instead.
+
+import { invokeNative } from '../core/invoke';
+import type { InvokeOptions } from '../core/invoke';
+
+export interface BasenameArgs {
+  path: string;
+  ext?: string;
+}
+
+export interface BasenameResult {
+  basename: string;
+}
+
+export interface DirnameResult {
+  dirname: string;
+}
+
+export interface ExistsResult {
+  exists: boolean;
+}
+
+export interface ExtnameResult {
+  extname: string;
+}
+
+export interface FileInfo {
+  name: string;
+  path: string;
+  extension: string;
+  size: number;
+  modified: number;
+  created: number;
+  isDirectory: boolean;
+  isFile: boolean;
+  isSymlink: boolean;
+}
+
+export interface HandleArgs {
+  fd: number;
+}
+
+export interface JoinPathArgs {
+  segments: string[];
+}
+
+export interface OpenArgs {
+  path: string;
+  flags?: string;
+}
+
+export interface OpenResult {
+  fd: number;
+  size: number;
+}
+
+export interface PathArgs {
+  path: string;
+}
+
+export interface PathResult {
+  path: string;
+}
+
+export const fs = {
+  basename: (args: BasenameArgs, options?: InvokeOptions): Promise<BasenameResult> =>
+    invokeNative<BasenameResult>('fs.basename', args, options),
+  close: (args: HandleArgs, options?: InvokeOptions): Promise<null> =>
+    invokeNative<null>('fs.close', args, options),
+  dirname: (args: PathArgs, options?: InvokeOptions): Promise<DirnameResult> =>
+    invokeNative<DirnameResult>('fs.dirname', args, options),
+  exists: (args: PathArgs, options?: InvokeOptions): Promise<ExistsResult> =>
+    invokeNative<ExistsResult>('fs.exists', args, options),
+  extname: (args: PathArgs, options?: InvokeOptions): Promise<ExtnameResult> =>
+    invokeNative<ExtnameResult>('fs.extname', args, options),
+  getFileInfo: (args: PathArgs, options?: InvokeOptions): Promise<FileInfo> =>
+    invokeNative<FileInfo>('fs.getFileInfo', args, options),
+  joinPath: (args: JoinPathArgs, options?: InvokeOptions): Promise<PathResult> =>
+    invokeNative<PathResult>('fs.joinPath', args, options),
+  open: (args: OpenArgs, options?: InvokeOptions): Promise<OpenResult> =>
+    invokeNative<OpenResult>('fs.open', args, options),
+  resolvePath: (args: PathArgs, options?: InvokeOptions): Promise<PathResult> =>
+    invokeNative<PathResult>('fs.resolvePath', args, options),
+};
@@ -0,0 +1,945 @@
+// Headless host for the invoke core: benchmarks the dispatcher in-process
+// and serves or drives it over a Unix socket, no browser involved.
+//
+//   invokehost bench [options]           loopback benchmark
+//   invokehost serve <socket> [options] serve the handlers until Ctrl+C
+//   invokehost drive <socket> [options]  benchmark a running "serve"
+//   invokehost events [event options]    EventHub stress benchmark
+//   invokehost fsread <file> [options]   random ranged reads through a file
+//                                        handle against whole-file reads
+//   invokehost replay <log> [replay options]
+//                                        feed a recorded invoke log into the
+//                                        handlers; they really run, so fs.*
+//                                        writes happen again
+//   invokehost typescript <file> [--check]
+//                                        write the typed handlers' TypeScript
+//                                        bindings, or fail if file is stale
+//
+// options: --method NAME   (bench.echo; bench.asyncEcho for a coroutine handler)
+//          --data JSON     ({"value":42})
+//          --calls N       (100000)
+//          --concurrency N (64)
+//          --record FILE   log every request, for replay (bench, serve)
+//          --copy          copy each answer into fresh memory once, as
+//                          CEF's IPC does for large payloads (bench, fsread)
+//          --length N      bytes per fs.read (4096, fsread)
+//
+// replay options: --fast            as fast as possible instead of at the
+//                                   recorded pacing
+//                 --speed X         pacing multiplier (1)
+//                 --concurrency N   calls outstanding with --fast (64)
+//
+// event options: --rate N      events per second (10000)
+//                --duration MS (2000)
+//                --cost US     UI time each delivered message costs, standing
+//                              in for the renderer's per-message work (0)
+
+#include "mikoview/jsapi/dispatcher.hpp"
+#include "mikoview/jsapi/events.hpp"
+#include "mikoview/jsapi/filesystem.hpp"
+#include "mikoview/jsapi/jsonwriter.hpp"
+#include "mikoview/jsapi/loopback.hpp"
+#include "mikoview/jsapi/metrics.hpp"
+#include "mikoview/jsapi/recorder.hpp"
+#include "mikoview/jsapi/typed.hpp"
+#include <json/json.h>
+#if !defined(_WIN32)
+    #include "mikoview/jsapi/unixsocket.hpp"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <sstream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace MikoView::JSAPI;
+
+namespace {
+
+struct Options {
+    std::string method = "bench.echo";
+    std::string data = "{\"value\":42}";
+    int calls = 100000;
+    int concurrency = 64;
+    std::string record;
+    bool copy = false;
+    int length = 4096;
+};
+
+struct ReplayOptions {
+    bool fast = false;
+    double speed = 1.0;
+    int concurrency = 64;
+};
+
+struct EventOptions {
+    int rate = 10000;
+    int durationMs = 2000;
+    int costUs = 0;
+};
+
+struct Result {
+    LatencyHistogram latency;
+    int errors = 0;
+    double seconds = 0.0;
+};
+
+std::atomic<bool> g_stop{false};
+
+// Every operator new in the process, counted for `bench`
+std::atomic<uint64_t> g_allocations{0};
+
+void OnSignal(int) {
+    g_stop = true;
+}
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "usage: invokehost bench [options]\n"
+        "       invokehost serve <socket> [--record FILE]\n"
+        "       invokehost drive <socket> [options]\n"
+        "       invokehost events [event options]\n"
+        "       invokehost fsread <file> [options]\n"
+        "       invokehost replay <log> [replay options]\n"
+        "       invokehost typescript <file> [--check]\n"
+        "options: --method NAME --data JSON --calls N --concurrency N --record FILE --copy --length N\n"
+        "event options: --rate N --duration MS --cost US\n"
+        "replay options: --fast --speed X --concurrency N\n");
+}
+
+bool ParseOptions(int argc, char* argv[], int first, Options& options) {
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--copy") {
+            options.copy = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--method") {
+            options.method = value;
+        } else if (arg == "--data") {
+            options.data = value;
+        } else if (arg == "--calls") {
+            options.calls = std::atoi(value.c_str());
+        } else if (arg == "--concurrency") {
+            options.concurrency = std::atoi(value.c_str());
+        } else if (arg == "--record") {
+            options.record = value;
+        } else if (arg == "--length") {
+            options.length = std::atoi(value.c_str());
+        } else {
+            return false;
+        }
+    }
+    return options.calls > 0 && options.concurrency > 0 && options.length > 0;
+}
+
+bool ParseReplayOptions(int argc, char* argv[], int first, ReplayOptions& options) {
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fast") {
+            options.fast = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--speed") {
+            options.speed = std::atof(value.c_str());
+        } else if (arg == "--concurrency") {
+            options.concurrency = std::atoi(value.c_str());
+        } else {
+            return false;
+        }
+    }
+    return options.speed > 0.0 && options.concurrency > 0;
+}
+
+bool StartRecording(const Options& options) {
+    std::string error;
+    if (!options.record.empty() && !InvokeDispatcher::GetInstance()->StartRecording(options.record, 0, &error)) {
+        std::fprintf(stderr, "invokehost: %s\n", error.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ParseEventOptions(int argc, char* argv[], int first, EventOptions& options) {
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const int value = std::atoi(argv[++i]);
+        if (arg == "--rate") {
+            options.rate = value;
+        } else if (arg == "--duration") {
+            options.durationMs = value;
+        } else if (arg == "--cost") {
+            options.costUs = value;
+        } else {
+            return false;
+        }
+    }
+    return options.rate > 0 && options.durationMs > 0 && options.costUs >= 0;
+}
+
+void RegisterHandlers() {
+    FileSystem::FileSystemHandler::RegisterHandlers();
+    EventHub::RegisterStressHandler();
+    
+    // Pure dispatch overhead: a worker-pool round trip that does no work
+    InvokeDispatcher::GetInstance()->RegisterHandler("bench.echo",
+        [](const InvokeRequest& request, InvokeResponse& response) {
+            response.SetSuccessJSON(std::string(request.GetData()));
+        }, HandlerAffinity::CPU);
+    
+    // The same round trip as a coroutine that offloads to the pool and
+    // resumes on the UI thread
+    InvokeDispatcher::GetInstance()->RegisterAsyncHandler("bench.asyncEcho",
+        [](const InvokeRequest& request) -> Async::Task<InvokeResponse> {
+            std::string data = co_await Async::RunOn(HandlerAffinity::CPU, [&request]() {
+                return std::string(request.GetData());
+            });
+            InvokeResponse response(request.GetRequestId());
+            response.SetSuccessJSON(std::move(data));
+            co_return response;
+        });
+}
+
+void PrintResult(const char* transport, const Options& options, const Result& result) {
+    std::printf("%s %s: %d calls, concurrency %d, %.2f s, %.0f calls/s, %d errors\n",
+                transport, options.method.c_str(), options.calls, options.concurrency,
+                result.seconds, options.calls / result.seconds, result.errors);
+    std::printf("latency us: mean %.1f p50 %llu p90 %llu p99 %llu max %llu\n",
+                result.latency.GetMean(),
+                static_cast<unsigned long long>(result.latency.GetPercentile(0.50)),
+                static_cast<unsigned long long>(result.latency.GetPercentile(0.90)),
+                static_cast<unsigned long long>(result.latency.GetPercentile(0.99)),
+                static_cast<unsigned long long>(result.latency.GetMax()));
+}
+
+// Closed loop: `concurrency` calls are kept outstanding until `calls` have
+// been answered. Callbacks run on the UI thread, so the counters need no lock.
+class BenchLoop {
+public:
+    explicit BenchLoop(const Options& options) : options_(options) {}
+    
+    void Start() {
+        for (int i = 0; i < options_.concurrency && issued_ < options_.calls; ++i) {
+            Issue();
+        }
+    }
+    
+    void Wait() { done_.get_future().wait(); }
+    const Result& GetResult() const { return result_; }
+    LoopbackTransport& GetTransport() { return transport_; }
+    
+    // Sent in turn instead of options.data; prepared up front so the loop
+    // still allocates nothing of its own
+    void SetData(std::vector<std::string> data) { data_ = std::move(data); }
+    
+private:
+    void Issue() {
+        const std::string& data = data_.empty() ? options_.data : data_[issued_ % data_.size()];
+        ++issued_;
+        const uint64_t start = Metrics::NowUs();
+        // [this, start] fits in std::function's inline storage, so the loop
+        // adds no allocations of its own to the count
+        transport_.Call(options_.method, data, [this, start](const InvokeResponse& response) {
+            if (options_.copy) {
+                Copy(response);
+            }
+            result_.latency.Record(Metrics::NowUs() - start);
+            if (!response.IsSuccess()) {
+                ++result_.errors;
+            }
+            if (issued_ < options_.calls) {
+                Issue();
+            }
+            if (++completed_ == options_.calls) {
+                done_.set_value();
+            }
+        });
+    }
+    
+    // Into a new shared memory region in the app; fresh pages here too
+    static void Copy(const InvokeResponse& response) {
+        const bool binary = response.IsBinary();
+        const size_t size = binary ? response.GetBinary().size : response.GetData().size();
+        std::unique_ptr<char[]> copy(new char[size ? size : 1]);
+        std::memcpy(copy.get(), binary ? static_cast<const void*>(response.GetBinary().data)
+                                       : static_cast<const void*>(response.GetData().data()), size);
+        volatile char last = size ? copy[size - 1] : 0;
+        (void)last;
+    }
+    
+    const Options& options_;
+    LoopbackTransport transport_;
+    std::vector<std::string> data_;
+    Result result_;
+    int issued_ = 0;
+    int completed_ = 0;
+    std::promise<void> done_;
+};
+
+// Runs the loop to completion and counts the heap allocations made meanwhile
+Result RunLoop(BenchLoop& loop, uint64_t& allocations) {
+    const uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+    const auto begin = std::chrono::steady_clock::now();
+    Executor::PostToUI([&loop]() { loop.Start(); });
+    loop.Wait();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    allocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+    
+    Result result = loop.GetResult();
+    result.seconds = seconds;
+    return result;
+}
+
+int RunBench(const Options& options) {
+    BenchLoop loop(options);
+    uint64_t allocations = 0;
+    const Result result = RunLoop(loop, allocations);
+    PrintResult("loopback", options, result);
+    std::printf("heap allocations: %.2f per call\n", static_cast<double>(allocations) / options.calls);
+    return result.errors == 0 ? 0 : 1;
+}
+
+// What a viewer showing one screen of a large file costs: fs.read of
+// options.length bytes at a random offset through one handle, against
+// reading the whole file with fs.readFile for every screen
+int RunFileRead(const std::string& path, const Options& options) {
+    Options ranged = options;
+    ranged.method = "fs.read";
+    BenchLoop loop(ranged);
+    
+    JsonWriter openArgs;
+    openArgs.BeginObject();
+    openArgs.Key("path").String(path);
+    openArgs.EndObject();
+    const InvokeResponse opened = loop.GetTransport().CallSync("fs.open", openArgs.Release());
+    Json::Value file;
+    if (!opened.IsSuccess() || !Json::Reader().parse(opened.GetData(), file)) {
+        std::fprintf(stderr, "invokehost: cannot open %s: %s\n", path.c_str(), opened.GetError().c_str());
+        return 1;
+    }
+    const uint64_t size = file["size"].asUInt64();
+    const uint64_t blocks = size / static_cast<uint64_t>(options.length);
+    if (blocks == 0) {
+        std::fprintf(stderr, "invokehost: %s is smaller than --length\n", path.c_str());
+        return 1;
+    }
+    
+    // Block-aligned offsets, the same sequence every run
+    std::mt19937_64 random(42);
+    std::vector<std::string> reads;
+    reads.reserve(static_cast<size_t>(options.calls));
+    for (int i = 0; i < options.calls; ++i) {
+        JsonWriter args;
+        args.BeginObject();
+        args.Key("fd").Int(file["fd"].asInt());
+        args.Key("offset").UInt(random() % blocks * static_cast<uint64_t>(options.length));
+        args.Key("length").Int(options.length);
+        args.EndObject();
+        reads.push_back(args.Release());
+    }
+    loop.SetData(std::move(reads));
+    
+    uint64_t allocations = 0;
+    const Result result = RunLoop(loop, allocations);
+    PrintResult("loopback", ranged, result);
+    std::printf("heap allocations: %.2f per call\n", static_cast<double>(allocations) / ranged.calls);
+    
+    // Whole-file reads take far longer; a few are enough for the rate
+    Options whole = options;
+    whole.method = "fs.readFile";
+    whole.calls = std::min(options.calls, 50);
+    JsonWriter wholeArgs;
+    wholeArgs.BeginObject();
+    wholeArgs.Key("path").String(path);
+    wholeArgs.Key("encoding").String("binary");
+    wholeArgs.EndObject();
+    whole.data = wholeArgs.Release();
+    BenchLoop wholeLoop(whole);
+    const Result wholeResult = RunLoop(wholeLoop, allocations);
+    PrintResult("loopback", whole, wholeResult);
+    
+    std::printf("bytes per screen: %d vs %llu, %.0fx the screens per second\n", options.length,
+                static_cast<unsigned long long>(size),
+                (ranged.calls / result.seconds) / (whole.calls / wholeResult.seconds));
+    return result.errors == 0 && wholeResult.errors == 0 ? 0 : 1;
+}
+
+// What one consumer saw during `events`. Updated on the UI thread only.
+struct EventRun {
+    uint64_t published = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t messages = 0;
+    // How late a task posted to the UI thread every 16 ms ran: the headless
+    // stand-in for renderer frame time
+    LatencyHistogram frameDelay;
+};
+
+void SpinFor(int us) {
+    const uint64_t until = Metrics::NowUs() + static_cast<uint64_t>(us);
+    while (Metrics::NowUs() < until) {
+    }
+}
+
+// Runs publish() on this thread while a probe thread times "frames" on the
+// UI thread, then waits for deliveries to drain
+void MeasureFrames(EventRun& run, const std::function<void()>& publish) {
+    std::atomic<bool> publishing{true};
+    std::thread probe([&run, &publishing]() {
+        while (publishing) {
+            const uint64_t postedAt = Metrics::NowUs();
+            Executor::PostToUI([&run, postedAt]() { run.frameDelay.Record(Metrics::NowUs() - postedAt); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
+    });
+    
+    publish();
+    publishing = false;
+    probe.join();
+    
+    // A flush may still be due; then everything queued ahead of this task
+    // has run
+    std::this_thread::sleep_for(std::chrono::milliseconds(kDefaultEventFlushMs * 3));
+    std::promise<void> drained;
+    Executor::PostToUI([&drained]() { drained.set_value(); });
+    drained.get_future().wait();
+}
+
+// The pre-EventHub path: one UI task per event, as InvokeRenderer() runs
+// one script per message
+EventRun RunDirectEvents(const EventOptions& options) {
+    EventRun run;
+    const int costUs = options.costUs;
+    MeasureFrames(run, [&run, &options, costUs]() {
+        const auto start = std::chrono::steady_clock::now();
+        const auto end = start + std::chrono::milliseconds(options.durationMs);
+        for (auto now = start; now < end; now = std::chrono::steady_clock::now()) {
+            const uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+            const uint64_t due = elapsedUs * static_cast<uint64_t>(options.rate) / 1000000;
+            for (; run.published < due; ++run.published) {
+                Executor::PostToUI([&run, costUs]() {
+                    SpinFor(costUs);
+                    run.delivered++;
+                    run.messages++;
+                });
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    return run;
+}
+
+EventRun RunHubEvents(const EventOptions& options, EventPolicy policy) {
+    EventRun run;
+    LoopbackTransport transport;
+    const int costUs = options.costUs;
+    const std::string topic = std::string(kEventStressTopicPrefix) + "bench";
+    transport.Subscribe(topic, policy, [&run, costUs](const std::vector<std::string>& events, uint64_t dropped) {
+        SpinFor(costUs);
+        run.delivered += events.size();
+        run.dropped += dropped;
+        run.messages++;
+    });
+    
+    MeasureFrames(run, [&run, &options, &transport, &topic]() {
+        JsonWriter args;
+        args.BeginObject();
+        args.Key("topic").String(topic);
+        args.Key("rate").Int(options.rate);
+        args.Key("durationMs").Int(options.durationMs);
+        args.EndObject();
+        
+        InvokeResponse response = transport.CallSync(kEventStressMethod, args.GetString());
+        Json::Value result;
+        if (response.IsSuccess() && Json::Reader().parse(response.GetData(), result)) {
+            run.published = result["published"].asUInt64();
+        }
+    });
+    return run;
+}
+
+void PrintEventRun(const char* name, const EventOptions& options, const EventRun& run) {
+    const double seconds = options.durationMs / 1000.0;
+    std::printf("%-7s published %llu, delivered %llu, dropped %llu, %llu messages (%.0f/s)\n",
+                name,
+                static_cast<unsigned long long>(run.published),
+                static_cast<unsigned long long>(run.delivered),
+                static_cast<unsigned long long>(run.dropped),
+                static_cast<unsigned long long>(run.messages),
+                run.messages / seconds);
+    std::printf("        frame delay us: mean %.1f p50 %llu p99 %llu max %llu\n",
+                run.frameDelay.GetMean(),
+                static_cast<unsigned long long>(run.frameDelay.GetPercentile(0.50)),
+                static_cast<unsigned long long>(run.frameDelay.GetPercentile(0.99)),
+                static_cast<unsigned long long>(run.frameDelay.GetMax()));
+}
+
+int RunEvents(const EventOptions& options) {
+    std::printf("%d events/s for %d ms, %d us per delivered message\n",
+                options.rate, options.durationMs, options.costUs);
+    PrintEventRun("direct", options, RunDirectEvents(options));
+    PrintEventRun("latest", options, RunHubEvents(options, EventPolicy::Latest));
+    PrintEventRun("frame", options, RunHubEvents(options, EventPolicy::Frame));
+    PrintEventRun("queue", options, RunHubEvents(options, EventPolicy::Queue));
+    return 0;
+}
+
+// What replaying one method came to. UI thread only.
+struct ReplayMethod {
+    LatencyHistogram latency;
+    uint64_t errors = 0;
+    uint64_t missing = 0;  // 404: not registered in invokehost
+    uint64_t busy = 0;     // 503: in-flight limit or a full lane
+};
+
+class ReplayRun;
+
+// One recorded (session, client) pair, replayed as a session of its own so
+// the per-client in-flight limit applies as it did when recording
+class ReplayChannel : public InvokeChannel {
+public:
+    ReplayChannel(ReplayRun& run, std::string clientKey)
+        : run_(run), sessionId_(InvokeDispatcher::NewSessionId()), clientKey_(std::move(clientKey)) {}
+    
+    int GetSessionId() const override { return sessionId_; }
+    const std::string& GetClientKey() const override { return clientKey_; }
+    
+    void SendResponse(const InvokeResponse& response) override;
+    void SendStreamMessage(int streamId, StreamEvent event, const std::string* data,
+                           bool binary, const std::string& error, int code) override;
+    
+private:
+    ReplayRun& run_;
+    const int sessionId_;
+    const std::string clientKey_;
+};
+
+// Issues the recorded requests at their recorded offsets (scaled by speed),
+// or with --fast keeps `concurrency` calls outstanding until all are
+// answered. Paced replay is open loop: a slow handler makes later calls
+// queue, as it did in the app.
+class ReplayRun {
+public:
+    ReplayRun(const ReplayOptions& options, std::vector<RecordedRequest> records)
+        : options_(options), records_(std::move(records)) {
+        for (const RecordedRequest& record : records_) {
+            calls_ += record.calls.size();
+        }
+    }
+    
+    void Run() {
+        if (calls_ == 0) {
+            return;
+        }
+        
+        const auto begin = std::chrono::steady_clock::now();
+        if (options_.fast) {
+            Executor::PostToUI([this]() { IssueMore(); });
+        } else {
+            const uint64_t beginUs = Metrics::NowUs();
+            for (size_t i = 0; i < records_.size(); ++i) {
+                const uint64_t offsetUs = static_cast<uint64_t>(records_[i].timeUs / options_.speed);
+                std::this_thread::sleep_until(begin + std::chrono::microseconds(offsetUs));
+                const uint64_t dueUs = beginUs + offsetUs;
+                Executor::PostToUI([this, i, dueUs]() {
+                    issueLag_.Record(Metrics::NowUs() - dueUs);
+                    Issue(i);
+                });
+            }
+        }
+        done_.get_future().wait();
+        seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    
+    // UI thread
+    void Complete(int requestId, bool success, int code) {
+        auto it = pending_.find(requestId);
+        if (it == pending_.end()) {
+            return;
+        }
+        ReplayMethod& method = *it->second.method;
+        method.latency.Record(Metrics::NowUs() - it->second.startUs);
+        if (!success) {
+            method.errors++;
+            if (code == 404) {
+                method.missing++;
+            } else if (code == 503) {
+                method.busy++;
+            }
+        }
+        pending_.erase(it);
+        
+        if (options_.fast) {
+            IssueMore();
+        }
+        if (++completed_ == calls_) {
+            done_.set_value();
+        }
+    }
+    
+    void Print(const std::string& path) const {
+        const double recorded = records_.empty() ? 0.0 : records_.back().timeUs / 1e6;
+        uint64_t errors = 0;
+        uint64_t missing = 0;
+        uint64_t busy = 0;
+        for (const auto& entry : methods_) {
+            errors += entry.second.errors;
+            missing += entry.second.missing;
+            busy += entry.second.busy;
+        }
+        
+        std::printf("replay %s: %zu records, %zu calls, recorded over %.2f s\n",
+                    path.c_str(), records_.size(), calls_, recorded);
+        if (options_.fast) {
+            std::printf("fast, concurrency %d: ", options_.concurrency);
+        } else {
+            std::printf("paced x%.2f: ", options_.speed);
+        }
+        std::printf("%.2f s, %.0f calls/s, %llu errors (%llu not registered here, %llu busy)\n",
+                    seconds_, seconds_ > 0.0 ? calls_ / seconds_ : 0.0,
+                    static_cast<unsigned long long>(errors), static_cast<unsigned long long>(missing),
+                    static_cast<unsigned long long>(busy));
+        if (!options_.fast) {
+            std::printf("issue lag us: p50 %llu p99 %llu max %llu\n",
+                        static_cast<unsigned long long>(issueLag_.GetPercentile(0.50)),
+                        static_cast<unsigned long long>(issueLag_.GetPercentile(0.99)),
+                        static_cast<unsigned long long>(issueLag_.GetMax()));
+        }
+        
+        // Busiest first
+        std::vector<std::pair<std::string, const ReplayMethod*>> methods;
+        for (const auto& entry : methods_) {
+            methods.emplace_back(entry.first, &entry.second);
+        }
+        std::sort(methods.begin(), methods.end(), [](const auto& a, const auto& b) {
+            return a.second->latency.GetCount() > b.second->latency.GetCount();
+        });
+        
+        std::printf("%-28s %9s %7s %10s %8s %8s %8s\n", "method", "calls", "errors", "mean us", "p50", "p99", "max");
+        for (const auto& entry : methods) {
+            const ReplayMethod& method = *entry.second;
+            std::printf("%-28s %9llu %7llu %10.1f %8llu %8llu %8llu\n",
+                        entry.first.c_str(),
+                        static_cast<unsigned long long>(method.latency.GetCount()),
+                        static_cast<unsigned long long>(method.errors),
+                        method.latency.GetMean(),
+                        static_cast<unsigned long long>(method.latency.GetPercentile(0.50)),
+                        static_cast<unsigned long long>(method.latency.GetPercentile(0.99)),
+                        static_cast<unsigned long long>(method.latency.GetMax()));
+        }
+    }
+    
+private:
+    struct Pending {
+        ReplayMethod* method;
+        uint64_t startUs;
+    };
+    
+    void Issue(size_t index) {
+        const RecordedRequest& record = records_[index];
+        if (record.calls.empty()) {
+            return;
+        }
+        
+        std::shared_ptr<ReplayChannel>& channel = channels_[{record.sessionId, record.clientKey}];
+        if (!channel) {
+            channel = std::make_shared<ReplayChannel>(*this, record.clientKey);
+        }
+        
+        // Fresh request ids: recorded ones are only unique per session
+        std::vector<InvokeRequest> requests;
+        requests.reserve(record.calls.size());
+        for (const RecordedCall& call : record.calls) {
+            const int requestId = nextRequestId_++;
+            InvokeRequest request(call.method, call.data, requestId);
+            request.SetPriority(call.priority);
+            if (call.hasBinary) {
+                // records_ outlives the replay
+                request.SetBinary(BinaryView{reinterpret_cast<const uint8_t*>(call.binary.data()), call.binary.size()},
+                                  nullptr);
+            }
+            pending_[requestId] = Pending{&methods_[call.method], Metrics::NowUs()};
+            requests.push_back(std::move(request));
+        }
+        
+        // UI handlers answer before these return
+        InvokeDispatcher* dispatcher = InvokeDispatcher::GetInstance();
+        if (record.kind == RecordKind::Batch) {
+            dispatcher->DispatchBatch(channel, std::move(requests));
+        } else if (record.kind == RecordKind::Stream) {
+            dispatcher->OpenStream(channel, std::move(requests.front()), record.chunkSize, record.credits);
+        } else {
+            dispatcher->Dispatch(channel, std::move(requests.front()));
+        }
+    }
+    
+    void IssueMore() {
+        // Completions inside Issue() land here again; the outer loop goes on
+        if (issuing_) {
+            return;
+        }
+        issuing_ = true;
+        while (next_ < records_.size() && pending_.size() < static_cast<size_t>(options_.concurrency)) {
+            Issue(next_++);
+        }
+        issuing_ = false;
+    }
+    
+    const ReplayOptions& options_;
+    std::vector<RecordedRequest> records_;
+    std::map<std::pair<int, std::string>, std::shared_ptr<ReplayChannel>> channels_;
+    std::map<std::string, ReplayMethod> methods_;
+    std::unordered_map<int, Pending> pending_;
+    LatencyHistogram issueLag_;
+    int nextRequestId_ = 1;
+    size_t next_ = 0;
+    size_t calls_ = 0;
+    size_t completed_ = 0;
+    bool issuing_ = false;
+    double seconds_ = 0.0;
+    std::promise<void> done_;
+};
+
+void ReplayChannel::SendResponse(const InvokeResponse& response) {
+    run_.Complete(response.GetRequestId(), response.IsSuccess(), response.GetErrorCode());
+}
+
+void ReplayChannel::SendStreamMessage(int streamId, StreamEvent event, const std::string*,
+                                      bool, const std::string&, int code) {
+    // Chunks are consumed as they come; a stream counts as one call
+    if (event == StreamEvent::Chunk) {
+        InvokeDispatcher::GetInstance()->AckStream(sessionId_, clientKey_, streamId, 1);
+    } else {
+        run_.Complete(streamId, event == StreamEvent::End, code);
+    }
+}
+
+int RunReplay(const std::string& path, const ReplayOptions& options) {
+    // Read up front, so disk reads do not disturb the pacing
+    InvokeLogReader reader;
+    std::string error;
+    if (!reader.Open(path, &error)) {
+        std::fprintf(stderr, "invokehost: %s\n", error.c_str());
+        return 1;
+    }
+    std::vector<RecordedRequest> records;
+    RecordedRequest record;
+    while (reader.Next(record)) {
+        records.push_back(std::move(record));
+        record = RecordedRequest();
+    }
+    if (!reader.GetError().empty()) {
+        // The app may have stopped mid-write; replay what is intact
+        std::fprintf(stderr, "invokehost: %s after record %zu; replaying those\n",
+                     reader.GetError().c_str(), records.size());
+    }
+    
+    ReplayRun run(options, std::move(records));
+    run.Run();
+    run.Print(path);
+    return 0;
+}
+
+// Rewrites path only when the bindings changed, so an unchanged build does
+// not touch the renderer sources
+int RunTypeScript(const std::string& path, bool check) {
+    const std::string generated = TypedSchema::GetInstance()->ToTypeScript();
+    
+    std::string current;
+    std::ifstream in(path, std::ios::binary);
+    if (in) {
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        current = buffer.str();
+    }
+    in.close();
+    
+    if (current == generated) {
+        return 0;
+    }
+    if (check) {
+        std::fprintf(stderr, "invokehost: %s is out of date; build the mikoview_typescript target\n", path.c_str());
+        return 1;
+    }
+    
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << generated;
+    if (!out) {
+        std::fprintf(stderr, "invokehost: cannot write %s\n", path.c_str());
+        return 1;
+    }
+    std::printf("wrote %s\n", path.c_str());
+    return 0;
+}
+
+#if !defined(_WIN32)
+
+int RunServe(const std::string& path) {
+    UnixSocketServer server(path);
+    std::string error;
+    if (!server.Start(&error)) {
+        std::fprintf(stderr, "invokehost: %s\n", error.c_str());
+        return 1;
+    }
+    
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    std::printf("serving on %s\n", path.c_str());
+    std::fflush(stdout);
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    server.Stop();
+    return 0;
+}
+
+// Same closed loop as RunBench, with the sends on this thread and the
+// receives on another
+int RunDrive(const std::string& path, const Options& options) {
+    UnixSocketClient client;
+    std::string error;
+    if (!client.Connect(path, &error)) {
+        std::fprintf(stderr, "invokehost: %s\n", error.c_str());
+        return 1;
+    }
+    
+    Result result;
+    std::vector<uint64_t> sentAt(options.calls + 1, 0);
+    std::mutex mutex;
+    std::condition_variable slotFree;
+    int outstanding = 0;
+    
+    const auto begin = std::chrono::steady_clock::now();
+    std::thread receiver([&]() {
+        SocketHeader header;
+        std::string body;
+        for (int received = 0; received < options.calls && client.Receive(header, body); ) {
+            if (header.type != "response" || header.id <= 0 || header.id > options.calls) {
+                continue;
+            }
+            result.latency.Record(Metrics::NowUs() - sentAt[header.id]);
+            if (!header.success) {
+                ++result.errors;
+            }
+            ++received;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --outstanding;
+            }
+            slotFree.notify_one();
+        }
+    });
+    
+    for (int id = 1; id <= options.calls; ++id) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            slotFree.wait(lock, [&]() { return outstanding < options.concurrency; });
+            ++outstanding;
+        }
+        sentAt[id] = Metrics::NowUs();
+        if (!client.SendInvoke(id, options.method, options.data)) {
+            std::fprintf(stderr, "invokehost: connection closed\n");
+            client.Close();
+            receiver.join();
+            return 1;
+        }
+    }
+    receiver.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    client.Close();
+    
+    PrintResult("socket", options, result);
+    return result.errors == 0 ? 0 : 1;
+}
+
+#endif // !_WIN32
+
+} // namespace
+
+// Counting replacements; the array and nothrow forms forward to these
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    std::free(block);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        PrintUsage();
+        return 2;
+    }
+    
+    const std::string mode = argv[1];
+    Options options;
+    EventOptions eventOptions;
+    ReplayOptions replayOptions;
+    int status = 2;
+    
+    if (mode == "bench" && ParseOptions(argc, argv, 2, options)) {
+        RegisterHandlers();
+        status = StartRecording(options) ? RunBench(options) : 1;
+    } else if (mode == "fsread" && argc >= 3 && ParseOptions(argc, argv, 3, options)) {
+        RegisterHandlers();
+        status = RunFileRead(argv[2], options);
+    } else if (mode == "events" && ParseEventOptions(argc, argv, 2, eventOptions)) {
+        EventHub::RegisterStressHandler();
+        status = RunEvents(eventOptions);
+    } else if (mode == "replay" && argc >= 3 && ParseReplayOptions(argc, argv, 3, replayOptions)) {
+        RegisterHandlers();
+        status = RunReplay(argv[2], replayOptions);
+    } else if (mode == "typescript" && (argc == 3 || (argc == 4 && std::string(argv[3]) == "--check"))) {
+        RegisterHandlers();
+        status = RunTypeScript(argv[2], argc == 4);
+    }
+#if !defined(_WIN32)
+    else if (mode == "serve" && argc >= 3 && ParseOptions(argc, argv, 3, options)) {
+        RegisterHandlers();
+        status = StartRecording(options) ? RunServe(argv[2]) : 1;
+    } else if (mode == "drive" && argc >= 3 && ParseOptions(argc, argv, 3, options)) {
+        status = RunDrive(argv[2], options);
+    }
+#endif
+    else {
+        PrintUsage();
+    }
+    
+    Executor::GetInstance()->Shutdown();
+    InvokeDispatcher::GetInstance()->StopRecording();
+    return status;
+}
\ No newline at end of file